@@ -0,0 +1,415 @@
+#include "BoxBox.h"
+
+// Axes 0-2 are the faces of the first box, 3-5 the faces of the second one and 6-14 the edge pairs, 6 + 3 * i + j
+constexpr uint32_t BOX_BOX_AXIS_COUNT = 15;
+constexpr uint32_t BOX_BOX_FIRST_EDGE_AXIS = 6;
+
+// An axis replaces a preferred one only when it is clearly better, so that the manifold doesn't flip between equivalent axes
+constexpr float BOX_BOX_RELATIVE_TOLERANCE = 0.95f;
+constexpr float BOX_BOX_ABSOLUTE_TOLERANCE = 0.001f;
+
+// Cross products of nearly parallel edges are no axis, the face axes already cover them
+constexpr float BOX_BOX_PARALLEL_EPSILON = 0.00001f;
+
+// Incident face clipped by the 4 side planes of the reference face
+constexpr size_t BOX_BOX_MAX_CLIPPED_POINTS = 8;
+
+struct BoxBoxFrame
+{
+	XMVECTOR center;
+	XMVECTOR axes[3];
+	float halfExtents[3];
+};
+
+struct BoxBoxClipPoint
+{
+	XMVECTOR point;
+	uint32_t featureId;
+};
+
+static void getBoxFrame(const Collider* collider, BoxBoxFrame* frame)
+{
+	XMMATRIX rotation = XMMatrixRotationQuaternion(collider->rotation);
+	frame->center = collider->position;
+	frame->axes[0] = rotation.r[0];
+	frame->axes[1] = rotation.r[1];
+	frame->axes[2] = rotation.r[2];
+
+	XMFLOAT3 halfExtents;
+	XMStoreFloat3(&halfExtents, collider->box.halfExtents);
+	frame->halfExtents[0] = halfExtents.x;
+	frame->halfExtents[1] = halfExtents.y;
+	frame->halfExtents[2] = halfExtents.z;
+}
+
+static XMVECTOR getAxis(const BoxBoxFrame* box1, const BoxBoxFrame* box2, uint32_t axis)
+{
+	if (axis < 3)
+	{
+		return box1->axes[axis];
+	}
+	if (axis < BOX_BOX_FIRST_EDGE_AXIS)
+	{
+		return box2->axes[axis - 3];
+	}
+
+	uint32_t edgeAxis = axis - BOX_BOX_FIRST_EDGE_AXIS;
+	return XMVector3Cross(box1->axes[edgeAxis / 3], box2->axes[edgeAxis % 3]);
+}
+
+// Separation along a single axis, used to try the cached axis before the full test
+static float getAxisSeparation(const BoxBoxFrame* box1, const BoxBoxFrame* box2, XMVECTOR axis)
+{
+	float lengthSquared = XMVectorGetX(XMVector3LengthSq(axis));
+	if (lengthSquared < BOX_BOX_PARALLEL_EPSILON)
+	{
+		return -FLT_MAX;
+	}
+
+	float distance = fabsf(XMVectorGetX(XMVector3Dot(box2->center - box1->center, axis)));
+	float radius1 = 0.0f;
+	float radius2 = 0.0f;
+	for (size_t i = 0; i < 3; ++i)
+	{
+		radius1 += box1->halfExtents[i] * fabsf(XMVectorGetX(XMVector3Dot(box1->axes[i], axis)));
+		radius2 += box2->halfExtents[i] * fabsf(XMVectorGetX(XMVector3Dot(box2->axes[i], axis)));
+	}
+
+	return (distance - radius1 - radius2) / sqrtf(lengthSquared);
+}
+
+// Separation along the 15 axes, computed 3 at a time in the frame of the first box (Gottschalk's OBB test)
+static void getSeparations(const BoxBoxFrame* box1, const BoxBoxFrame* box2, float separations[BOX_BOX_AXIS_COUNT])
+{
+	XMMATRIX rotation1 = XMMATRIX(box1->axes[0], box1->axes[1], box1->axes[2], XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f));
+	XMMATRIX rotation2 = XMMATRIX(box2->axes[0], box2->axes[1], box2->axes[2], XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f));
+
+	// r[i][j] = a_i . b_j, and the distance between the centers along the axes of the first box
+	XMMATRIX r = XMMatrixMultiply(rotation1, XMMatrixTranspose(rotation2));
+	XMVECTOR epsilon = XMVectorReplicate(BOX_BOX_PARALLEL_EPSILON);
+	XMMATRIX absR = XMMATRIX(XMVectorAbs(r.r[0]) + epsilon, XMVectorAbs(r.r[1]) + epsilon, XMVectorAbs(r.r[2]) + epsilon, XMVectorZero());
+	XMVECTOR t = XMVector3TransformNormal(box2->center - box1->center, XMMatrixTranspose(rotation1));
+	XMVECTOR e1 = XMVectorSet(box1->halfExtents[0], box1->halfExtents[1], box1->halfExtents[2], 0.0f);
+	XMVECTOR e2 = XMVectorSet(box2->halfExtents[0], box2->halfExtents[1], box2->halfExtents[2], 0.0f);
+
+	XMFLOAT4 lanes;
+
+	// Faces of the first box
+	XMVECTOR faces1 = XMVectorAbs(t) - e1 - XMVector3TransformNormal(e2, XMMatrixTranspose(absR));
+	XMStoreFloat4(&lanes, faces1);
+	separations[0] = lanes.x;
+	separations[1] = lanes.y;
+	separations[2] = lanes.z;
+
+	// Faces of the second box
+	XMVECTOR faces2 = XMVectorAbs(XMVector3TransformNormal(t, r)) - e2 - XMVector3TransformNormal(e1, absR);
+	XMStoreFloat4(&lanes, faces2);
+	separations[3] = lanes.x;
+	separations[4] = lanes.y;
+	separations[5] = lanes.z;
+
+	// Edge i of the first box against the 3 edges of the second one
+	float t_[3] = { XMVectorGetX(t), XMVectorGetY(t), XMVectorGetZ(t) };
+	float e1_[3] = { box1->halfExtents[0], box1->halfExtents[1], box1->halfExtents[2] };
+	XMVECTOR e2YZX = XMVectorSwizzle<1, 2, 0, 3>(e2);
+	XMVECTOR e2ZXY = XMVectorSwizzle<2, 0, 1, 3>(e2);
+	for (size_t i = 0; i < 3; ++i)
+	{
+		size_t i1 = (i + 1) % 3;
+		size_t i2 = (i + 2) % 3;
+
+		XMVECTOR distance = XMVectorAbs(t_[i2] * r.r[i1] - t_[i1] * r.r[i2]);
+		XMVECTOR radius1 = e1_[i1] * absR.r[i2] + e1_[i2] * absR.r[i1];
+		XMVECTOR radius2 = e2YZX * XMVectorSwizzle<2, 0, 1, 3>(absR.r[i]) + e2ZXY * XMVectorSwizzle<1, 2, 0, 3>(absR.r[i]);
+
+		// |a_i x b_j|^2 = 1 - (a_i . b_j)^2
+		XMVECTOR lengthSquared = XMVectorReplicate(1.0f) - r.r[i] * r.r[i];
+		XMVECTOR separation = (distance - radius1 - radius2) / XMVectorSqrt(XMVectorMax(lengthSquared, epsilon));
+		separation = XMVectorSelect(separation, XMVectorReplicate(-FLT_MAX), XMVectorLess(lengthSquared, epsilon));
+
+		XMStoreFloat4(&lanes, separation);
+		separations[BOX_BOX_FIRST_EDGE_AXIS + 3 * i] = lanes.x;
+		separations[BOX_BOX_FIRST_EDGE_AXIS + 3 * i + 1] = lanes.y;
+		separations[BOX_BOX_FIRST_EDGE_AXIS + 3 * i + 2] = lanes.z;
+	}
+}
+
+static bool isAxisPreferable(float separation, float preferredSeparation)
+{
+	return preferredSeparation + (1.0f - BOX_BOX_RELATIVE_TOLERANCE) * fabsf(preferredSeparation) + BOX_BOX_ABSOLUTE_TOLERANCE < separation;
+}
+
+// Face axes are preferred over edge axes, and the cached axis over any axis that is only slightly better
+static uint32_t selectAxis(const float separations[BOX_BOX_AXIS_COUNT], const BoxBoxCache* cache)
+{
+	uint32_t faceAxis1 = 0;
+	for (uint32_t i = 1; i < 3; ++i)
+	{
+		if (separations[faceAxis1] < separations[i])
+		{
+			faceAxis1 = i;
+		}
+	}
+
+	uint32_t faceAxis2 = 3;
+	for (uint32_t i = 4; i < BOX_BOX_FIRST_EDGE_AXIS; ++i)
+	{
+		if (separations[faceAxis2] < separations[i])
+		{
+			faceAxis2 = i;
+		}
+	}
+
+	uint32_t edgeAxis = BOX_BOX_FIRST_EDGE_AXIS;
+	for (uint32_t i = BOX_BOX_FIRST_EDGE_AXIS + 1; i < BOX_BOX_AXIS_COUNT; ++i)
+	{
+		if (separations[edgeAxis] < separations[i])
+		{
+			edgeAxis = i;
+		}
+	}
+
+	uint32_t axis = true == isAxisPreferable(separations[faceAxis2], separations[faceAxis1]) ? faceAxis2 : faceAxis1;
+	if (true == isAxisPreferable(separations[edgeAxis], separations[axis]))
+	{
+		axis = edgeAxis;
+	}
+
+	if (nullptr != cache && true == cache->bValid && cache->axis != axis &&
+		false == isAxisPreferable(separations[axis], separations[cache->axis]))
+	{
+		axis = cache->axis;
+	}
+
+	return axis;
+}
+
+static size_t clipPolygon(const BoxBoxClipPoint* input, size_t numInput, XMVECTOR planeNormal, float planeOffset, uint32_t planeIndex,
+	BoxBoxClipPoint* output)
+{
+	size_t numOutput = 0;
+	for (size_t i = 0; i < numInput; ++i)
+	{
+		const BoxBoxClipPoint* start = &input[(i + numInput - 1) % numInput];
+		const BoxBoxClipPoint* end = &input[i];
+		float startDistance = XMVectorGetX(XMVector3Dot(planeNormal, start->point)) - planeOffset;
+		float endDistance = XMVectorGetX(XMVector3Dot(planeNormal, end->point)) - planeOffset;
+
+		if ((startDistance <= 0.0f) != (endDistance <= 0.0f))
+		{
+			BoxBoxClipPoint intersection;
+			intersection.point = start->point + (startDistance / (startDistance - endDistance)) * (end->point - start->point);
+			intersection.featureId = 4 + 4 * planeIndex + (start->featureId & 3);
+			output[numOutput++] = intersection;
+		}
+
+		if (endDistance <= 0.0f)
+		{
+			output[numOutput++] = *end;
+		}
+	}
+
+	return numOutput;
+}
+
+// referenceNormal is the normal of the reference face, pointing towards the incident box
+static void getFaceContacts(const BoxBoxFrame* reference, const BoxBoxFrame* incident, uint32_t referenceAxis, XMVECTOR referenceNormal,
+	bool bIsFirstReference, float speculativeDistance, PBDArenaVector<ColliderContact>& contacts)
+{
+	bool bIsReferenceNegative = XMVectorGetX(XMVector3Dot(referenceNormal, reference->axes[referenceAxis])) < 0.0f;
+	uint32_t referenceFace = 2 * referenceAxis + (true == bIsReferenceNegative ? 1 : 0);
+	float referenceOffset = XMVectorGetX(XMVector3Dot(referenceNormal, reference->center)) + reference->halfExtents[referenceAxis];
+
+	// Incident face is the most antiparallel one to the reference face
+	uint32_t incidentAxis = 0;
+	float maxDot = -1.0f;
+	for (uint32_t i = 0; i < 3; ++i)
+	{
+		float dot = fabsf(XMVectorGetX(XMVector3Dot(incident->axes[i], referenceNormal)));
+		if (maxDot < dot)
+		{
+			maxDot = dot;
+			incidentAxis = i;
+		}
+	}
+
+	bool bIsIncidentNegative = 0.0f < XMVectorGetX(XMVector3Dot(incident->axes[incidentAxis], referenceNormal));
+	uint32_t incidentFace = 2 * incidentAxis + (true == bIsIncidentNegative ? 1 : 0);
+
+	uint32_t u = (incidentAxis + 1) % 3;
+	uint32_t v = (incidentAxis + 2) % 3;
+	XMVECTOR incidentCenter = incident->center +
+		(true == bIsIncidentNegative ? -incident->halfExtents[incidentAxis] : incident->halfExtents[incidentAxis]) * incident->axes[incidentAxis];
+	XMVECTOR incidentU = incident->halfExtents[u] * incident->axes[u];
+	XMVECTOR incidentV = incident->halfExtents[v] * incident->axes[v];
+
+	BoxBoxClipPoint polygon1[BOX_BOX_MAX_CLIPPED_POINTS];
+	BoxBoxClipPoint polygon2[BOX_BOX_MAX_CLIPPED_POINTS];
+	polygon1[0] = { incidentCenter + incidentU + incidentV, 0 };
+	polygon1[1] = { incidentCenter - incidentU + incidentV, 1 };
+	polygon1[2] = { incidentCenter - incidentU - incidentV, 2 };
+	polygon1[3] = { incidentCenter + incidentU - incidentV, 3 };
+	size_t numPoints = 4;
+
+	// Side planes of the reference face
+	uint32_t sideAxes[2] = { (referenceAxis + 1) % 3, (referenceAxis + 2) % 3 };
+	BoxBoxClipPoint* input = polygon1;
+	BoxBoxClipPoint* output = polygon2;
+	for (uint32_t i = 0; i < 4 && 0 < numPoints; ++i)
+	{
+		uint32_t sideAxis = sideAxes[i / 2];
+		XMVECTOR planeNormal = 0 == (i & 1) ? reference->axes[sideAxis] : -reference->axes[sideAxis];
+		float planeOffset = XMVectorGetX(XMVector3Dot(planeNormal, reference->center)) + reference->halfExtents[sideAxis];
+
+		numPoints = clipPolygon(input, numPoints, planeNormal, planeOffset, i, output);
+
+		BoxBoxClipPoint* temp = input;
+		input = output;
+		output = temp;
+	}
+
+	// Points below the reference face
+	ColliderContactFeatureType featureType = true == bIsFirstReference ? ColliderContactFeatureType::FACE1_REFERENCE : ColliderContactFeatureType::FACE2_REFERENCE;
+	size_t firstContact = contacts.size();
+	for (size_t i = 0; i < numPoints; ++i)
+	{
+		float separation = XMVectorGetX(XMVector3Dot(referenceNormal, input[i].point)) - referenceOffset;
+		if (speculativeDistance <= separation)
+		{
+			continue;
+		}
+
+		XMVECTOR incidentPoint = input[i].point;
+		XMVECTOR referencePoint = incidentPoint - separation * referenceNormal;
+
+		ColliderContact contact;
+		contact.collision_point1 = true == bIsFirstReference ? referencePoint : incidentPoint;
+		contact.collision_point2 = true == bIsFirstReference ? incidentPoint : referencePoint;
+		contact.collision_normal = true == bIsFirstReference ? referenceNormal : -referenceNormal;
+		contact.feature_id = MakeColliderContactFeatureId(featureType, referenceFace, incidentFace, input[i].featureId);
+
+		contacts.push_back(contact);
+	}
+
+	ReduceColliderContacts(contacts, firstContact);
+}
+
+// Edge of the box along the given axis that is the furthest in the direction
+static XMVECTOR getSupportEdgeCenter(const BoxBoxFrame* box, uint32_t axis, XMVECTOR direction, uint32_t* edgeId)
+{
+	XMVECTOR center = box->center;
+	*edgeId = 4 * axis;
+	for (uint32_t i = 1; i < 3; ++i)
+	{
+		uint32_t k = (axis + i) % 3;
+		if (XMVectorGetX(XMVector3Dot(direction, box->axes[k])) < 0.0f)
+		{
+			center -= box->halfExtents[k] * box->axes[k];
+			*edgeId += i;
+		}
+		else
+		{
+			center += box->halfExtents[k] * box->axes[k];
+		}
+	}
+
+	return center;
+}
+
+// normal points from the first box to the second one
+static void getEdgeContact(const BoxBoxFrame* box1, const BoxBoxFrame* box2, uint32_t edgeAxis, XMVECTOR normal,
+	PBDArenaVector<ColliderContact>& contacts)
+{
+	uint32_t axis1 = edgeAxis / 3;
+	uint32_t axis2 = edgeAxis % 3;
+
+	uint32_t edge1Id;
+	uint32_t edge2Id;
+	XMVECTOR center1 = getSupportEdgeCenter(box1, axis1, normal, &edge1Id);
+	XMVECTOR center2 = getSupportEdgeCenter(box2, axis2, -normal, &edge2Id);
+	XMVECTOR direction1 = box1->axes[axis1];
+	XMVECTOR direction2 = box2->axes[axis2];
+
+	// Closest points of the two edge lines, clamped to the edges
+	XMVECTOR r = center1 - center2;
+	float c = XMVectorGetX(XMVector3Dot(direction1, direction2));
+	float d1 = XMVectorGetX(XMVector3Dot(direction1, r));
+	float d2 = XMVectorGetX(XMVector3Dot(direction2, r));
+	float denominator = 1.0f - c * c;
+	float s1 = BOX_BOX_PARALLEL_EPSILON < denominator ? (c * d2 - d1) / denominator : 0.0f;
+	s1 = fminf(fmaxf(s1, -box1->halfExtents[axis1]), box1->halfExtents[axis1]);
+	float s2 = fminf(fmaxf(d2 + s1 * c, -box2->halfExtents[axis2]), box2->halfExtents[axis2]);
+
+	// Clamping s2 moves the closest point of the first edge, so s1 is found again from it
+	s1 = fminf(fmaxf(s2 * c - d1, -box1->halfExtents[axis1]), box1->halfExtents[axis1]);
+
+	ColliderContact contact;
+	contact.collision_point1 = center1 + s1 * direction1;
+	contact.collision_point2 = center2 + s2 * direction2;
+	contact.collision_normal = normal;
+	contact.feature_id = MakeColliderContactFeatureId(ColliderContactFeatureType::EDGE_EDGE, edge1Id, edge2Id, 0);
+
+	contacts.push_back(contact);
+}
+
+void GetBoxBoxContacts(Collider* collider1, Collider* collider2, BoxBoxCache* cache, float speculativeDistance,
+	PBDArenaVector<ColliderContact>& contacts)
+{
+	assert(collider1->type == ColliderType::BOX);
+	assert(collider2->type == ColliderType::BOX);
+
+	BoxBoxFrame box1;
+	BoxBoxFrame box2;
+	getBoxFrame(collider1, &box1);
+	getBoxFrame(collider2, &box2);
+
+	// A pair separated along its last axis is rejected without the full test
+	if (nullptr != cache && true == cache->bValid &&
+		speculativeDistance < getAxisSeparation(&box1, &box2, getAxis(&box1, &box2, cache->axis)))
+	{
+		return;
+	}
+
+	float separations[BOX_BOX_AXIS_COUNT];
+	getSeparations(&box1, &box2, separations);
+
+	uint32_t axis = selectAxis(separations, cache);
+	if (nullptr != cache)
+	{
+		cache->axis = axis;
+		cache->bValid = true;
+	}
+
+	// Any axis with a larger separation would have been selected, but the preferred axes may be slightly shallower than the best one
+	for (uint32_t i = 0; i < BOX_BOX_AXIS_COUNT; ++i)
+	{
+		if (speculativeDistance < separations[i])
+		{
+			if (nullptr != cache)
+			{
+				cache->axis = i;
+			}
+			return;
+		}
+	}
+
+	XMVECTOR centerDistance = box2.center - box1.center;
+	XMVECTOR normal = XMVector3Normalize(getAxis(&box1, &box2, axis));
+	if (XMVectorGetX(XMVector3Dot(normal, centerDistance)) < 0.0f)
+	{
+		normal = -normal;
+	}
+
+	if (axis < 3)
+	{
+		getFaceContacts(&box1, &box2, axis, normal, true, speculativeDistance, contacts);
+	}
+	else if (axis < BOX_BOX_FIRST_EDGE_AXIS)
+	{
+		getFaceContacts(&box2, &box1, axis - 3, -normal, false, speculativeDistance, contacts);
+	}
+	else
+	{
+		getEdgeContact(&box1, &box2, axis - BOX_BOX_FIRST_EDGE_AXIS, normal, contacts);
+	}
+}
\ No newline at end of file
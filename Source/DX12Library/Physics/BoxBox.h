@@ -0,0 +1,17 @@
+#pragma once
+
+#include "Collider.h"
+
+// Separating axis found last for a pair of boxes.
+// A separated pair usually stays separated along it, an overlapping one keeps it as long as it's nearly the best axis.
+struct BoxBoxCache
+{
+	uint32_t axis;
+	bool bValid;
+};
+
+// Separating axis test of two BOX colliders over the 15 face and edge axes, followed by a manifold of up to 4 contacts:
+// the incident face clipped against the reference face, or the closest points of the two edges.
+// cache may be nullptr
+void GetBoxBoxContacts(Collider* collider1, Collider* collider2, BoxBoxCache* cache, float speculativeDistance,
+	PBDArenaVector<ColliderContact>& contacts);
\ No newline at end of file
@@ -1,28 +1,194 @@
 #include "Broad.h"
 
-void GetBroadCollisionPairs(std::unordered_map<size_t, std::shared_ptr<DX12Library::RigidBodyShape>>& shapes, std::vector<BroadCollisionPair>& out)
+static bool isBoundingSphereOverlapping(const PBDBodyStore& bodies, size_t s1, size_t s2, float margin)
+{
+	float shapeDistanceSq = XMVectorGetX(XMVector3LengthSq(bodies.positions[s1] - bodies.positions[s2]));
+	float maxDistanceForCollision = bodies.boundingSphereRadii[s1] + bodies.boundingSphereRadii[s2] + margin;
+
+	return shapeDistanceSq <= maxDistanceForCollision * maxDistanceForCollision;
+}
+
+static void getBoundingSpherePairs(const PBDBroadphase& broadphase, const PBDBodyStore& bodies, PBDArenaVector<BroadCollisionPair>& out)
 {
 	BroadCollisionPair pair;
 
-	std::unordered_map<size_t, std::shared_ptr<DX12Library::RigidBodyShape>>::iterator shape;
-	std::unordered_map<size_t, std::shared_ptr<DX12Library::RigidBodyShape>>::iterator otherShape;
-	for (shape = shapes.begin(); shape != shapes.end(); ++shape)
+	size_t numBodies = GetPBDBodyCount(bodies);
+	for (size_t i = 0; i < numBodies; ++i)
 	{
-		std::shared_ptr<DX12Library::RigidBodyShape> s1 = shape->second;
-		otherShape = shape;
-		++otherShape;
-		for (; otherShape != shapes.end(); ++otherShape)
+		for (size_t j = i + 1; j < numBodies; ++j)
 		{
-			std::shared_ptr<DX12Library::RigidBodyShape> s2 = otherShape->second;
-
-			float shapeDistanceSq = XMVectorGetX(XMVector3LengthSq(s1->worldPosition - s2->worldPosition));
-			float maxDistanceForCollision = s1->boundingSphereRadius + s2->boundingSphereRadius + 0.1f;
-			if (shapeDistanceSq <= maxDistanceForCollision * maxDistanceForCollision)
+			if (true == isBoundingSphereOverlapping(bodies, i, j, broadphase.margin))
 			{
-				pair.s1_id = shape->first;
-				pair.s2_id = otherShape->first;
+				pair.s1_id = bodies.slotToHandle[i];
+				pair.s2_id = bodies.slotToHandle[j];
 				out.push_back(pair);
 			}
 		}
 	}
+}
+
+// Brings the proxies in line with the bodies added, removed and moved since the last step
+static void updateAABBTreeProxies(PBDBroadphase& broadphase, const PBDBodyStore& bodies, float dt)
+{
+	DynamicAABBTree& tree = broadphase.aabbTree;
+	std::vector<int32_t>& proxies = broadphase.aabbTreeProxies;
+
+	if (proxies.size() < bodies.handleToSlot.size())
+	{
+		proxies.resize(bodies.handleToSlot.size(), AABB_TREE_NULL_NODE);
+	}
+
+	for (size_t handle = 0; handle < proxies.size(); ++handle)
+	{
+		bool bAlive = handle < bodies.handleToSlot.size() && SIZE_MAX != bodies.handleToSlot[handle];
+		if (false == bAlive)
+		{
+			if (AABB_TREE_NULL_NODE != proxies[handle])
+			{
+				DestroyDynamicAABBTreeProxy(tree, proxies[handle]);
+				proxies[handle] = AABB_TREE_NULL_NODE;
+			}
+			continue;
+		}
+
+		// Half of the margin on each box keeps every pair within the margin inside overlapping fat boxes
+		size_t slot = bodies.handleToSlot[handle];
+		AABB aabb = MakeAABB(bodies.positions[slot], bodies.boundingSphereRadii[slot]);
+		float fatMargin = 0.5f * broadphase.margin;
+
+		if (AABB_TREE_NULL_NODE == proxies[handle])
+		{
+			proxies[handle] = CreateDynamicAABBTreeProxy(tree, aabb, fatMargin, handle);
+		}
+		else
+		{
+			MoveDynamicAABBTreeProxy(tree, proxies[handle], aabb, fatMargin, dt * bodies.linearVelocities[slot]);
+		}
+	}
+}
+
+static void getAABBTreePairs(PBDBroadphase& broadphase, const PBDBodyStore& bodies, float dt, PBDArenaVector<BroadCollisionPair>& out)
+{
+	updateAABBTreeProxies(broadphase, bodies, dt);
+
+	PBDArenaVector<std::pair<int32_t, int32_t>> proxyPairs;
+	GetDynamicAABBTreePairs(broadphase.aabbTree, proxyPairs);
+
+	BroadCollisionPair pair;
+	for (size_t i = 0; i < proxyPairs.size(); ++i)
+	{
+		size_t handle1 = GetDynamicAABBTreeUserData(broadphase.aabbTree, proxyPairs[i].first);
+		size_t handle2 = GetDynamicAABBTreeUserData(broadphase.aabbTree, proxyPairs[i].second);
+
+		// Fat boxes are conservative, keep the same pairs as the bounding sphere test
+		if (true == isBoundingSphereOverlapping(bodies, bodies.handleToSlot[handle1], bodies.handleToSlot[handle2], broadphase.margin))
+		{
+			pair.s1_id = handle1;
+			pair.s2_id = handle2;
+			out.push_back(pair);
+		}
+	}
+}
+
+static void updateSweepAndPruneProxies(PBDBroadphase& broadphase, const PBDBodyStore& bodies)
+{
+	SweepAndPrune& sap = broadphase.sweepAndPrune;
+	std::vector<uint32_t>& proxies = broadphase.sweepAndPruneProxies;
+
+	if (proxies.size() < bodies.handleToSlot.size())
+	{
+		proxies.resize(bodies.handleToSlot.size(), SWEEP_AND_PRUNE_NULL_PROXY);
+	}
+
+	for (size_t handle = 0; handle < proxies.size(); ++handle)
+	{
+		bool bAlive = handle < bodies.handleToSlot.size() && SIZE_MAX != bodies.handleToSlot[handle];
+		if (false == bAlive)
+		{
+			if (SWEEP_AND_PRUNE_NULL_PROXY != proxies[handle])
+			{
+				DestroySweepAndPruneProxy(sap, proxies[handle]);
+				proxies[handle] = SWEEP_AND_PRUNE_NULL_PROXY;
+			}
+			continue;
+		}
+
+		size_t slot = bodies.handleToSlot[handle];
+		AABB aabb = MakeAABB(bodies.positions[slot], bodies.boundingSphereRadii[slot] + 0.5f * broadphase.margin);
+
+		if (SWEEP_AND_PRUNE_NULL_PROXY == proxies[handle])
+		{
+			proxies[handle] = CreateSweepAndPruneProxy(sap, aabb, handle);
+		}
+		else
+		{
+			SetSweepAndPruneProxyAABB(sap, proxies[handle], aabb);
+		}
+	}
+}
+
+static void getSweepAndPrunePairs(PBDBroadphase& broadphase, const PBDBodyStore& bodies, PBDArenaVector<BroadCollisionPair>& out)
+{
+	updateSweepAndPruneProxies(broadphase, bodies);
+	UpdateSweepAndPrune(broadphase.sweepAndPrune);
+
+	const std::vector<SweepAndPrunePair>& proxyPairs = GetSweepAndPrunePairs(broadphase.sweepAndPrune);
+
+	BroadCollisionPair pair;
+	for (size_t i = 0; i < proxyPairs.size(); ++i)
+	{
+		size_t handle1 = GetSweepAndPruneUserData(broadphase.sweepAndPrune, proxyPairs[i].proxyA);
+		size_t handle2 = GetSweepAndPruneUserData(broadphase.sweepAndPrune, proxyPairs[i].proxyB);
+
+		if (true == isBoundingSphereOverlapping(bodies, bodies.handleToSlot[handle1], bodies.handleToSlot[handle2], broadphase.margin))
+		{
+			pair.s1_id = handle1;
+			pair.s2_id = handle2;
+			out.push_back(pair);
+		}
+	}
+}
+
+static void getSpatialHashPairs(PBDBroadphase& broadphase, const PBDBodyStore& bodies, PBDJobSystem* jobSystem, PBDArenaVector<BroadCollisionPair>& out)
+{
+	size_t numBodies = GetPBDBodyCount(bodies);
+	if (0 == numBodies)
+	{
+		return;
+	}
+
+	BuildSpatialHashGrid(broadphase.spatialHash, bodies.positions.data(), bodies.boundingSphereRadii.data(), numBodies,
+		broadphase.margin, broadphase.oversizedRadiusRatio, jobSystem);
+
+	PBDArenaVector<std::pair<uint32_t, uint32_t>> slotPairs;
+	GetSpatialHashGridPairs(broadphase.spatialHash, bodies.positions.data(), bodies.boundingSphereRadii.data(), numBodies,
+		broadphase.margin, jobSystem, slotPairs);
+
+	BroadCollisionPair pair;
+	for (size_t i = 0; i < slotPairs.size(); ++i)
+	{
+		pair.s1_id = bodies.slotToHandle[slotPairs[i].first];
+		pair.s2_id = bodies.slotToHandle[slotPairs[i].second];
+		out.push_back(pair);
+	}
+}
+
+void GetBroadCollisionPairs(PBDBroadphase& broadphase, const PBDBodyStore& bodies, float dt, PBDJobSystem* jobSystem,
+	PBDArenaVector<BroadCollisionPair>& out)
+{
+	switch (broadphase.type)
+	{
+	case PBDBroadphaseType::BOUNDING_SPHERE:
+		getBoundingSpherePairs(broadphase, bodies, out);
+		break;
+	case PBDBroadphaseType::DYNAMIC_AABB_TREE:
+		getAABBTreePairs(broadphase, bodies, dt, out);
+		break;
+	case PBDBroadphaseType::SWEEP_AND_PRUNE:
+		getSweepAndPrunePairs(broadphase, bodies, out);
+		break;
+	case PBDBroadphaseType::SPATIAL_HASH:
+		getSpatialHashPairs(broadphase, bodies, jobSystem, out);
+		break;
+	}
 }
\ No newline at end of file
@@ -1,6 +1,9 @@
 #pragma once
 
-#include "PBD.h"
+#include "PBDBodyStore.h"
+#include "DynamicAABBTree.h"
+#include "SweepAndPrune.h"
+#include "SpatialHashGrid.h"
 
 struct BroadCollisionPair
 {
@@ -8,4 +11,40 @@ struct BroadCollisionPair
 	size_t s2_id;
 };
 
-void GetBroadCollisionPairs(std::unordered_map<size_t, std::shared_ptr<DX12Library::RigidBodyShape>>& shapes, std::vector<BroadCollisionPair>& out);
\ No newline at end of file
+enum class PBDBroadphaseType
+{
+	// Tests every pair of bodies
+	BOUNDING_SPHERE,
+	// Incremental bounding volume hierarchy over fat AABBs
+	DYNAMIC_AABB_TREE,
+	// Endpoints sorted along the three axes, fixed up by insertion sort as the bodies move
+	SWEEP_AND_PRUNE,
+	// Uniform grid rebuilt every step, for many bodies of about the same size
+	SPATIAL_HASH
+};
+
+// Broadphase state kept by a world between steps
+struct PBDBroadphase
+{
+	PBDBroadphaseType type = PBDBroadphaseType::BOUNDING_SPHERE;
+
+	// Extra distance between the bounding spheres of two bodies for them to be reported as a pair
+	float margin = 0.1f;
+
+	// Dynamic AABB tree, with the proxy of every body handle (AABB_TREE_NULL_NODE when the handle isn't used)
+	DynamicAABBTree aabbTree;
+	std::vector<int32_t> aabbTreeProxies;
+
+	// Sweep and prune, with the proxy of every body handle (SWEEP_AND_PRUNE_NULL_PROXY when the handle isn't used)
+	SweepAndPrune sweepAndPrune;
+	std::vector<uint32_t> sweepAndPruneProxies;
+
+	// Spatial hash, bodies larger than oversizedRadiusRatio times the average radius are handled apart from the grid
+	SpatialHashGrid spatialHash;
+	float oversizedRadiusRatio = 4.0f;
+};
+
+// dt is the duration of the coming step, used to extend the boxes of moving bodies.
+// jobSystem may be nullptr, otherwise the broadphases that support it spread their work over its threads.
+void GetBroadCollisionPairs(PBDBroadphase& broadphase, const PBDBodyStore& bodies, float dt, PBDJobSystem* jobSystem,
+	PBDArenaVector<BroadCollisionPair>& out);
\ No newline at end of file
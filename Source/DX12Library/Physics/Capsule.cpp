@@ -0,0 +1,318 @@
+#include "Capsule.h"
+#include "GJK.h"
+#include "EPA.h"
+#include "Support.h"
+
+// Capsules closer to parallel than this get a contact at both ends of their overlap, so that they can rest on each other
+constexpr float CAPSULE_PARALLEL_EPSILON = 0.001f;
+
+// A segment lies on a hull face when the face is within about 10 degrees of the contact normal and the segment within about 5 degrees of the face
+constexpr float CAPSULE_FACE_MIN_COSINE = 0.985f;
+constexpr float CAPSULE_FACE_MAX_SINE = 0.09f;
+
+static void getCapsuleSegment(const Collider* capsule, XMVECTOR* start, XMVECTOR* end)
+{
+	*start = GetColliderWorldPoint(capsule, XMVectorSet(0.0f, -capsule->capsule.halfHeight, 0.0f, 0.0f));
+	*end = GetColliderWorldPoint(capsule, XMVectorSet(0.0f, capsule->capsule.halfHeight, 0.0f, 0.0f));
+}
+
+static XMVECTOR getClosestPointOnSegment(FXMVECTOR point, FXMVECTOR start, FXMVECTOR end)
+{
+	XMVECTOR segment = end - start;
+	float lengthSquared = XMVectorGetX(XMVector3LengthSq(segment));
+	if (lengthSquared < FLT_EPSILON)
+	{
+		return start;
+	}
+
+	float t = XMVectorGetX(XMVector3Dot(point - start, segment)) / lengthSquared;
+	return start + fminf(fmaxf(t, 0.0f), 1.0f) * segment;
+}
+
+// Closest points of the segments p1q1 and p2q2 (Ericson, Real-Time Collision Detection 5.1.9)
+static void getClosestPointsOfSegments(FXMVECTOR p1, FXMVECTOR q1, FXMVECTOR p2, GXMVECTOR q2, XMVECTOR* c1, XMVECTOR* c2)
+{
+	XMVECTOR d1 = q1 - p1;
+	XMVECTOR d2 = q2 - p2;
+	XMVECTOR r = p1 - p2;
+	float a = XMVectorGetX(XMVector3LengthSq(d1));
+	float e = XMVectorGetX(XMVector3LengthSq(d2));
+	float f = XMVectorGetX(XMVector3Dot(d2, r));
+
+	float s = 0.0f;
+	float t = 0.0f;
+	if (a < FLT_EPSILON && e < FLT_EPSILON)
+	{
+		*c1 = p1;
+		*c2 = p2;
+		return;
+	}
+
+	if (a < FLT_EPSILON)
+	{
+		t = fminf(fmaxf(f / e, 0.0f), 1.0f);
+	}
+	else
+	{
+		float c = XMVectorGetX(XMVector3Dot(d1, r));
+		if (e < FLT_EPSILON)
+		{
+			s = fminf(fmaxf(-c / a, 0.0f), 1.0f);
+		}
+		else
+		{
+			float b = XMVectorGetX(XMVector3Dot(d1, d2));
+			float denominator = a * e - b * b;
+			if (FLT_EPSILON < denominator)
+			{
+				s = fminf(fmaxf((b * f - c * e) / denominator, 0.0f), 1.0f);
+			}
+
+			t = (b * s + f) / e;
+			if (t < 0.0f)
+			{
+				t = 0.0f;
+				s = fminf(fmaxf(-c / a, 0.0f), 1.0f);
+			}
+			else if (1.0f < t)
+			{
+				t = 1.0f;
+				s = fminf(fmaxf((b - c) / a, 0.0f), 1.0f);
+			}
+		}
+	}
+
+	*c1 = p1 + s * d1;
+	*c2 = p2 + t * d2;
+}
+
+// Contact between two points of the cores, each pushed out by its radius along the line between them
+static bool addCoreContact(FXMVECTOR core1, FXMVECTOR core2, float radius1, float radius2, FXMVECTOR fallbackNormal, float speculativeDistance,
+	uint32_t featureId, PBDArenaVector<ColliderContact>& contacts)
+{
+	XMVECTOR distanceVector = core2 - core1;
+	float distance = XMVectorGetX(XMVector3Length(distanceVector));
+	if (radius1 + radius2 + speculativeDistance <= distance)
+	{
+		return false;
+	}
+
+	XMVECTOR normal = FLT_EPSILON < distance ? distanceVector / distance : fallbackNormal;
+
+	ColliderContact contact;
+	contact.collision_point1 = core1 + radius1 * normal;
+	contact.collision_point2 = core2 - radius2 * normal;
+	contact.collision_normal = normal;
+	contact.feature_id = featureId;
+	contacts.push_back(contact);
+
+	return true;
+}
+
+// Any direction orthogonal to the axis of the capsule, for cores that touch
+static XMVECTOR getCapsuleFallbackNormal(const Collider* capsule)
+{
+	return GetColliderWorldDirection(capsule, XMVectorSet(1.0f, 0.0f, 0.0f, 0.0f));
+}
+
+void GetCapsuleSphereContacts(Collider* capsule, Collider* sphere, float speculativeDistance, PBDArenaVector<ColliderContact>& contacts)
+{
+	assert(capsule->type == ColliderType::CAPSULE);
+	assert(sphere->type == ColliderType::SPHERE);
+
+	XMVECTOR start;
+	XMVECTOR end;
+	getCapsuleSegment(capsule, &start, &end);
+	XMVECTOR closestPoint = getClosestPointOnSegment(sphere->sphere.center, start, end);
+
+	addCoreContact(closestPoint, sphere->sphere.center, capsule->capsule.radius, sphere->sphere.radius, getCapsuleFallbackNormal(capsule),
+		speculativeDistance, MakeColliderContactFeatureId(ColliderContactFeatureType::VERTEX, 0, 0, 0), contacts);
+}
+
+void GetCapsuleCapsuleContacts(Collider* capsule1, Collider* capsule2, float speculativeDistance, PBDArenaVector<ColliderContact>& contacts)
+{
+	assert(capsule1->type == ColliderType::CAPSULE);
+	assert(capsule2->type == ColliderType::CAPSULE);
+
+	XMVECTOR start1;
+	XMVECTOR end1;
+	XMVECTOR start2;
+	XMVECTOR end2;
+	getCapsuleSegment(capsule1, &start1, &end1);
+	getCapsuleSegment(capsule2, &start2, &end2);
+
+	float radius1 = capsule1->capsule.radius;
+	float radius2 = capsule2->capsule.radius;
+	XMVECTOR fallbackNormal = getCapsuleFallbackNormal(capsule1);
+
+	// Nearly parallel segments: a contact at each end of the part of the first segment that faces the second one
+	XMVECTOR axis1 = end1 - start1;
+	XMVECTOR axis2 = end2 - start2;
+	float length1Squared = XMVectorGetX(XMVector3LengthSq(axis1));
+	float length2Squared = XMVectorGetX(XMVector3LengthSq(axis2));
+	float crossLengthSquared = XMVectorGetX(XMVector3LengthSq(XMVector3Cross(axis1, axis2)));
+	if (FLT_EPSILON < length1Squared && FLT_EPSILON < length2Squared &&
+		crossLengthSquared < CAPSULE_PARALLEL_EPSILON * length1Squared * length2Squared)
+	{
+		float t1 = XMVectorGetX(XMVector3Dot(start2 - start1, axis1)) / length1Squared;
+		float t2 = XMVectorGetX(XMVector3Dot(end2 - start1, axis1)) / length1Squared;
+		float tMin = fmaxf(fminf(t1, t2), 0.0f);
+		float tMax = fminf(fmaxf(t1, t2), 1.0f);
+		if (tMin < tMax)
+		{
+			size_t numContacts = 0;
+			float ts[2] = { tMin, tMax };
+			for (uint32_t i = 0; i < 2; ++i)
+			{
+				XMVECTOR point1 = start1 + ts[i] * axis1;
+				XMVECTOR point2 = getClosestPointOnSegment(point1, start2, end2);
+				if (true == addCoreContact(point1, point2, radius1, radius2, fallbackNormal, speculativeDistance,
+					MakeColliderContactFeatureId(ColliderContactFeatureType::EDGE_EDGE, 0, 0, i), contacts))
+				{
+					++numContacts;
+				}
+			}
+
+			if (0 < numContacts)
+			{
+				return;
+			}
+		}
+	}
+
+	XMVECTOR point1;
+	XMVECTOR point2;
+	getClosestPointsOfSegments(start1, end1, start2, end2, &point1, &point2);
+	addCoreContact(point1, point2, radius1, radius2, fallbackNormal, speculativeDistance,
+		MakeColliderContactFeatureId(ColliderContactFeatureType::VERTEX, 0, 0, 0), contacts);
+}
+
+// Segment lying on the hull face that faces it, clipped by the planes of the neighboring faces.
+// Returns false when the segment doesn't lie on a face, for the closest points to be used instead.
+static bool getCapsuleFaceContacts(Collider* capsule, Collider* hull, FXMVECTOR normal, float speculativeDistance,
+	PBDArenaVector<ColliderContact>& contacts)
+{
+	const ColliderConvexHull* convexHull = GetColliderConvexHull(hull);
+
+	// Face of the hull towards the capsule
+	XMVECTOR localNormal = GetColliderLocalDirection(hull, -normal);
+	size_t faceIndex = 0;
+	float maxDot = -FLT_MAX;
+	for (size_t i = 0; i < convexHull->faces->size(); ++i)
+	{
+		float dot = XMVectorGetX(XMVector3Dot(convexHull->faces->at(i).normal, localNormal));
+		if (maxDot < dot)
+		{
+			maxDot = dot;
+			faceIndex = i;
+		}
+	}
+
+	if (maxDot < CAPSULE_FACE_MIN_COSINE)
+	{
+		return false;
+	}
+
+	const ColliderConvexHullFace* face = &convexHull->faces->at(faceIndex);
+	XMVECTOR faceNormal = GetColliderWorldDirection(hull, face->normal);
+	XMVECTOR facePoint = GetColliderWorldPoint(hull, convexHull->vertices->at(face->elements[0]));
+
+	XMVECTOR points[2];
+	getCapsuleSegment(capsule, &points[0], &points[1]);
+	XMVECTOR axis = XMVector3Normalize(points[1] - points[0]);
+	if (CAPSULE_FACE_MAX_SINE < fabsf(XMVectorGetX(XMVector3Dot(axis, faceNormal))))
+	{
+		return false;
+	}
+
+	const std::vector<WORD>& neighbors = convexHull->faceToNeighbors[faceIndex];
+	for (size_t i = 0; i < neighbors.size(); ++i)
+	{
+		const ColliderConvexHullFace* neighbor = &convexHull->faces->at(neighbors[i]);
+		XMVECTOR planeNormal = GetColliderWorldDirection(hull, neighbor->normal);
+		XMVECTOR planePoint = GetColliderWorldPoint(hull, convexHull->vertices->at(neighbor->elements[0]));
+
+		float distance0 = XMVectorGetX(XMVector3Dot(planeNormal, points[0] - planePoint));
+		float distance1 = XMVectorGetX(XMVector3Dot(planeNormal, points[1] - planePoint));
+		if (0.0f < distance0 && 0.0f < distance1)
+		{
+			return false;
+		}
+		if (0.0f < distance0)
+		{
+			points[0] = points[0] + (distance0 / (distance0 - distance1)) * (points[1] - points[0]);
+		}
+		else if (0.0f < distance1)
+		{
+			points[1] = points[1] + (distance1 / (distance1 - distance0)) * (points[0] - points[1]);
+		}
+	}
+
+	float radius = capsule->capsule.radius;
+	size_t numContacts = 0;
+	for (uint32_t i = 0; i < 2; ++i)
+	{
+		float separation = XMVectorGetX(XMVector3Dot(faceNormal, points[i] - facePoint)) - radius;
+		if (speculativeDistance <= separation)
+		{
+			continue;
+		}
+
+		ColliderContact contact;
+		contact.collision_point1 = points[i] - radius * faceNormal;
+		contact.collision_point2 = points[i] - (separation + radius) * faceNormal;
+		contact.collision_normal = -faceNormal;
+		contact.feature_id = MakeColliderContactFeatureId(ColliderContactFeatureType::FACE2_REFERENCE, static_cast<uint32_t>(faceIndex), 0, i);
+		contacts.push_back(contact);
+		++numContacts;
+	}
+
+	return 0 < numContacts;
+}
+
+void GetCapsuleConvexHullContacts(Collider* capsule, Collider* hull, float speculativeDistance, PBDArenaVector<ColliderContact>& contacts)
+{
+	assert(capsule->type == ColliderType::CAPSULE);
+	assert(nullptr != GetColliderConvexHull(hull));
+
+	float radius = capsule->capsule.radius;
+
+	// Segment outside of the hull, the usual case: the radius is the penetration budget
+	GJKDistanceResult core;
+	if (true == GJKCoreDistance(capsule, hull, &core))
+	{
+		if (radius + speculativeDistance <= core.distance)
+		{
+			return;
+		}
+
+		if (true == getCapsuleFaceContacts(capsule, hull, core.normal, speculativeDistance, contacts))
+		{
+			return;
+		}
+
+		ColliderContact contact;
+		contact.collision_point1 = core.point1 + radius * core.normal;
+		contact.collision_point2 = core.point2;
+		contact.collision_normal = core.normal;
+		contact.feature_id = MakeColliderContactFeatureId(ColliderContactFeatureType::VERTEX, 0, 0, 0);
+		contacts.push_back(contact);
+		return;
+	}
+
+	// Segment inside the hull
+	GJKSimplex simplex;
+	XMVECTOR normal;
+	float penetration;
+	if (false == GJKCollides(capsule, hull, &simplex, nullptr) || false == EPA(capsule, hull, &simplex, &normal, &penetration))
+	{
+		return;
+	}
+
+	ColliderContact contact;
+	contact.collision_point1 = SupportPoint(capsule, normal);
+	contact.collision_point2 = contact.collision_point1 - penetration * normal;
+	contact.collision_normal = normal;
+	contact.feature_id = MakeColliderContactFeatureId(ColliderContactFeatureType::VERTEX, 0, 0, 0);
+	contacts.push_back(contact);
+}
\ No newline at end of file
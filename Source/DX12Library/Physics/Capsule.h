@@ -0,0 +1,9 @@
+#pragma once
+
+#include "Collider.h"
+
+// Contacts of a CAPSULE collider with a sphere, another capsule or a collider with a hull (CONVEX_HULL, BOX).
+// The capsule is the first collider of the contacts.
+void GetCapsuleSphereContacts(Collider* capsule, Collider* sphere, float speculativeDistance, PBDArenaVector<ColliderContact>& contacts);
+void GetCapsuleCapsuleContacts(Collider* capsule1, Collider* capsule2, float speculativeDistance, PBDArenaVector<ColliderContact>& contacts);
+void GetCapsuleConvexHullContacts(Collider* capsule, Collider* hull, float speculativeDistance, PBDArenaVector<ColliderContact>& contacts);
\ No newline at end of file
@@ -52,21 +52,21 @@ static bool planeEdgeIntersection(const Plane* plane, const XMVECTOR start, cons
 // Clips the input polygon to the input clip planes
 // If remove_instead_of_clipping is true, vertices that are lying outside the clipping planes will be removed instead of clipped
 // Based on https://research.ncl.ac.uk/game/mastersdegree/gametechnologies/previousinformation/physics5collisionmanifolds/
-static void sutherland_hodgman(std::vector<XMVECTOR>* inputPolygon, size_t numClipPlanes, const Plane* clipPlanes,
-	std::vector<XMVECTOR>* outPolygon, bool removeInsteadOfClipping)
+static void sutherland_hodgman(const PBDArenaVector<XMVECTOR>* inputPolygon, size_t numClipPlanes, const Plane* clipPlanes,
+	PBDArenaVector<XMVECTOR>* outPolygon, bool removeInsteadOfClipping)
 {
 	assert(nullptr != outPolygon);
 	assert(0 < numClipPlanes);
 
 	// Create temporary list of vertices
 	// We will keep ping-pong'ing between the two lists updating them as we go.
-	std::vector<XMVECTOR>* input = new std::vector<XMVECTOR>;
-	for (size_t i = 0; i < inputPolygon->size(); ++i)
-	{
-		input->push_back(inputPolygon->at(i));
-	}
-	std::vector<XMVECTOR>* output = new std::vector<XMVECTOR>;
-	output->reserve(inputPolygon->size() * 4);
+	PBDArenaVector<XMVECTOR> buffer1(inputPolygon->begin(), inputPolygon->end());
+	PBDArenaVector<XMVECTOR> buffer2;
+	buffer2.reserve(inputPolygon->size() * 4);
+	buffer1.reserve(inputPolygon->size() * 4);
+
+	PBDArenaVector<XMVECTOR>* input = &buffer1;
+	PBDArenaVector<XMVECTOR>* output = &buffer2;
 
 	for (size_t i = 0; i < numClipPlanes; ++i)
 	{
@@ -122,14 +122,13 @@ static void sutherland_hodgman(std::vector<XMVECTOR>* inputPolygon, size_t numCl
 		}
 
 		// Swap input/output polygons, and clear output list for us to generate afresh
-		std::vector<XMVECTOR>* temp = input;
+		PBDArenaVector<XMVECTOR>* temp = input;
 		input = output;
 		output = temp;
 		output->clear();
 	}
 
-	outPolygon = input;
-	delete output;
+	outPolygon->assign(input->begin(), input->end());
 }
 
 static XMVECTOR getClosestPointPolygon(XMVECTOR position, Plane* referencePlane)
@@ -138,34 +137,32 @@ static XMVECTOR getClosestPointPolygon(XMVECTOR position, Plane* referencePlane)
 	return position - (XMVectorGetX(XMVector3Dot(referencePlane->normal, position)) + d) * referencePlane->normal;
 }
 
-static std::vector<Plane>* buildBoundaryPlanes(ColliderConvexHull* convexHull, size_t targetFaceIndex)
+static void buildBoundaryPlanes(const Collider* collider, size_t targetFaceIndex, PBDArenaVector<Plane>* result)
 {
-	std::vector<Plane>* result = new std::vector<Plane>;
-	result->reserve(16);
-	std::vector<WORD>* faceNeighbors = &convexHull->faceToNeighbors[targetFaceIndex];
+	const ColliderConvexHull* convexHull = GetColliderConvexHull(collider);
+	const std::vector<WORD>* faceNeighbors = &convexHull->faceToNeighbors[targetFaceIndex];
+	result->reserve(faceNeighbors->size());
 
 	for (size_t i = 0; i < faceNeighbors->size(); ++i)
 	{
-		ColliderConvexHullFace neighborFace = convexHull->transformedFaces->at(faceNeighbors->at(i));
+		const ColliderConvexHullFace* neighborFace = &convexHull->faces->at(faceNeighbors->at(i));
 		Plane p;
-		p.point = convexHull->transformedVertices->at(neighborFace.elements[0]);
-		p.normal = -neighborFace.normal;
+		p.point = GetColliderWorldPoint(collider, convexHull->vertices->at(neighborFace->elements[0]));
+		p.normal = -GetColliderWorldDirection(collider, neighborFace->normal);
 		result->push_back(p);
 	}
-
-	return result;
 }
 
 static size_t getFaceWithMostFittingNormal(size_t supportIndex, const ColliderConvexHull* convexHull, XMVECTOR normal)
 {
-	std::vector<WORD> supportFaces = convexHull->vertexToFaces[supportIndex];
+	const std::vector<WORD>& supportFaces = convexHull->vertexToFaces[supportIndex];
 
 	float maxProj = -FLT_MAX;
 	size_t selectedFaceIndex = SIZE_MAX;
 	for (size_t i = 0; i < supportFaces.size(); ++i)
 	{
-		ColliderConvexHullFace face = convexHull->transformedFaces->at(supportFaces[i]);
-		float proj = XMVectorGetX(XMVector3Dot(face.normal, normal));
+		const ColliderConvexHullFace* face = &convexHull->faces->at(supportFaces[i]);
+		float proj = XMVectorGetX(XMVector3Dot(face->normal, normal));
 		if (maxProj < proj)
 		{
 			maxProj = proj;
@@ -176,27 +173,35 @@ static size_t getFaceWithMostFittingNormal(size_t supportIndex, const ColliderCo
 	return selectedFaceIndex;
 }
 
-static XMINT4 getEdgeWithMostFittingNormal(size_t support1Index, size_t support2Index, const ColliderConvexHull* convexHull1,
-	const ColliderConvexHull* convexHull2, XMVECTOR normal, XMVECTOR* edgeNormal)
+// Edges are compared in world space, only the edge directions around the two support points are transformed
+static XMINT4 getEdgeWithMostFittingNormal(size_t support1Index, size_t support2Index, const Collider* collider1,
+	const Collider* collider2, XMVECTOR normal, XMVECTOR* edgeNormal)
 {
-	XMVECTOR invertedNormal = -normal;
+	const ColliderConvexHull* convexHull1 = GetColliderConvexHull(collider1);
+	const ColliderConvexHull* convexHull2 = GetColliderConvexHull(collider2);
 
-	XMVECTOR support1 = convexHull1->transformedVertices->at(support1Index);
-	XMVECTOR support2 = convexHull2->transformedVertices->at(support2Index);
+	XMVECTOR support1 = convexHull1->vertices->at(support1Index);
+	XMVECTOR support2 = convexHull2->vertices->at(support2Index);
 
 	std::vector<WORD>* support1Neighbors = &convexHull1->vertexToNeighbors[support1Index];
 	std::vector<WORD>* support2Neighbors = &convexHull2->vertexToNeighbors[support2Index];
 
+	PBDArenaVector<XMVECTOR> edges2;
+	edges2.reserve(support2Neighbors->size());
+	for (size_t j = 0; j < support2Neighbors->size(); ++j)
+	{
+		edges2.push_back(GetColliderWorldDirection(collider2, support2 - convexHull2->vertices->at(support2Neighbors->at(j))));
+	}
+
 	float maxDot = -FLT_MAX;
 	XMINT4 selectedEdges = XMINT4();
 	for (size_t i = 0; i < support1Neighbors->size(); ++i)
 	{
-		XMVECTOR neighbor1 = convexHull1->transformedVertices->at(support1Neighbors->at(i));
-		XMVECTOR edge1 = support1 - neighbor1;
+		XMVECTOR neighbor1 = convexHull1->vertices->at(support1Neighbors->at(i));
+		XMVECTOR edge1 = GetColliderWorldDirection(collider1, support1 - neighbor1);
 		for (size_t j = 0; j < support2Neighbors->size(); ++j)
 		{
-			XMVECTOR neighbor2 = convexHull2->transformedVertices->at(support2Neighbors->at(j));
-			XMVECTOR edge2 = support2 - neighbor2;
+			XMVECTOR edge2 = edges2[j];
 
 			XMVECTOR currentNormal = XMVector3Normalize(XMVector3Cross(edge1, edge2));
 			XMVECTOR currentNormalInverted = -currentNormal;
@@ -276,41 +281,43 @@ static bool collisionDistanceBetweenSkewLines(XMVECTOR p1, XMVECTOR d1, XMVECTOR
 	return true;
 }
 
-static std::vector<XMVECTOR>* getVerticesOfFaces(ColliderConvexHull* hull, ColliderConvexHullFace face)
+static void getVerticesOfFaces(const Collider* collider, const ColliderConvexHullFace* face, PBDArenaVector<XMVECTOR>* vertices)
 {
-	std::vector<XMVECTOR>* vertices = new std::vector<XMVECTOR>;
-	vertices->reserve(16);
-	for (size_t i = 0; i < face.elements.size(); ++i)
+	vertices->reserve(face->elements.size());
+	for (size_t i = 0; i < face->elements.size(); ++i)
 	{
-		vertices->push_back(hull->transformedVertices->at(face.elements[i]));
+		vertices->push_back(GetColliderWorldPoint(collider, GetColliderConvexHull(collider)->vertices->at(face->elements[i])));
 	}
-
-	return vertices;
 }
 
-void convexToConvexContactManifold(Collider* collider1, Collider* collider2, XMVECTOR normal, std::vector<ColliderContact>& contacts)
+void convexToConvexContactManifold(Collider* collider1, Collider* collider2, XMVECTOR normal, PBDArenaVector<ColliderContact>& contacts)
 {
-	assert(collider1->type == ColliderType::CONVEX_HULL);
-	assert(collider2->type == ColliderType::CONVEX_HULL);
-
-	ColliderConvexHull* convexHull1 = &collider1->convexHull;
-	ColliderConvexHull* convexHull2 = &collider2->convexHull;
+	const ColliderConvexHull* convexHull1 = GetColliderConvexHull(collider1);
+	const ColliderConvexHull* convexHull2 = GetColliderConvexHull(collider2);
+	assert(nullptr != convexHull1);
+	assert(nullptr != convexHull2);
 
 	constexpr float EPSILON = 0.0001f;
 
 	XMVECTOR invertedNormal = -normal;
 	
+	// Support points and faces are searched in the space of each hull
+	XMVECTOR localNormal1 = GetColliderLocalDirection(collider1, normal);
+	XMVECTOR localInvertedNormal2 = GetColliderLocalDirection(collider2, invertedNormal);
+
 	XMVECTOR edgeNormal;
-	size_t support1Index = GetSupportPointIndex(convexHull1, normal);
-	size_t support2Index = GetSupportPointIndex(convexHull2, invertedNormal);
-	size_t face1Index = getFaceWithMostFittingNormal(support1Index, convexHull1, normal);
-	size_t face2Index = getFaceWithMostFittingNormal(support2Index, convexHull2, invertedNormal);
-	ColliderConvexHullFace face1 = convexHull1->transformedFaces->at(face1Index);
-	ColliderConvexHullFace face2 = convexHull2->transformedFaces->at(face2Index);
-	XMINT4 edges = getEdgeWithMostFittingNormal(support1Index, support2Index, convexHull1, convexHull2, normal, &edgeNormal);
-
-	float chosenNormal1Dot = XMVectorGetX(XMVector3Dot(face1.normal, normal));
-	float chosenNormal2Dot = XMVectorGetX(XMVector3Dot(face2.normal, invertedNormal));
+	size_t support1Index = GetSupportPointIndex(convexHull1, localNormal1);
+	size_t support2Index = GetSupportPointIndex(convexHull2, localInvertedNormal2);
+	size_t face1Index = getFaceWithMostFittingNormal(support1Index, convexHull1, localNormal1);
+	size_t face2Index = getFaceWithMostFittingNormal(support2Index, convexHull2, localInvertedNormal2);
+	const ColliderConvexHullFace* face1 = &convexHull1->faces->at(face1Index);
+	const ColliderConvexHullFace* face2 = &convexHull2->faces->at(face2Index);
+	XMVECTOR face1Normal = GetColliderWorldDirection(collider1, face1->normal);
+	XMVECTOR face2Normal = GetColliderWorldDirection(collider2, face2->normal);
+	XMINT4 edges = getEdgeWithMostFittingNormal(support1Index, support2Index, collider1, collider2, normal, &edgeNormal);
+
+	float chosenNormal1Dot = XMVectorGetX(XMVector3Dot(face1Normal, normal));
+	float chosenNormal2Dot = XMVectorGetX(XMVector3Dot(face2Normal, invertedNormal));
 	float edgeNormalDot = XMVectorGetX(XMVector3Dot(edgeNormal, normal));
 
 	if (chosenNormal1Dot + EPSILON < edgeNormalDot && chosenNormal2Dot + EPSILON < edgeNormalDot)
@@ -318,37 +325,47 @@ void convexToConvexContactManifold(Collider* collider1, Collider* collider2, XMV
 		// Edge
 		XMVECTOR l1 = XMVectorZero();
 		XMVECTOR l2 = XMVectorZero();
-		XMVECTOR p1 = convexHull1->transformedVertices->at(edges.x);
-		XMVECTOR d1 = convexHull1->transformedVertices->at(edges.y) - p1;
-		XMVECTOR p2 = convexHull2->transformedVertices->at(edges.z);
-		XMVECTOR d2 = convexHull2->transformedVertices->at(edges.w) - p2;
+		XMVECTOR p1 = GetColliderWorldPoint(collider1, convexHull1->vertices->at(edges.x));
+		XMVECTOR d1 = GetColliderWorldPoint(collider1, convexHull1->vertices->at(edges.y)) - p1;
+		XMVECTOR p2 = GetColliderWorldPoint(collider2, convexHull2->vertices->at(edges.z));
+		XMVECTOR d2 = GetColliderWorldPoint(collider2, convexHull2->vertices->at(edges.w)) - p2;
 		assert(true == collisionDistanceBetweenSkewLines(p1, d1, p2, d2, &l1, &l2, 0, 0));
 
-		ColliderContact contact = { l1, l2, normal };
+		ColliderContact contact = { l1, l2, normal,
+			MakeColliderContactFeatureId(ColliderContactFeatureType::EDGE_EDGE,
+			static_cast<uint32_t>(edges.x ^ (edges.y << 5)), static_cast<uint32_t>(edges.z ^ (edges.w << 5)), 0) };
 		contacts.push_back(contact);
 	}
 	else
 	{
 		// Face
 		bool bIsFace1ReferenceFace = chosenNormal1Dot > chosenNormal2Dot;
-		std::vector<XMVECTOR>* referenceFaceSupportPoints = bIsFace1ReferenceFace ? getVerticesOfFaces(convexHull1, face1) : getVerticesOfFaces(convexHull2, face2);
-		std::vector<XMVECTOR>* incidentFaceSupportPoints = bIsFace1ReferenceFace ? getVerticesOfFaces(convexHull2, face2) : getVerticesOfFaces(convexHull1, face1);
+		PBDArenaVector<XMVECTOR> referenceFaceSupportPoints;
+		PBDArenaVector<XMVECTOR> incidentFaceSupportPoints;
+		getVerticesOfFaces(bIsFace1ReferenceFace ? collider1 : collider2, bIsFace1ReferenceFace ? face1 : face2, &referenceFaceSupportPoints);
+		getVerticesOfFaces(bIsFace1ReferenceFace ? collider2 : collider1, bIsFace1ReferenceFace ? face2 : face1, &incidentFaceSupportPoints);
 
-		std::vector<Plane>* boundaryPlanes = bIsFace1ReferenceFace ? buildBoundaryPlanes(convexHull1, face1Index) : buildBoundaryPlanes(convexHull2, face2Index);
+		PBDArenaVector<Plane> boundaryPlanes;
+		buildBoundaryPlanes(bIsFace1ReferenceFace ? collider1 : collider2, bIsFace1ReferenceFace ? face1Index : face2Index, &boundaryPlanes);
 
-		std::vector<XMVECTOR>* clippedPoints = nullptr;
-		sutherland_hodgman(incidentFaceSupportPoints, boundaryPlanes->size(), boundaryPlanes->data(), clippedPoints, false);
+		PBDArenaVector<XMVECTOR> clippedPoints;
+		sutherland_hodgman(&incidentFaceSupportPoints, boundaryPlanes.size(), boundaryPlanes.data(), &clippedPoints, false);
 
 		Plane referencePlane;
-		referencePlane.normal = bIsFace1ReferenceFace ? -face1.normal : -face2.normal;
-		referencePlane.point = referenceFaceSupportPoints->at(0);
+		referencePlane.normal = bIsFace1ReferenceFace ? -face1Normal : -face2Normal;
+		referencePlane.point = referenceFaceSupportPoints.at(0);
+
+		PBDArenaVector<XMVECTOR> finalClippedPoints;
+		sutherland_hodgman(&clippedPoints, 1, &referencePlane, &finalClippedPoints, true);
 
-		std::vector<XMVECTOR>* finalClippedPoints = nullptr;
-		sutherland_hodgman(clippedPoints, 1, &referencePlane, finalClippedPoints, true);
+		ColliderContactFeatureType featureType = bIsFace1ReferenceFace ? ColliderContactFeatureType::FACE1_REFERENCE : ColliderContactFeatureType::FACE2_REFERENCE;
+		uint32_t referenceFaceIndex = static_cast<uint32_t>(bIsFace1ReferenceFace ? face1Index : face2Index);
+		uint32_t incidentFaceIndex = static_cast<uint32_t>(bIsFace1ReferenceFace ? face2Index : face1Index);
 
-		for (size_t i = 0; i < finalClippedPoints->size(); ++i)
+		size_t firstContact = contacts.size();
+		for (size_t i = 0; i < finalClippedPoints.size(); ++i)
 		{
-			XMVECTOR point = finalClippedPoints->at(i);
+			XMVECTOR point = finalClippedPoints.at(i);
 			XMVECTOR closestPoint = getClosestPointPolygon(point, &referencePlane);
 			XMVECTOR pointDifference = point - closestPoint;
 			float contactPenetration = XMVectorGetX(XMVector3Dot(pointDifference, normal));
@@ -367,6 +384,7 @@ void convexToConvexContactManifold(Collider* collider1, Collider* collider2, XMV
 				contact.collision_point2 = point + contactPenetration * normal;
 			}
 			contact.collision_normal = normal;
+			contact.feature_id = MakeColliderContactFeatureId(featureType, referenceFaceIndex, incidentFaceIndex, static_cast<uint32_t>(i));
 
 			if (contactPenetration < 0.0f)
 			{
@@ -374,11 +392,8 @@ void convexToConvexContactManifold(Collider* collider1, Collider* collider2, XMV
 			}
 		}
 
-		delete referenceFaceSupportPoints;
-		delete incidentFaceSupportPoints;
-		delete boundaryPlanes;
-		delete clippedPoints;
-		delete finalClippedPoints;
+		// Faces with many sides would otherwise give as many constraints
+		ReduceColliderContacts(contacts, firstContact);
 	}
 
 	if (true == contacts.empty())
@@ -387,7 +402,7 @@ void convexToConvexContactManifold(Collider* collider1, Collider* collider2, XMV
 	}
 }
 
-void GetClippingContactManifold(Collider* collider1, Collider* collider2, XMVECTOR normal, float penetration, std::vector<ColliderContact>& contacts)
+void GetClippingContactManifold(Collider* collider1, Collider* collider2, XMVECTOR normal, float penetration, PBDArenaVector<ColliderContact>& contacts)
 {
 	if (collider1->type == ColliderType::SPHERE)
 	{
@@ -397,6 +412,7 @@ void GetClippingContactManifold(Collider* collider1, Collider* collider2, XMVECT
 		contact.collision_point1 = sphereCollisionPoint;
 		contact.collision_point2 = sphereCollisionPoint - penetration * normal;
 		contact.collision_normal = normal;
+		contact.feature_id = MakeColliderContactFeatureId(ColliderContactFeatureType::VERTEX, 0, 0, 0);
 
 		contacts.push_back(contact);
 	}
@@ -409,6 +425,18 @@ void GetClippingContactManifold(Collider* collider1, Collider* collider2, XMVECT
 		contact.collision_point1 = sphereCollisionPoint + penetration * normal;
 		contact.collision_point2 = sphereCollisionPoint;
 		contact.collision_normal = normal;
+		contact.feature_id = MakeColliderContactFeatureId(ColliderContactFeatureType::VERTEX, 0, 0, 0);
+
+		contacts.push_back(contact);
+	}
+	else if (nullptr == GetColliderConvexHull(collider1) || nullptr == GetColliderConvexHull(collider2))
+	{
+		// No faces to clip, a single contact at the deepest point
+		ColliderContact contact;
+		contact.collision_point1 = SupportPoint(collider1, normal);
+		contact.collision_point2 = contact.collision_point1 - penetration * normal;
+		contact.collision_normal = normal;
+		contact.feature_id = MakeColliderContactFeatureId(ColliderContactFeatureType::VERTEX, 0, 0, 0);
 
 		contacts.push_back(contact);
 	}
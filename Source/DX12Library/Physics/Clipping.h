@@ -2,4 +2,4 @@
 
 #include "Collider.h"
 
-void GetClippingContactManifold(Collider* collider1, Collider* collider2, XMVECTOR normal, float penetration, std::vector<ColliderContact>& contacts);
\ No newline at end of file
+void GetClippingContactManifold(Collider* collider1, Collider* collider2, XMVECTOR normal, float penetration, PBDArenaVector<ColliderContact>& contacts);
\ No newline at end of file
@@ -3,6 +3,11 @@
 #include <unordered_map>
 #include "GJK.h"
 #include "EPA.h"
+#include "BoxBox.h"
+#include "Capsule.h"
+#include "TriangleMesh.h"
+#include "Heightfield.h"
+#include "ColliderPairCache.h"
 
 template<>
 struct std::hash<XMVECTOR>
@@ -365,16 +370,33 @@ Collider CreateColliderConvexHull(const std::vector<Vertex>& vertices, const std
 
 	ColliderConvexHull convexHull;
 	convexHull.vertices = hull;
-	convexHull.transformedVertices = hull;
 	convexHull.faces = faces;
-	convexHull.transformedFaces = faces;
 	convexHull.vertexToFaces = vertexToFacesMap;
 	convexHull.vertexToNeighbors = vertexToNeighborsMap;
 	convexHull.faceToNeighbors = faceToNeighborFacesMap;
 
+	// Start the support searches from a vertex that has neighbors to walk to
+	WORD firstConnectedVertex = 0;
+	for (size_t i = 0; i < hull->size(); ++i)
+	{
+		if (false == vertexToNeighborsMap[i].empty())
+		{
+			firstConnectedVertex = static_cast<WORD>(i);
+			break;
+		}
+	}
+
+	convexHull.supportHints = new std::atomic<WORD>[COLLIDER_SUPPORT_HINT_COUNT];
+	for (size_t i = 0; i < COLLIDER_SUPPORT_HINT_COUNT; ++i)
+	{
+		convexHull.supportHints[i].store(firstConnectedVertex, std::memory_order_relaxed);
+	}
+
 	Collider collider;
 	collider.type = ColliderType::CONVEX_HULL;
 	collider.convexHull = convexHull;
+	collider.position = XMVectorZero();
+	collider.rotation = XMQuaternionIdentity();
 
 	return collider;
 }
@@ -385,36 +407,146 @@ Collider CreateColliderSphere(const float radius)
 	collider.type = ColliderType::SPHERE;
 	collider.sphere.center = XMVectorZero();
 	collider.sphere.radius = radius;
+	collider.position = XMVectorZero();
+	collider.rotation = XMQuaternionIdentity();
 
 	return collider;
 }
 
-static void updateCollider(Collider* collider, XMVECTOR translation, const XMVECTOR rotationQ)
+// Corners in the order of the cube mesh of RigidBodyCube, whose triangles are reused for the hull of the box
+static constexpr WORD BOX_HULL_INDICES[] =
 {
-	UNREFERENCED_PARAMETER(rotationQ);
+	0, 1, 2, 0, 2, 3,
+	4, 6, 5, 4, 7, 6,
+	4, 5, 1, 4, 1, 0,
+	3, 2, 6, 3, 6, 7,
+	1, 5, 6, 1, 6, 2,
+	4, 0, 3, 4, 3, 7
+};
 
-	switch (collider->type)
+Collider CreateColliderBox(const XMFLOAT3& halfExtents)
+{
+	const float corners[8][3] =
 	{
-	case ColliderType::CONVEX_HULL:
-		// TODO: check disrespected translation
-		XMMATRIX modelMatrixNoScale = XMMatrixTranslationFromVector(translation) * XMMatrixRotationQuaternion(rotationQ);
-		for (size_t i = 0; i < collider->convexHull.transformedVertices->size(); ++i)
+		{ -1.0f, -1.0f, -1.0f }, { -1.0f, 1.0f, -1.0f }, { 1.0f, 1.0f, -1.0f }, { 1.0f, -1.0f, -1.0f },
+		{ -1.0f, -1.0f, 1.0f }, { -1.0f, 1.0f, 1.0f }, { 1.0f, 1.0f, 1.0f }, { 1.0f, -1.0f, 1.0f }
+	};
+
+	std::vector<Vertex> vertices;
+	for (size_t i = 0; i < 8; ++i)
+	{
+		Vertex vertex = {};
+		vertex.position = XMFLOAT3(corners[i][0] * halfExtents.x, corners[i][1] * halfExtents.y, corners[i][2] * halfExtents.z);
+		vertices.push_back(vertex);
+	}
+	std::vector<WORD> indices(BOX_HULL_INDICES, BOX_HULL_INDICES + _countof(BOX_HULL_INDICES));
+
+	Collider hullCollider = CreateColliderConvexHull(vertices, indices);
+
+	Collider collider;
+	collider.type = ColliderType::BOX;
+	collider.box.halfExtents = XMLoadFloat3(&halfExtents);
+	collider.box.convexHull = hullCollider.convexHull;
+	collider.position = XMVectorZero();
+	collider.rotation = XMQuaternionIdentity();
+
+	return collider;
+}
+
+Collider CreateColliderCapsule(const float radius, const float halfHeight)
+{
+	Collider collider;
+	collider.type = ColliderType::CAPSULE;
+	collider.capsule.radius = radius;
+	collider.capsule.halfHeight = halfHeight;
+	collider.position = XMVectorZero();
+	collider.rotation = XMQuaternionIdentity();
+
+	return collider;
+}
+
+Collider CreateColliderCylinder(const float radius, const float halfHeight)
+{
+	Collider collider;
+	collider.type = ColliderType::CYLINDER;
+	collider.cylinder.radius = radius;
+	collider.cylinder.halfHeight = halfHeight;
+	collider.position = XMVectorZero();
+	collider.rotation = XMQuaternionIdentity();
+
+	return collider;
+}
+
+Collider CreateColliderTriangleMesh(const std::vector<Vertex>& vertices, const std::vector<WORD>& indices)
+{
+	std::unordered_map<XMVECTOR, uint32_t> vertexToIndexMap;
+
+	// Weld the vertices the mesh duplicates for its normals, so that neighbor triangles share their edges
+	std::vector<XMVECTOR> meshVertices;
+	std::vector<uint32_t> vertexRemap(vertices.size());
+	for (size_t i = 0; i < vertices.size(); ++i)
+	{
+		XMVECTOR currentVertex = XMLoadFloat3(&vertices[i].position);
+		auto it = vertexToIndexMap.find(currentVertex);
+		if (it == vertexToIndexMap.end())
+		{
+			uint32_t currentIndex = static_cast<uint32_t>(meshVertices.size());
+			meshVertices.push_back(currentVertex);
+			vertexToIndexMap.emplace(currentVertex, currentIndex);
+			vertexRemap[i] = currentIndex;
+		}
+		else
 		{
-			XMVECTOR vertex = collider->convexHull.vertices->at(i);
-			XMVECTOR transformedVertex = XMVector3Transform(vertex, modelMatrixNoScale);
-			collider->convexHull.transformedVertices->at(i) = transformedVertex;
+			vertexRemap[i] = it->second;
 		}
+	}
 
-		for (size_t i = 0; i < collider->convexHull.transformedFaces->size(); ++i)
+	// Drop the triangles that welding collapsed
+	std::vector<uint32_t> meshIndices;
+	for (size_t i = 0; i + 2 < indices.size(); i += 3)
+	{
+		uint32_t i1 = vertexRemap[indices[i]];
+		uint32_t i2 = vertexRemap[indices[i + 1]];
+		uint32_t i3 = vertexRemap[indices[i + 2]];
+		if (i1 == i2 || i2 == i3 || i3 == i1)
 		{
-			XMVECTOR normal = collider->convexHull.faces->at(i).normal;
-			XMVECTOR transformedNormal = XMVector3Transform(normal, modelMatrixNoScale);
-			collider->convexHull.transformedFaces->at(i).normal = XMVector3Normalize(transformedNormal);
+			continue;
 		}
-		break;
-	case ColliderType::SPHERE:
+
+		meshIndices.push_back(i1);
+		meshIndices.push_back(i2);
+		meshIndices.push_back(i3);
+	}
+	assert(false == meshIndices.empty());
+
+	Collider collider;
+	collider.type = ColliderType::TRIANGLE_MESH;
+	BuildColliderTriangleMesh(&collider.triangleMesh, meshVertices, meshIndices);
+	collider.position = XMVectorZero();
+	collider.rotation = XMQuaternionIdentity();
+
+	return collider;
+}
+
+Collider CreateColliderHeightfield(const std::vector<float>& heights, uint32_t numColumns, uint32_t numRows, float cellSize)
+{
+	Collider collider;
+	collider.type = ColliderType::HEIGHTFIELD;
+	BuildColliderHeightfield(&collider.heightfield, heights, numColumns, numRows, cellSize);
+	collider.position = XMVectorZero();
+	collider.rotation = XMQuaternionIdentity();
+
+	return collider;
+}
+
+static void updateCollider(Collider* collider, XMVECTOR translation, const XMVECTOR rotationQ)
+{
+	collider->position = translation;
+	collider->rotation = rotationQ;
+
+	if (collider->type == ColliderType::SPHERE)
+	{
 		collider->sphere.center = translation;
-		break;
 	}
 }
 
@@ -427,15 +559,54 @@ void UpdateColliders(std::vector<Collider>& colliders, XMVECTOR translation, con
 	}
 }
 
-static void destroyColliderConvexHull(Collider* collider)
+XMVECTOR GetColliderWorldPoint(const Collider* collider, FXMVECTOR localPoint)
+{
+	return XMVector3Rotate(localPoint, collider->rotation) + collider->position;
+}
+
+XMVECTOR GetColliderWorldDirection(const Collider* collider, FXMVECTOR localDirection)
+{
+	return XMVector3Rotate(localDirection, collider->rotation);
+}
+
+XMVECTOR GetColliderLocalDirection(const Collider* collider, FXMVECTOR direction)
+{
+	return XMVector3InverseRotate(direction, collider->rotation);
+}
+
+const ColliderConvexHull* GetColliderConvexHull(const Collider* collider)
+{
+	switch (collider->type)
+	{
+	case ColliderType::CONVEX_HULL:
+		return &collider->convexHull;
+	case ColliderType::BOX:
+		return &collider->box.convexHull;
+	case ColliderType::SPHERE:
+	case ColliderType::CAPSULE:
+	case ColliderType::CYLINDER:
+	case ColliderType::TRIANGLE_MESH:
+	case ColliderType::HEIGHTFIELD:
+	case ColliderType::TRIANGLE:
+		break;
+	}
+
+	return nullptr;
+}
+
+bool IsColliderStaticGeometry(const Collider* collider)
 {
-	delete collider->convexHull.vertices;
-	delete collider->convexHull.transformedFaces;
-	delete collider->convexHull.faces;
-	delete collider->convexHull.transformedFaces;
-	delete[] collider->convexHull.vertexToFaces;
-	delete[] collider->convexHull.vertexToNeighbors;
-	delete[] collider->convexHull.faceToNeighbors;
+	return collider->type == ColliderType::TRIANGLE_MESH || collider->type == ColliderType::HEIGHTFIELD;
+}
+
+static void destroyConvexHull(ColliderConvexHull* convexHull)
+{
+	delete convexHull->vertices;
+	delete convexHull->faces;
+	delete[] convexHull->vertexToFaces;
+	delete[] convexHull->vertexToNeighbors;
+	delete[] convexHull->faceToNeighbors;
+	delete[] convexHull->supportHints;
 }
 
 static void destroyCollider(Collider* collider)
@@ -443,9 +614,21 @@ static void destroyCollider(Collider* collider)
 	switch (collider->type)
 	{
 	case ColliderType::CONVEX_HULL:
-		destroyColliderConvexHull(collider);
+		destroyConvexHull(&collider->convexHull);
+		break;
+	case ColliderType::BOX:
+		destroyConvexHull(&collider->box.convexHull);
+		break;
+	case ColliderType::TRIANGLE_MESH:
+		DestroyColliderTriangleMesh(&collider->triangleMesh);
+		break;
+	case ColliderType::HEIGHTFIELD:
+		DestroyColliderHeightfield(&collider->heightfield);
 		break;
 	case ColliderType::SPHERE:
+	case ColliderType::CAPSULE:
+	case ColliderType::CYLINDER:
+	case ColliderType::TRIANGLE:
 		break;
 	}
 }
@@ -465,6 +648,9 @@ XMMATRIX GetCollidersDefaultInertiaTensor(const std::vector<Collider>& colliders
 	{
 		const Collider* collider = &colliders[0];
 
+		// Triangle meshes and heightfields are only meant for fixed bodies, which have no inertia
+		assert(collider->type != ColliderType::TRIANGLE_MESH && collider->type != ColliderType::HEIGHTFIELD);
+
 		if (collider->type == ColliderType::SPHERE)
 		{
 			assert(0.0f == XMVectorGetX(XMVector3LengthSq(collider->sphere.center)));
@@ -474,13 +660,54 @@ XMMATRIX GetCollidersDefaultInertiaTensor(const std::vector<Collider>& colliders
 
 			return result;
 		}
+
+		if (collider->type == ColliderType::BOX)
+		{
+			XMFLOAT3 h;
+			XMStoreFloat3(&h, collider->box.halfExtents);
+
+			float k = mass / 3.0f;
+			XMMATRIX result = XMMatrixScaling(k * (h.y * h.y + h.z * h.z), k * (h.x * h.x + h.z * h.z), k * (h.x * h.x + h.y * h.y));
+
+			return result;
+		}
+
+		if (collider->type == ColliderType::CAPSULE)
+		{
+			// Cylinder and two hemispheres, with the mass split by volume
+			float r = collider->capsule.radius;
+			float height = 2.0f * collider->capsule.halfHeight;
+			float cylinderVolume = XM_PI * r * r * height;
+			float sphereVolume = 4.0f / 3.0f * XM_PI * r * r * r;
+			float cylinderMass = mass * cylinderVolume / (cylinderVolume + sphereVolume);
+			float sphereMass = mass - cylinderMass;
+
+			float inertiaY = cylinderMass * r * r / 2.0f + sphereMass * 2.0f / 5.0f * r * r;
+			float inertiaXZ = cylinderMass * (r * r / 4.0f + height * height / 12.0f) +
+				sphereMass * (2.0f / 5.0f * r * r + height * height / 4.0f + 3.0f / 8.0f * height * r);
+			XMMATRIX result = XMMatrixScaling(inertiaXZ, inertiaY, inertiaXZ);
+
+			return result;
+		}
+
+		if (collider->type == ColliderType::CYLINDER)
+		{
+			float r = collider->cylinder.radius;
+			float height = 2.0f * collider->cylinder.halfHeight;
+
+			float inertiaY = mass * r * r / 2.0f;
+			float inertiaXZ = mass * (3.0f * r * r + height * height) / 12.0f;
+			XMMATRIX result = XMMatrixScaling(inertiaXZ, inertiaY, inertiaXZ);
+
+			return result;
+		}
 	}
 
 	size_t totalNumVertices = 0;
 	for (size_t i = 0; i < colliders.size(); ++i)
 	{
 		const Collider* collider = &colliders[i];
-		totalNumVertices += collider->convexHull.vertices->size();
+		totalNumVertices += GetColliderConvexHull(collider)->vertices->size();
 	}
 
 	float massPerVertex = mass / static_cast<float>(totalNumVertices);
@@ -488,12 +715,12 @@ XMMATRIX GetCollidersDefaultInertiaTensor(const std::vector<Collider>& colliders
 	XMMATRIX result = XMMatrixIdentity();
 	for (size_t i = 0; i < colliders.size(); ++i)
 	{
-		const Collider* collider = &colliders[i];
-		assert(collider->type == ColliderType::CONVEX_HULL);
+		const ColliderConvexHull* convexHull = GetColliderConvexHull(&colliders[i]);
+		assert(nullptr != convexHull);
 
-		for (size_t j = 0; j < collider->convexHull.vertices->size(); ++j)
+		for (size_t j = 0; j < convexHull->vertices->size(); ++j)
 		{
-			XMVECTOR v = collider->convexHull.vertices->at(j);
+			XMVECTOR v = convexHull->vertices->at(j);
 			float vx = XMVectorGetX(v);
 			float vy = XMVectorGetY(v);
 			float vz = XMVectorGetZ(v);
@@ -523,6 +750,21 @@ static float getConvexHullColliderBoundingSphereRadius(const Collider* collider)
 	return maxDistance;
 }
 
+static float getVerticesBoundingSphereRadius(const XMVECTOR* vertices, size_t numVertices)
+{
+	float maxDistance = 0.0f;
+	for (size_t i = 0; i < numVertices; ++i)
+	{
+		float distance = XMVectorGetX(XMVector3Length(vertices[i]));
+		if (maxDistance < distance)
+		{
+			maxDistance = distance;
+		}
+	}
+
+	return maxDistance;
+}
+
 static float getColliderBoundingSphereRadius(const Collider* collider)
 {
 	switch (collider->type)
@@ -533,6 +775,29 @@ static float getColliderBoundingSphereRadius(const Collider* collider)
 	case ColliderType::SPHERE:
 		return collider->sphere.radius;
 		break;
+	case ColliderType::BOX:
+		return XMVectorGetX(XMVector3Length(collider->box.halfExtents));
+		break;
+	case ColliderType::CAPSULE:
+		return collider->capsule.halfHeight + collider->capsule.radius;
+		break;
+	case ColliderType::CYLINDER:
+		return sqrtf(collider->cylinder.halfHeight * collider->cylinder.halfHeight + collider->cylinder.radius * collider->cylinder.radius);
+		break;
+	case ColliderType::TRIANGLE_MESH:
+		return getVerticesBoundingSphereRadius(collider->triangleMesh.vertices->data(), collider->triangleMesh.vertices->size());
+		break;
+	case ColliderType::HEIGHTFIELD:
+	{
+		const ColliderHeightfield* heightfield = &collider->heightfield;
+		float halfWidth = 0.5f * static_cast<float>(heightfield->numColumns - 1) * heightfield->cellSize;
+		float halfDepth = 0.5f * static_cast<float>(heightfield->numRows - 1) * heightfield->cellSize;
+		float height = fmaxf(fabsf(heightfield->minHeight), fabsf(heightfield->maxHeight));
+		return sqrtf(halfWidth * halfWidth + halfDepth * halfDepth + height * height);
+	}
+	case ColliderType::TRIANGLE:
+		return getVerticesBoundingSphereRadius(collider->triangle.vertices, 3);
+		break;
 	}
 
 	assert(false);
@@ -555,29 +820,210 @@ float GetCollidersBoundingSphereRadius(const std::vector<Collider>& colliders)
 	return maxBoundingSphereRadius;
 }
 
-static void getColliderContacts(Collider* collider1, Collider* collider2, std::vector<ColliderContact>& contacts)
+uint32_t MakeColliderContactFeatureId(ColliderContactFeatureType type, uint32_t a, uint32_t b, uint32_t c)
+{
+	// [31:30] type, [29:20] a, [19:10] b, [9:0] c
+	return (static_cast<uint32_t>(type) << 30) | ((a & 0x3FF) << 20) | ((b & 0x3FF) << 10) | (c & 0x3FF);
+}
+
+// Twice the area of the triangle abc, signed by its winding around the normal
+static float getContactTriangleArea(FXMVECTOR a, FXMVECTOR b, FXMVECTOR c, GXMVECTOR normal)
+{
+	return XMVectorGetX(XMVector3Dot(XMVector3Cross(b - a, c - a), normal));
+}
+
+void ReduceColliderContacts(PBDArenaVector<ColliderContact>& contacts, size_t firstContact)
+{
+	size_t numContacts = contacts.size() - firstContact;
+	if (numContacts <= COLLIDER_MAX_MANIFOLD_CONTACTS)
+	{
+		return;
+	}
+
+	const ColliderContact* candidates = &contacts[firstContact];
+	XMVECTOR normal = candidates[0].collision_normal;
+	size_t selected[COLLIDER_MAX_MANIFOLD_CONTACTS];
+
+	selected[0] = 0;
+	float maxPenetration = -FLT_MAX;
+	for (size_t i = 0; i < numContacts; ++i)
+	{
+		float penetration = XMVectorGetX(XMVector3Dot(candidates[i].collision_point1 - candidates[i].collision_point2, normal));
+		if (maxPenetration < penetration)
+		{
+			maxPenetration = penetration;
+			selected[0] = i;
+		}
+	}
+
+	XMVECTOR deepestPoint = candidates[selected[0]].collision_point1;
+	float maxDistance = -1.0f;
+	for (size_t i = 0; i < numContacts; ++i)
+	{
+		float distance = XMVectorGetX(XMVector3LengthSq(candidates[i].collision_point1 - deepestPoint));
+		if (maxDistance < distance)
+		{
+			maxDistance = distance;
+			selected[1] = i;
+		}
+	}
+
+	XMVECTOR furthestPoint = candidates[selected[1]].collision_point1;
+	float maxArea = -1.0f;
+	float triangleSign = 1.0f;
+	for (size_t i = 0; i < numContacts; ++i)
+	{
+		float area = getContactTriangleArea(deepestPoint, furthestPoint, candidates[i].collision_point1, normal);
+		if (maxArea < fabsf(area))
+		{
+			maxArea = fabsf(area);
+			triangleSign = area < 0.0f ? -1.0f : 1.0f;
+			selected[2] = i;
+		}
+	}
+
+	// The fourth point lies the furthest outside of the triangle
+	XMVECTOR thirdPoint = candidates[selected[2]].collision_point1;
+	float minArea = 0.0f;
+	size_t numSelected = 3;
+	for (size_t i = 0; i < numContacts; ++i)
+	{
+		XMVECTOR point = candidates[i].collision_point1;
+		float area = fminf(triangleSign * getContactTriangleArea(deepestPoint, furthestPoint, point, normal),
+			fminf(triangleSign * getContactTriangleArea(furthestPoint, thirdPoint, point, normal),
+			triangleSign * getContactTriangleArea(thirdPoint, deepestPoint, point, normal)));
+		if (area < minArea)
+		{
+			minArea = area;
+			selected[3] = i;
+			numSelected = 4;
+		}
+	}
+
+	ColliderContact reducedContacts[COLLIDER_MAX_MANIFOLD_CONTACTS];
+	for (size_t i = 0; i < numSelected; ++i)
+	{
+		reducedContacts[i] = candidates[selected[i]];
+	}
+
+	contacts.resize(firstContact + numSelected);
+	for (size_t i = 0; i < numSelected; ++i)
+	{
+		contacts[firstContact + i] = reducedContacts[i];
+	}
+}
+
+// Dedicated routines of a capsule against a sphere, a capsule or a hull. Returns false for the other pairs.
+static bool getCapsuleContacts(Collider* capsule, Collider* other, float speculativeDistance, PBDArenaVector<ColliderContact>& contacts)
+{
+	if (other->type == ColliderType::SPHERE)
+	{
+		GetCapsuleSphereContacts(capsule, other, speculativeDistance, contacts);
+		return true;
+	}
+	if (other->type == ColliderType::CAPSULE)
+	{
+		GetCapsuleCapsuleContacts(capsule, other, speculativeDistance, contacts);
+		return true;
+	}
+	if (nullptr != GetColliderConvexHull(other))
+	{
+		GetCapsuleConvexHullContacts(capsule, other, speculativeDistance, contacts);
+		return true;
+	}
+
+	return false;
+}
+
+static void getStaticGeometryContacts(Collider* convex, Collider* geometry, float speculativeDistance, PBDArenaVector<ColliderContact>& contacts)
+{
+	if (geometry->type == ColliderType::TRIANGLE_MESH)
+	{
+		GetConvexTriangleMeshContacts(convex, geometry, speculativeDistance, contacts);
+	}
+	else
+	{
+		GetConvexHeightfieldContacts(convex, geometry, speculativeDistance, contacts);
+	}
+}
+
+// Swaps the colliders of the contacts from firstContact on, for the routines that take their colliders in a fixed order
+static void flipColliderContacts(PBDArenaVector<ColliderContact>& contacts, size_t firstContact)
+{
+	for (size_t i = firstContact; i < contacts.size(); ++i)
+	{
+		ColliderContact* contact = &contacts[i];
+		XMVECTOR point1 = contact->collision_point1;
+		contact->collision_point1 = contact->collision_point2;
+		contact->collision_point2 = point1;
+		contact->collision_normal = -contact->collision_normal;
+	}
+}
+
+static void getColliderContacts(Collider* collider1, Collider* collider2, ColliderPairCache* pairCache, float speculativeDistance,
+	PBDArenaVector<ColliderContact>& contacts)
 {
 	float penetration;
 	XMVECTOR normal;
 
+	if (true == IsColliderStaticGeometry(collider1) || true == IsColliderStaticGeometry(collider2))
+	{
+		// Static geometry never collides with static geometry
+		if (false == IsColliderStaticGeometry(collider1))
+		{
+			getStaticGeometryContacts(collider1, collider2, speculativeDistance, contacts);
+		}
+		else if (false == IsColliderStaticGeometry(collider2))
+		{
+			// The routines take the static geometry second
+			size_t firstContact = contacts.size();
+			getStaticGeometryContacts(collider2, collider1, speculativeDistance, contacts);
+			flipColliderContacts(contacts, firstContact);
+		}
+
+		return;
+	}
+
 	if (collider1->type == ColliderType::SPHERE && collider2->type == ColliderType::SPHERE)
 	{
 		XMVECTOR distanceVector = collider2->sphere.center - collider1->sphere.center;
 		float distanceSquared = XMVectorGetX(XMVector3Dot(distanceVector, distanceVector));
-		float minDistance = collider2->sphere.radius + collider1->sphere.radius;
+		float minDistance = collider2->sphere.radius + collider1->sphere.radius + speculativeDistance;
 		if (distanceSquared < (minDistance * minDistance))
 		{
 			normal = XMVector3Normalize(distanceVector);
-			penetration = minDistance - sqrtf(distanceSquared);
+			penetration = minDistance - speculativeDistance - sqrtf(distanceSquared);
 			GetClippingContactManifold(collider1, collider2, normal, penetration, contacts);
 		}
 
 		return;
 	}
 
+	if (collider1->type == ColliderType::CAPSULE && true == getCapsuleContacts(collider1, collider2, speculativeDistance, contacts))
+	{
+		return;
+	}
+
+	if (collider2->type == ColliderType::CAPSULE)
+	{
+		// The routines take the capsule first
+		size_t firstContact = contacts.size();
+		if (true == getCapsuleContacts(collider2, collider1, speculativeDistance, contacts))
+		{
+			flipColliderContacts(contacts, firstContact);
+			return;
+		}
+	}
+
+	if (collider1->type == ColliderType::BOX && collider2->type == ColliderType::BOX)
+	{
+		GetBoxBoxContacts(collider1, collider2, nullptr == pairCache ? nullptr : &pairCache->boxBox, speculativeDistance, contacts);
+		return;
+	}
+
 	// GJK to check collision
 	GJKSimplex simplex;
-	if (true == GJKCollides(collider1, collider2, &simplex))
+	if (true == GJKCollides(collider1, collider2, &simplex, nullptr == pairCache ? nullptr : &pairCache->gjk))
 	{
 		// Collision detected
 
@@ -589,12 +1035,23 @@ static void getColliderContacts(Collider* collider1, Collider* collider2, std::v
 
 		GetClippingContactManifold(collider1, collider2, normal, penetration, contacts);
 	}
+	else if (0.0f < speculativeDistance)
+	{
+		// Speculative contact between the closest points
+		GJKDistanceResult distance;
+		if (true == GJKDistance(collider1, collider2, &distance) && distance.distance < speculativeDistance)
+		{
+			ColliderContact contact = { distance.point1, distance.point2, distance.normal,
+				MakeColliderContactFeatureId(ColliderContactFeatureType::VERTEX, 1, 0, 0) };
+			contacts.push_back(contact);
+		}
+	}
 }
 
-std::vector<ColliderContact> GetCollidersContacts(std::vector<Collider>& colliders1, std::vector<Collider>& colliders2)
+void GetCollidersContacts(std::vector<Collider>& colliders1, std::vector<Collider>& colliders2, ColliderPairCache* pairCaches,
+	float speculativeDistance, PBDArenaVector<ColliderContact>& contacts)
 {
-	std::vector<ColliderContact> contacts;
-	contacts.reserve(16);
+	contacts.reserve(contacts.size() + 16);
 
 	for (size_t i = 0; i < colliders1.size(); ++i)
 	{
@@ -602,9 +1059,15 @@ std::vector<ColliderContact> GetCollidersContacts(std::vector<Collider>& collide
 		for (size_t j = 0; j < colliders2.size(); ++j)
 		{
 			Collider* collider2 = &colliders2[j];
-			getColliderContacts(collider1, collider2, contacts);
+			size_t firstContact = contacts.size();
+			getColliderContacts(collider1, collider2, nullptr == pairCaches ? nullptr : &pairCaches[i * colliders2.size() + j], speculativeDistance, contacts);
+
+			// Distinguish the contacts of different collider pairs of the same bodies
+			uint32_t colliderPairId = (static_cast<uint32_t>(i) * 0x9E3779B1u) ^ (static_cast<uint32_t>(j) * 0x85EBCA77u);
+			for (size_t k = firstContact; k < contacts.size(); ++k)
+			{
+				contacts[k].feature_id ^= colliderPairId;
+			}
 		}
 	}
-
-	return contacts;
 }
\ No newline at end of file
@@ -1,42 +1,156 @@
 #pragma once
 
 #include "Common.h"
+#include "PBDFrameArena.h"
+#include <atomic>
 
 struct ColliderContact
 {
 	XMVECTOR collision_point1;
 	XMVECTOR collision_point2;
 	XMVECTOR collision_normal;
+
+	// Identifies the pair of features that produced the contact, so that it can be matched across frames
+	uint32_t feature_id;
+};
+
+enum class ColliderContactFeatureType
+{
+	VERTEX,
+	FACE1_REFERENCE,
+	FACE2_REFERENCE,
+	EDGE_EDGE
 };
 
+uint32_t MakeColliderContactFeatureId(ColliderContactFeatureType type, uint32_t a, uint32_t b, uint32_t c);
+
+// Contacts kept from a clipped face, each one being solved as its own constraint
+constexpr size_t COLLIDER_MAX_MANIFOLD_CONTACTS = 4;
+
+// Reduces the contacts from firstContact on, which share their normal, to the deepest one, the one furthest from it, and the two
+// that add the most area to the contact polygon. The contacts that are kept keep their feature ids.
+void ReduceColliderContacts(PBDArenaVector<ColliderContact>& contacts, size_t firstContact);
+
+struct ColliderPairCache;
+
 struct ColliderConvexHullFace
 {
 	std::vector<WORD> elements;
 	XMVECTOR normal;
 };
 
+// Vertices and faces are in the space of the body, queries transform only the points they need with the collider pose
 struct ColliderConvexHull
 {
 	std::vector<XMVECTOR>* vertices;
-	std::vector<XMVECTOR>* transformedVertices;
 	std::vector<ColliderConvexHullFace>* faces;
-	std::vector<ColliderConvexHullFace>* transformedFaces;
 
 	std::vector<WORD>* vertexToFaces;
 	std::vector<WORD>* vertexToNeighbors;
 	std::vector<WORD>* faceToNeighbors;
+
+	// Support point found last for each octant of the query direction, where the next search starts from
+	std::atomic<WORD>* supportHints;
 };
 
+constexpr size_t COLLIDER_SUPPORT_HINT_COUNT = 8;
+
 struct ColliderSphere
 {
 	XMVECTOR center;
 	float radius;
 };
 
+// Box centered on the body, along the axes of the body
+struct ColliderBox
+{
+	XMVECTOR halfExtents;
+
+	// Hull of the box, for the pairs that have no dedicated test
+	ColliderConvexHull convexHull;
+};
+
+// Segment from -halfHeight to halfHeight along the Y axis of the body, swept by a sphere
+struct ColliderCapsule
+{
+	float radius;
+	float halfHeight;
+};
+
+// Centered on the body, along its Y axis
+struct ColliderCylinder
+{
+	float radius;
+	float halfHeight;
+};
+
+// Node of the bounding volume hierarchy of a triangle mesh, 16 bytes so that four of them share a cache line.
+// The box is quantized to 16 bits per axis over the bounds of the mesh, rounded outwards.
+// Nodes are stored depth-first, the first child of an internal node right after it. Internal nodes hold minus the size
+// of their subtree, which the traversal adds to skip it, and leaves hold their triangle.
+struct ColliderTriangleMeshNode
+{
+	uint16_t quantizedMin[3];
+	uint16_t quantizedMax[3];
+	int32_t escapeIndexOrTriangle;
+};
+
+// Static concave geometry, for fixed bodies only. Vertices are in the space of the body and the triangles are stored
+// in the order of the leaves of the hierarchy, so that nearby triangles are next to each other in memory.
+struct ColliderTriangleMesh
+{
+	std::vector<XMVECTOR>* vertices;
+	std::vector<uint32_t>* indices;
+
+	// Per triangle, bit i set when the edge from its vertex i to its vertex i + 1 is on the border of the mesh or on a convex crease.
+	// Contacts on the other edges are given the normal of the triangle, so that bodies slide over the seams of flat ground.
+	std::vector<uint8_t>* activeEdges;
+
+	std::vector<ColliderTriangleMeshNode>* nodes;
+	XMVECTOR boundsMin;
+	XMVECTOR boundsMax;
+	XMVECTOR quantizationScale;
+};
+
+struct ColliderHeightfieldCell
+{
+	float minHeight;
+	float maxHeight;
+
+	// Active edges of the two triangles of the cell, three bits each like ColliderTriangleMesh::activeEdges
+	uint8_t activeEdges;
+};
+
+// Regular grid of heights along the Y axis of the body, centered on it. Samples are numColumns along X and numRows along Z,
+// cellSize apart, with heights[row * numColumns + column]. Each cell is split into two triangles along its diagonal.
+// Queries find the cells under a box by dividing its coordinates by the cell size, and skip those whose heights are out of it.
+struct ColliderHeightfield
+{
+	std::vector<float>* heights;
+	std::vector<ColliderHeightfieldCell>* cells;
+	uint32_t numColumns;
+	uint32_t numRows;
+	float cellSize;
+	float minHeight;
+	float maxHeight;
+};
+
+// Single triangle of a mesh or a heightfield, in the space of the body. Only built on the fly by the mesh and heightfield queries, for GJK and EPA.
+struct ColliderTriangle
+{
+	XMVECTOR vertices[3];
+};
+
 enum class ColliderType
 {
 	SPHERE,
-	CONVEX_HULL
+	CONVEX_HULL,
+	BOX,
+	CAPSULE,
+	CYLINDER,
+	TRIANGLE_MESH,
+	HEIGHTFIELD,
+	TRIANGLE
 };
 
 struct Collider
@@ -46,14 +160,41 @@ struct Collider
 	{
 		ColliderConvexHull convexHull;
 		ColliderSphere sphere;
+		ColliderBox box;
+		ColliderCapsule capsule;
+		ColliderCylinder cylinder;
+		ColliderTriangleMesh triangleMesh;
+		ColliderHeightfield heightfield;
+		ColliderTriangle triangle;
 	};
+
+	// Pose of the body, set by UpdateColliders
+	XMVECTOR position;
+	XMVECTOR rotation;
 };
 
 Collider CreateColliderConvexHull(const std::vector<Vertex>& vertices, const std::vector<WORD>& indices);
 Collider CreateColliderSphere(const float radius);
+Collider CreateColliderBox(const XMFLOAT3& halfExtents);
+Collider CreateColliderCapsule(const float radius, const float halfHeight);
+Collider CreateColliderCylinder(const float radius, const float halfHeight);
+// Same input as a convex hull, for instance the meshes loaded by the shapes. Only for fixed bodies.
+Collider CreateColliderTriangleMesh(const std::vector<Vertex>& vertices, const std::vector<WORD>& indices);
+// Only for fixed bodies, see ColliderHeightfield for the layout of the heights
+Collider CreateColliderHeightfield(const std::vector<float>& heights, uint32_t numColumns, uint32_t numRows, float cellSize);
 
 void UpdateColliders(std::vector<Collider>& colliders, XMVECTOR translation, const XMVECTOR rotationQ);
+XMVECTOR GetColliderWorldPoint(const Collider* collider, FXMVECTOR localPoint);
+XMVECTOR GetColliderWorldDirection(const Collider* collider, FXMVECTOR localDirection);
+XMVECTOR GetColliderLocalDirection(const Collider* collider, FXMVECTOR direction);
+// Hull of CONVEX_HULL and BOX colliders, nullptr for the others
+const ColliderConvexHull* GetColliderConvexHull(const Collider* collider);
+// TRIANGLE_MESH and HEIGHTFIELD colliders, which are not convex and are only queried through their triangles
+bool IsColliderStaticGeometry(const Collider* collider);
 void DestroyColliders(std::vector<Collider>& colliders);
 XMMATRIX GetCollidersDefaultInertiaTensor(const std::vector<Collider>& colliders, float mass);
 float GetCollidersBoundingSphereRadius(const std::vector<Collider>& colliders);
-std::vector<ColliderContact> GetCollidersContacts(std::vector<Collider>& colliders1, std::vector<Collider>& colliders2);
\ No newline at end of file
+// pairCaches is either nullptr or one cache per collider pair, colliders1.size() * colliders2.size() of them.
+// Separated colliders closer than speculativeDistance get a contact between their closest points, with a negative penetration.
+void GetCollidersContacts(std::vector<Collider>& colliders1, std::vector<Collider>& colliders2, ColliderPairCache* pairCaches,
+	float speculativeDistance, PBDArenaVector<ColliderContact>& contacts);
\ No newline at end of file
@@ -0,0 +1,11 @@
+#pragma once
+
+#include "GJK.h"
+#include "BoxBox.h"
+
+// Narrowphase state of a collider pair, kept from frame to frame by the contact cache
+struct ColliderPairCache
+{
+	GJKCache gjk;
+	BoxBoxCache boxBox;
+};
\ No newline at end of file
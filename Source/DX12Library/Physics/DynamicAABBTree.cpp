@@ -0,0 +1,590 @@
+#include "DynamicAABBTree.h"
+
+static AABB combineAABBs(const AABB& a, const AABB& b)
+{
+	AABB result;
+	result.lowerBound = XMFLOAT3(fminf(a.lowerBound.x, b.lowerBound.x), fminf(a.lowerBound.y, b.lowerBound.y), fminf(a.lowerBound.z, b.lowerBound.z));
+	result.upperBound = XMFLOAT3(fmaxf(a.upperBound.x, b.upperBound.x), fmaxf(a.upperBound.y, b.upperBound.y), fmaxf(a.upperBound.z, b.upperBound.z));
+
+	return result;
+}
+
+// Surface area heuristic
+static float getAABBCost(const AABB& aabb)
+{
+	float dx = aabb.upperBound.x - aabb.lowerBound.x;
+	float dy = aabb.upperBound.y - aabb.lowerBound.y;
+	float dz = aabb.upperBound.z - aabb.lowerBound.z;
+
+	return 2.0f * (dx * dy + dy * dz + dz * dx);
+}
+
+static bool isLeaf(const DynamicAABBTreeNode* node)
+{
+	return AABB_TREE_NULL_NODE == node->child1;
+}
+
+AABB MakeAABB(FXMVECTOR center, float radius)
+{
+	AABB aabb;
+	aabb.lowerBound = XMFLOAT3(XMVectorGetX(center) - radius, XMVectorGetY(center) - radius, XMVectorGetZ(center) - radius);
+	aabb.upperBound = XMFLOAT3(XMVectorGetX(center) + radius, XMVectorGetY(center) + radius, XMVectorGetZ(center) + radius);
+
+	return aabb;
+}
+
+bool IsAABBOverlapping(const AABB& a, const AABB& b)
+{
+	return a.lowerBound.x <= b.upperBound.x && b.lowerBound.x <= a.upperBound.x
+		&& a.lowerBound.y <= b.upperBound.y && b.lowerBound.y <= a.upperBound.y
+		&& a.lowerBound.z <= b.upperBound.z && b.lowerBound.z <= a.upperBound.z;
+}
+
+bool IsAABBContaining(const AABB& outer, const AABB& inner)
+{
+	return outer.lowerBound.x <= inner.lowerBound.x && inner.upperBound.x <= outer.upperBound.x
+		&& outer.lowerBound.y <= inner.lowerBound.y && inner.upperBound.y <= outer.upperBound.y
+		&& outer.lowerBound.z <= inner.lowerBound.z && inner.upperBound.z <= outer.upperBound.z;
+}
+
+static int32_t allocateNode(DynamicAABBTree& tree)
+{
+	if (AABB_TREE_NULL_NODE == tree.freeList)
+	{
+		DynamicAABBTreeNode node;
+		node.parent = AABB_TREE_NULL_NODE;
+		node.height = -1;
+		tree.nodes.push_back(node);
+		tree.freeList = static_cast<int32_t>(tree.nodes.size() - 1);
+	}
+
+	int32_t nodeId = tree.freeList;
+	DynamicAABBTreeNode* node = &tree.nodes[nodeId];
+	tree.freeList = node->parent;
+
+	node->parent = AABB_TREE_NULL_NODE;
+	node->child1 = AABB_TREE_NULL_NODE;
+	node->child2 = AABB_TREE_NULL_NODE;
+	node->height = 0;
+	node->userData = 0;
+
+	return nodeId;
+}
+
+static void freeNode(DynamicAABBTree& tree, int32_t nodeId)
+{
+	tree.nodes[nodeId].parent = tree.freeList;
+	tree.nodes[nodeId].height = -1;
+	tree.freeList = nodeId;
+}
+
+// Rotates the subtree rooted at iA if it is imbalanced, and returns the new root of the subtree
+static int32_t balance(DynamicAABBTree& tree, int32_t iA)
+{
+	DynamicAABBTreeNode* A = &tree.nodes[iA];
+	if (true == isLeaf(A) || A->height < 2)
+	{
+		return iA;
+	}
+
+	int32_t iB = A->child1;
+	int32_t iC = A->child2;
+	DynamicAABBTreeNode* B = &tree.nodes[iB];
+	DynamicAABBTreeNode* C = &tree.nodes[iC];
+
+	int32_t balanceFactor = C->height - B->height;
+
+	// Rotate C up
+	if (1 < balanceFactor)
+	{
+		int32_t iF = C->child1;
+		int32_t iG = C->child2;
+		DynamicAABBTreeNode* F = &tree.nodes[iF];
+		DynamicAABBTreeNode* G = &tree.nodes[iG];
+
+		// Swap A and C
+		C->child1 = iA;
+		C->parent = A->parent;
+		A->parent = iC;
+
+		// A's old parent should point to C
+		if (AABB_TREE_NULL_NODE != C->parent)
+		{
+			if (tree.nodes[C->parent].child1 == iA)
+			{
+				tree.nodes[C->parent].child1 = iC;
+			}
+			else
+			{
+				tree.nodes[C->parent].child2 = iC;
+			}
+		}
+		else
+		{
+			tree.root = iC;
+		}
+
+		// Rotate
+		if (F->height > G->height)
+		{
+			C->child2 = iF;
+			A->child2 = iG;
+			G->parent = iA;
+			A->aabb = combineAABBs(B->aabb, G->aabb);
+			C->aabb = combineAABBs(A->aabb, F->aabb);
+
+			A->height = 1 + (B->height > G->height ? B->height : G->height);
+			C->height = 1 + (A->height > F->height ? A->height : F->height);
+		}
+		else
+		{
+			C->child2 = iG;
+			A->child2 = iF;
+			F->parent = iA;
+			A->aabb = combineAABBs(B->aabb, F->aabb);
+			C->aabb = combineAABBs(A->aabb, G->aabb);
+
+			A->height = 1 + (B->height > F->height ? B->height : F->height);
+			C->height = 1 + (A->height > G->height ? A->height : G->height);
+		}
+
+		return iC;
+	}
+
+	// Rotate B up
+	if (balanceFactor < -1)
+	{
+		int32_t iD = B->child1;
+		int32_t iE = B->child2;
+		DynamicAABBTreeNode* D = &tree.nodes[iD];
+		DynamicAABBTreeNode* E = &tree.nodes[iE];
+
+		// Swap A and B
+		B->child1 = iA;
+		B->parent = A->parent;
+		A->parent = iB;
+
+		// A's old parent should point to B
+		if (AABB_TREE_NULL_NODE != B->parent)
+		{
+			if (tree.nodes[B->parent].child1 == iA)
+			{
+				tree.nodes[B->parent].child1 = iB;
+			}
+			else
+			{
+				tree.nodes[B->parent].child2 = iB;
+			}
+		}
+		else
+		{
+			tree.root = iB;
+		}
+
+		// Rotate
+		if (D->height > E->height)
+		{
+			B->child2 = iD;
+			A->child1 = iE;
+			E->parent = iA;
+			A->aabb = combineAABBs(C->aabb, E->aabb);
+			B->aabb = combineAABBs(A->aabb, D->aabb);
+
+			A->height = 1 + (C->height > E->height ? C->height : E->height);
+			B->height = 1 + (A->height > D->height ? A->height : D->height);
+		}
+		else
+		{
+			B->child2 = iE;
+			A->child1 = iD;
+			D->parent = iA;
+			A->aabb = combineAABBs(C->aabb, D->aabb);
+			B->aabb = combineAABBs(A->aabb, E->aabb);
+
+			A->height = 1 + (C->height > D->height ? C->height : D->height);
+			B->height = 1 + (A->height > E->height ? A->height : E->height);
+		}
+
+		return iB;
+	}
+
+	return iA;
+}
+
+// Walks back to the root, refitting the boxes and balancing on the way
+static void refitAncestors(DynamicAABBTree& tree, int32_t index)
+{
+	while (AABB_TREE_NULL_NODE != index)
+	{
+		index = balance(tree, index);
+
+		DynamicAABBTreeNode* node = &tree.nodes[index];
+		const DynamicAABBTreeNode* child1 = &tree.nodes[node->child1];
+		const DynamicAABBTreeNode* child2 = &tree.nodes[node->child2];
+
+		node->height = 1 + (child1->height > child2->height ? child1->height : child2->height);
+		node->aabb = combineAABBs(child1->aabb, child2->aabb);
+
+		index = node->parent;
+	}
+}
+
+static void insertLeaf(DynamicAABBTree& tree, int32_t leaf)
+{
+	if (AABB_TREE_NULL_NODE == tree.root)
+	{
+		tree.root = leaf;
+		tree.nodes[leaf].parent = AABB_TREE_NULL_NODE;
+		return;
+	}
+
+	// Find the best sibling for this node
+	const AABB leafAABB = tree.nodes[leaf].aabb;
+	int32_t index = tree.root;
+	while (false == isLeaf(&tree.nodes[index]))
+	{
+		const DynamicAABBTreeNode* node = &tree.nodes[index];
+		int32_t child1 = node->child1;
+		int32_t child2 = node->child2;
+
+		float area = getAABBCost(node->aabb);
+		float combinedArea = getAABBCost(combineAABBs(node->aabb, leafAABB));
+
+		// Cost of creating a new parent for this node and the new leaf
+		float cost = 2.0f * combinedArea;
+
+		// Minimum cost of pushing the leaf further down the tree
+		float inheritanceCost = 2.0f * (combinedArea - area);
+
+		float cost1 = getAABBCost(combineAABBs(leafAABB, tree.nodes[child1].aabb)) + inheritanceCost;
+		if (false == isLeaf(&tree.nodes[child1]))
+		{
+			cost1 -= getAABBCost(tree.nodes[child1].aabb);
+		}
+
+		float cost2 = getAABBCost(combineAABBs(leafAABB, tree.nodes[child2].aabb)) + inheritanceCost;
+		if (false == isLeaf(&tree.nodes[child2]))
+		{
+			cost2 -= getAABBCost(tree.nodes[child2].aabb);
+		}
+
+		// Descend according to the minimum cost
+		if (cost < cost1 && cost < cost2)
+		{
+			break;
+		}
+
+		index = cost1 < cost2 ? child1 : child2;
+	}
+
+	int32_t sibling = index;
+
+	// Create a new parent (the allocation may move the nodes)
+	int32_t oldParent = tree.nodes[sibling].parent;
+	int32_t newParent = allocateNode(tree);
+	tree.nodes[newParent].parent = oldParent;
+	tree.nodes[newParent].aabb = combineAABBs(leafAABB, tree.nodes[sibling].aabb);
+	tree.nodes[newParent].height = tree.nodes[sibling].height + 1;
+	tree.nodes[newParent].child1 = sibling;
+	tree.nodes[newParent].child2 = leaf;
+	tree.nodes[sibling].parent = newParent;
+	tree.nodes[leaf].parent = newParent;
+
+	if (AABB_TREE_NULL_NODE != oldParent)
+	{
+		if (tree.nodes[oldParent].child1 == sibling)
+		{
+			tree.nodes[oldParent].child1 = newParent;
+		}
+		else
+		{
+			tree.nodes[oldParent].child2 = newParent;
+		}
+	}
+	else
+	{
+		tree.root = newParent;
+	}
+
+	refitAncestors(tree, tree.nodes[leaf].parent);
+}
+
+static void removeLeaf(DynamicAABBTree& tree, int32_t leaf)
+{
+	if (leaf == tree.root)
+	{
+		tree.root = AABB_TREE_NULL_NODE;
+		return;
+	}
+
+	int32_t parent = tree.nodes[leaf].parent;
+	int32_t grandParent = tree.nodes[parent].parent;
+	int32_t sibling = tree.nodes[parent].child1 == leaf ? tree.nodes[parent].child2 : tree.nodes[parent].child1;
+
+	freeNode(tree, parent);
+
+	if (AABB_TREE_NULL_NODE == grandParent)
+	{
+		tree.root = sibling;
+		tree.nodes[sibling].parent = AABB_TREE_NULL_NODE;
+		return;
+	}
+
+	// Destroy the parent and connect the sibling to the grand parent
+	if (tree.nodes[grandParent].child1 == parent)
+	{
+		tree.nodes[grandParent].child1 = sibling;
+	}
+	else
+	{
+		tree.nodes[grandParent].child2 = sibling;
+	}
+	tree.nodes[sibling].parent = grandParent;
+
+	refitAncestors(tree, grandParent);
+}
+
+int32_t CreateDynamicAABBTreeProxy(DynamicAABBTree& tree, const AABB& aabb, float margin, size_t userData)
+{
+	int32_t proxyId = allocateNode(tree);
+
+	DynamicAABBTreeNode* node = &tree.nodes[proxyId];
+	node->aabb.lowerBound = XMFLOAT3(aabb.lowerBound.x - margin, aabb.lowerBound.y - margin, aabb.lowerBound.z - margin);
+	node->aabb.upperBound = XMFLOAT3(aabb.upperBound.x + margin, aabb.upperBound.y + margin, aabb.upperBound.z + margin);
+	node->userData = userData;
+
+	insertLeaf(tree, proxyId);
+	++tree.numProxies;
+
+	return proxyId;
+}
+
+void DestroyDynamicAABBTreeProxy(DynamicAABBTree& tree, int32_t proxyId)
+{
+	assert(0 <= proxyId && proxyId < static_cast<int32_t>(tree.nodes.size()));
+	assert(true == isLeaf(&tree.nodes[proxyId]));
+
+	removeLeaf(tree, proxyId);
+	freeNode(tree, proxyId);
+	--tree.numProxies;
+}
+
+bool MoveDynamicAABBTreeProxy(DynamicAABBTree& tree, int32_t proxyId, const AABB& aabb, float margin, FXMVECTOR displacement)
+{
+	assert(0 <= proxyId && proxyId < static_cast<int32_t>(tree.nodes.size()));
+	assert(true == isLeaf(&tree.nodes[proxyId]));
+
+	if (true == IsAABBContaining(tree.nodes[proxyId].aabb, aabb))
+	{
+		return false;
+	}
+
+	// Extend the box in the direction of the motion
+	AABB fatAABB;
+	fatAABB.lowerBound = XMFLOAT3(aabb.lowerBound.x - margin, aabb.lowerBound.y - margin, aabb.lowerBound.z - margin);
+	fatAABB.upperBound = XMFLOAT3(aabb.upperBound.x + margin, aabb.upperBound.y + margin, aabb.upperBound.z + margin);
+
+	float dx = XMVectorGetX(displacement);
+	float dy = XMVectorGetY(displacement);
+	float dz = XMVectorGetZ(displacement);
+	if (dx < 0.0f) { fatAABB.lowerBound.x += dx; } else { fatAABB.upperBound.x += dx; }
+	if (dy < 0.0f) { fatAABB.lowerBound.y += dy; } else { fatAABB.upperBound.y += dy; }
+	if (dz < 0.0f) { fatAABB.lowerBound.z += dz; } else { fatAABB.upperBound.z += dz; }
+
+	removeLeaf(tree, proxyId);
+	tree.nodes[proxyId].aabb = fatAABB;
+	insertLeaf(tree, proxyId);
+
+	return true;
+}
+
+size_t GetDynamicAABBTreeUserData(const DynamicAABBTree& tree, int32_t proxyId)
+{
+	assert(0 <= proxyId && proxyId < static_cast<int32_t>(tree.nodes.size()));
+
+	return tree.nodes[proxyId].userData;
+}
+
+const AABB& GetDynamicAABBTreeFatAABB(const DynamicAABBTree& tree, int32_t proxyId)
+{
+	assert(0 <= proxyId && proxyId < static_cast<int32_t>(tree.nodes.size()));
+
+	return tree.nodes[proxyId].aabb;
+}
+
+int32_t GetDynamicAABBTreeHeight(const DynamicAABBTree& tree)
+{
+	if (AABB_TREE_NULL_NODE == tree.root)
+	{
+		return 0;
+	}
+
+	return tree.nodes[tree.root].height;
+}
+
+void QueryDynamicAABBTree(const DynamicAABBTree& tree, const AABB& aabb, const DynamicAABBTreeQueryCallback& callback)
+{
+	if (AABB_TREE_NULL_NODE == tree.root)
+	{
+		return;
+	}
+
+	PBDArenaVector<int32_t> stack;
+	stack.reserve(64);
+	stack.push_back(tree.root);
+
+	while (false == stack.empty())
+	{
+		int32_t nodeId = stack.back();
+		stack.pop_back();
+
+		const DynamicAABBTreeNode* node = &tree.nodes[nodeId];
+		if (false == IsAABBOverlapping(node->aabb, aabb))
+		{
+			continue;
+		}
+
+		if (true == isLeaf(node))
+		{
+			if (false == callback(nodeId))
+			{
+				return;
+			}
+		}
+		else
+		{
+			stack.push_back(node->child1);
+			stack.push_back(node->child2);
+		}
+	}
+}
+
+// Slab test of the segment p1 + t * d, t in [0, maxFraction]
+static bool isSegmentOverlappingAABB(const float p1[3], const float d[3], float maxFraction, const AABB& aabb)
+{
+	const float lower[3] = { aabb.lowerBound.x, aabb.lowerBound.y, aabb.lowerBound.z };
+	const float upper[3] = { aabb.upperBound.x, aabb.upperBound.y, aabb.upperBound.z };
+
+	float tMin = 0.0f;
+	float tMax = maxFraction;
+	for (size_t i = 0; i < 3; ++i)
+	{
+		if (fabsf(d[i]) < FLT_EPSILON)
+		{
+			if (p1[i] < lower[i] || upper[i] < p1[i])
+			{
+				return false;
+			}
+			continue;
+		}
+
+		float invD = 1.0f / d[i];
+		float t1 = (lower[i] - p1[i]) * invD;
+		float t2 = (upper[i] - p1[i]) * invD;
+		if (t2 < t1)
+		{
+			float temp = t1;
+			t1 = t2;
+			t2 = temp;
+		}
+
+		tMin = fmaxf(tMin, t1);
+		tMax = fminf(tMax, t2);
+		if (tMax < tMin)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void RayCastDynamicAABBTree(const DynamicAABBTree& tree, FXMVECTOR p1, FXMVECTOR p2, float maxFraction, const DynamicAABBTreeRayCastCallback& callback)
+{
+	if (AABB_TREE_NULL_NODE == tree.root)
+	{
+		return;
+	}
+
+	const float origin[3] = { XMVectorGetX(p1), XMVectorGetY(p1), XMVectorGetZ(p1) };
+	const float d[3] = { XMVectorGetX(p2) - origin[0], XMVectorGetY(p2) - origin[1], XMVectorGetZ(p2) - origin[2] };
+
+	PBDArenaVector<int32_t> stack;
+	stack.reserve(64);
+	stack.push_back(tree.root);
+
+	while (false == stack.empty())
+	{
+		int32_t nodeId = stack.back();
+		stack.pop_back();
+
+		const DynamicAABBTreeNode* node = &tree.nodes[nodeId];
+		if (false == isSegmentOverlappingAABB(origin, d, maxFraction, node->aabb))
+		{
+			continue;
+		}
+
+		if (true == isLeaf(node))
+		{
+			float value = callback(nodeId, maxFraction);
+			if (value <= 0.0f)
+			{
+				return;
+			}
+
+			maxFraction = fminf(maxFraction, value);
+		}
+		else
+		{
+			stack.push_back(node->child1);
+			stack.push_back(node->child2);
+		}
+	}
+}
+
+void GetDynamicAABBTreePairs(const DynamicAABBTree& tree, PBDArenaVector<std::pair<int32_t, int32_t>>& out)
+{
+	if (AABB_TREE_NULL_NODE == tree.root)
+	{
+		return;
+	}
+
+	PBDArenaVector<int32_t> stack;
+	stack.reserve(64);
+
+	// Query every leaf against the tree, keeping each pair only from its lower proxy
+	for (int32_t leaf = 0; leaf < static_cast<int32_t>(tree.nodes.size()); ++leaf)
+	{
+		const DynamicAABBTreeNode* leafNode = &tree.nodes[leaf];
+		if (0 != leafNode->height)
+		{
+			continue;
+		}
+
+		stack.push_back(tree.root);
+		while (false == stack.empty())
+		{
+			int32_t nodeId = stack.back();
+			stack.pop_back();
+
+			const DynamicAABBTreeNode* node = &tree.nodes[nodeId];
+			if (false == IsAABBOverlapping(node->aabb, leafNode->aabb))
+			{
+				continue;
+			}
+
+			if (true == isLeaf(node))
+			{
+				if (leaf < nodeId)
+				{
+					out.push_back(std::make_pair(leaf, nodeId));
+				}
+			}
+			else
+			{
+				stack.push_back(node->child1);
+				stack.push_back(node->child2);
+			}
+		}
+	}
+}
\ No newline at end of file
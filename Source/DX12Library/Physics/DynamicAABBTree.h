@@ -0,0 +1,68 @@
+#pragma once
+
+#include "Common.h"
+#include "PBDFrameArena.h"
+#include <functional>
+
+struct AABB
+{
+	XMFLOAT3 lowerBound;
+	XMFLOAT3 upperBound;
+};
+
+constexpr int32_t AABB_TREE_NULL_NODE = -1;
+
+struct DynamicAABBTreeNode
+{
+	// Fat AABB for leaves, union of the children for internal nodes
+	AABB aabb;
+
+	// Parent, or next free node when the node is in the free list
+	int32_t parent;
+	int32_t child1;
+	int32_t child2;
+
+	// Leaf = 0, free node = -1
+	int32_t height;
+
+	size_t userData;
+};
+
+// Incremental bounding volume hierarchy over fat AABBs (Box2D's b2DynamicTree).
+// Each proxy is a leaf whose box is enlarged by a margin, so that it only needs to be reinserted
+// once the object leaves it. The tree is kept balanced with AVL rotations.
+struct DynamicAABBTree
+{
+	std::vector<DynamicAABBTreeNode> nodes;
+	int32_t root = AABB_TREE_NULL_NODE;
+	int32_t freeList = AABB_TREE_NULL_NODE;
+	size_t numProxies = 0;
+};
+
+// Return false to stop the query
+typedef std::function<bool(int32_t proxyId)> DynamicAABBTreeQueryCallback;
+
+// Called for every proxy whose box is hit by the segment, with the current max fraction.
+// Return 0 to stop, a smaller fraction to clip the segment, or maxFraction to continue unchanged.
+typedef std::function<float(int32_t proxyId, float maxFraction)> DynamicAABBTreeRayCastCallback;
+
+AABB MakeAABB(FXMVECTOR center, float radius);
+bool IsAABBOverlapping(const AABB& a, const AABB& b);
+bool IsAABBContaining(const AABB& outer, const AABB& inner);
+
+int32_t CreateDynamicAABBTreeProxy(DynamicAABBTree& tree, const AABB& aabb, float margin, size_t userData);
+void DestroyDynamicAABBTreeProxy(DynamicAABBTree& tree, int32_t proxyId);
+
+// Returns true when the proxy left its fat box and had to be reinserted.
+// The fat box is extended by the displacement, so that moving objects are reinserted less often.
+bool MoveDynamicAABBTreeProxy(DynamicAABBTree& tree, int32_t proxyId, const AABB& aabb, float margin, FXMVECTOR displacement);
+
+size_t GetDynamicAABBTreeUserData(const DynamicAABBTree& tree, int32_t proxyId);
+const AABB& GetDynamicAABBTreeFatAABB(const DynamicAABBTree& tree, int32_t proxyId);
+int32_t GetDynamicAABBTreeHeight(const DynamicAABBTree& tree);
+
+void QueryDynamicAABBTree(const DynamicAABBTree& tree, const AABB& aabb, const DynamicAABBTreeQueryCallback& callback);
+void RayCastDynamicAABBTree(const DynamicAABBTree& tree, FXMVECTOR p1, FXMVECTOR p2, float maxFraction, const DynamicAABBTreeRayCastCallback& callback);
+
+// Every pair of proxies whose fat boxes overlap, reported once with proxyA < proxyB
+void GetDynamicAABBTreePairs(const DynamicAABBTree& tree, PBDArenaVector<std::pair<int32_t, int32_t>>& out);
\ No newline at end of file
@@ -1,241 +1,282 @@
 #include "EPA.h"
 #include "Support.h"
+#include <algorithm>
 
-void polytopeFromGJKSimplex(const GJKSimplex* s, std::vector<XMVECTOR>& polytope, std::vector<XMINT3>& faces)
+// Fixed capacity of the polytope, the expansion stops with the best estimate so far when it is reached
+constexpr size_t EPA_MAX_VERTICES = 128;
+constexpr size_t EPA_MAX_FACES = 512;
+constexpr size_t EPA_MAX_ITERATIONS = 64;
+
+// The expansion has converged when the support point is no further than this from the closest face
+constexpr float EPA_TOLERANCE = 0.0001f;
+
+// Faces the support point lies on are removed too, so that the new faces are not slivers
+constexpr float EPA_COPLANAR_TOLERANCE = -0.00001f;
+
+// Triangle of the polytope, wound counterclockwise seen from the outside.
+// Edge i goes from vertices[i] to vertices[(i + 1) % 3], and is shared with the face adjacentFaces[i], where it is edge adjacentEdges[i].
+struct EPAFace
 {
-	assert(s->num == 4);
-	polytope.reserve(4);
-	faces.reserve(4);
-
-	polytope.push_back(s->a);
-	polytope.push_back(s->b);
-	polytope.push_back(s->c);
-	polytope.push_back(s->d);
-
-	XMINT3 i1 = { 0, 1, 2 };	// ABC
-	XMINT3 i2 = { 0, 2, 3 };	// ACD
-	XMINT3 i3 = { 0, 3, 1 };	// ADB
-	XMINT3 i4 = { 1, 2, 3 };	// BCD
-
-	faces.push_back(i1);
-	faces.push_back(i2);
-	faces.push_back(i3);
-	faces.push_back(i4);
-}
+	XMVECTOR normal;
+	float distance;
+	uint16_t vertices[3];
+	uint16_t adjacentFaces[3];
+	uint8_t adjacentEdges[3];
+	bool bObsolete;
+};
+
+// Horizon edge, as the edge of the face that stays on the polytope
+struct EPAHorizonEdge
+{
+	uint16_t face;
+	uint8_t edge;
+};
 
-void getFaceNormalAndDistanceToOrigin(XMINT3 face, std::vector<XMVECTOR>& polytope, XMVECTOR* _normal, float* _distance)
+// Min-heap entry of the faces by distance. Faces removed from the polytope stay in the heap and are skipped when popped.
+struct EPAHeapEntry
 {
-	XMVECTOR a = polytope[face.x];
-	XMVECTOR b = polytope[face.y];
-	XMVECTOR c = polytope[face.z];
+	float distance;
+	uint16_t face;
 
-	XMVECTOR ab = b - a;
-	XMVECTOR ac = c - a;
-	XMVECTOR normal = XMVector3Normalize(XMVector3Cross(ab, ac));
+	bool operator>(const EPAHeapEntry& other) const { return distance > other.distance; }
+};
 
-	assert(XMVectorGetX(normal) != 0.0f || XMVectorGetY(normal) != 0.0f || XMVectorGetZ(normal) != 0.0f);
+struct EPAPolytope
+{
+	XMVECTOR vertices[EPA_MAX_VERTICES];
+	size_t numVertices;
 
-	// When this value is not 0, it is possible that the normals are not found even if the polytope is not degenerate
-	constexpr float DISTANCE_TO_ORIGIN_TOLERANCE = 0.0000000000000;
+	EPAFace faces[EPA_MAX_FACES];
+	size_t numFaces;
 
-	// distance from the face's plane to the origin (considering an infinite plane)
-	float distance = XMVectorGetX(XMVector3Dot(normal, a));
-	if (distance < -DISTANCE_TO_ORIGIN_TOLERANCE)
-	{
-		// if the distance is less than 0, it means that our normal is point inwards instead of outwards
-		// in this case, we just invert both normal and distance
-		// this way, we don't need to worry about face's winding
-		normal = -normal;
-		distance = -distance;
-	}
-	else if (-DISTANCE_TO_ORIGIN_TOLERANCE <= distance && distance <= DISTANCE_TO_ORIGIN_TOLERANCE)
-	{
-		// if the distance is exactly 0.0, then it means that the origin is lying exactly on the face.
-		// in this case, we can't directly infer the orientation of the normal.
-		// since our shape is convex, we analyze the other vertices of the hull to deduce the orientation
-		bool was_able_to_calculate_normal = false;
-		for (size_t i = 0; i < polytope.size(); ++i) {
-			XMVECTOR current = polytope[i];
-			float auxiliarDistance = XMVectorGetX(XMVector3Dot(normal, current));
-			if (auxiliarDistance < -DISTANCE_TO_ORIGIN_TOLERANCE || DISTANCE_TO_ORIGIN_TOLERANCE < auxiliarDistance)
-			{
-				// since the shape is convex, the other vertices should always be "behind" the normal plane
-				normal = auxiliarDistance < -DISTANCE_TO_ORIGIN_TOLERANCE ? normal : -normal;
-				was_able_to_calculate_normal = true;
-				break;
-			}
-		}
+	EPAHeapEntry heap[EPA_MAX_FACES];
+	size_t heapSize;
 
-		// If we were not able to calculate the normal, it means that ALL points of the polytope are in the same plane
-		// Therefore, we either have a degenerate polytope or our tolerance is not big enough
-		assert(true == was_able_to_calculate_normal);
-	}
+	// Each removed face adds at most one horizon edge
+	EPAHorizonEdge horizon[EPA_MAX_FACES];
+	size_t horizonSize;
+};
 
-	*_normal = normal;
-	*_distance = distance;
-}
-
-void addEdge(std::vector<XMINT2>& edges, XMINT2 edge, std::vector<XMVECTOR>& polytope)
+static bool addFace(EPAPolytope* polytope, uint16_t v0, uint16_t v1, uint16_t v2)
 {
-	for (size_t i = 0; i < edges.size(); ++i)
+	XMVECTOR a = polytope->vertices[v0];
+	XMVECTOR normal = XMVector3Cross(polytope->vertices[v1] - a, polytope->vertices[v2] - a);
+	float lengthSquared = XMVectorGetX(XMVector3LengthSq(normal));
+	if (lengthSquared < FLT_EPSILON * FLT_EPSILON)
 	{
-		XMINT2 current = edges[i];
-		if (edge.x == current.x && edge.y == current.y)
-		{
-			edges.erase(edges.begin() + i);
-			return;
-		}
-		if (edge.x == current.y && edge.y == current.x)
-		{
-			edges.erase(edges.begin() + i);
-			return;
-		}
+		// Degenerate triangle
+		return false;
+	}
 
-		XMVECTOR current_v1 = polytope[current.x];
-		XMVECTOR current_v2 = polytope[current.y];
-		XMVECTOR edge_v1 = polytope[edge.x];
-		XMVECTOR edge_v2 = polytope[edge.y];
+	EPAFace* face = &polytope->faces[polytope->numFaces];
+	face->normal = normal / sqrtf(lengthSquared);
+	face->distance = XMVectorGetX(XMVector3Dot(face->normal, a));
+	face->vertices[0] = v0;
+	face->vertices[1] = v1;
+	face->vertices[2] = v2;
+	face->bObsolete = false;
 
-		if (true == XMVector3Equal(current_v1, edge_v1) && true == XMVector3Equal(current_v2, edge_v2))
-		{
-			edges.erase(edges.begin() + i);
-			return;
-		}
-		if (true == XMVector3Equal(current_v1, edge_v2) && true == XMVector3Equal(current_v2, edge_v1))
-		{
-			edges.erase(edges.begin() + i);
-			return;
-		}
-	}
+	EPAHeapEntry entry = { face->distance, static_cast<uint16_t>(polytope->numFaces) };
+	polytope->heap[polytope->heapSize++] = entry;
+	std::push_heap(polytope->heap, polytope->heap + polytope->heapSize, std::greater<EPAHeapEntry>());
 
-	edges.push_back(edge);
+	++polytope->numFaces;
+	return true;
 }
 
-static XMVECTOR triangleCentroid(XMVECTOR p1, XMVECTOR p2, XMVECTOR p3)
+static void linkFaces(EPAPolytope* polytope, uint16_t face1, uint8_t edge1, uint16_t face2, uint8_t edge2)
 {
-	XMVECTOR centroid = p2 + p3 + p1;
-	centroid /= 3.0f;
-
-	return centroid;
+	polytope->faces[face1].adjacentFaces[edge1] = face2;
+	polytope->faces[face1].adjacentEdges[edge1] = edge2;
+	polytope->faces[face2].adjacentFaces[edge2] = face1;
+	polytope->faces[face2].adjacentEdges[edge2] = edge1;
 }
 
-bool EPA(Collider* collider1, Collider* collider2, GJKSimplex* simplex, XMVECTOR* _normal, float* _penetration)
+static bool polytopeFromGJKSimplex(const GJKSimplex* simplex, EPAPolytope* polytope)
 {
-	std::vector<XMVECTOR> polytope;
-	std::vector<XMINT3> faces;
+	assert(simplex->num == 4);
+
+	polytope->vertices[0] = simplex->a;
+	polytope->vertices[1] = simplex->b;
+	polytope->vertices[2] = simplex->c;
+	polytope->vertices[3] = simplex->d;
+	polytope->numVertices = 4;
+	polytope->numFaces = 0;
+	polytope->heapSize = 0;
+
+	// Wind the faces outwards
+	XMVECTOR a = simplex->a;
+	float volume = XMVectorGetX(XMVector3Dot(XMVector3Cross(simplex->b - a, simplex->c - a), simplex->d - a));
+	if (fabsf(volume) < FLT_EPSILON)
+	{
+		return false;
+	}
+	if (0.0f < volume)
+	{
+		polytope->vertices[1] = simplex->c;
+		polytope->vertices[2] = simplex->b;
+	}
 
-	// Build initial polytope from GJK simplex
-	polytopeFromGJKSimplex(simplex, polytope, faces);
+	// ABC, ADB, BDC, CDA
+	if (false == addFace(polytope, 0, 1, 2) || false == addFace(polytope, 0, 3, 1) ||
+		false == addFace(polytope, 1, 3, 2) || false == addFace(polytope, 2, 3, 0))
+	{
+		return false;
+	}
 
-	std::vector<XMVECTOR> normals;
-	normals.reserve(128);
-	std::vector<float> facesDistanceToOrigin;
-	facesDistanceToOrigin.reserve(128);
+	linkFaces(polytope, 0, 0, 1, 2);	// AB
+	linkFaces(polytope, 0, 1, 2, 2);	// BC
+	linkFaces(polytope, 0, 2, 3, 2);	// CA
+	linkFaces(polytope, 1, 0, 3, 1);	// AD
+	linkFaces(polytope, 1, 1, 2, 0);	// DB
+	linkFaces(polytope, 2, 1, 3, 0);	// DC
 
-	XMVECTOR minNormal = XMVectorZero();
-	float minDistance = FLT_MAX;
+	return true;
+}
 
-	for (size_t i = 0; i < faces.size(); ++i)
+// Removes the faces that the point can see, entering from the given edge, and collects the horizon edges in order
+static void buildHorizon(EPAPolytope* polytope, FXMVECTOR point, uint16_t faceIndex, uint8_t edgeIndex)
+{
+	// Explicit stack of (face, edge it was entered from, next edge to visit)
+	struct Visit
 	{
-		XMVECTOR normal;
-		float distance;
-		XMINT3 face = faces[i];
+		uint16_t face;
+		uint8_t edge;
+		uint8_t step;
+	};
+	Visit stack[EPA_MAX_FACES + 1];
+	size_t stackSize = 0;
+
+	stack[stackSize++] = { faceIndex, edgeIndex, 0 };
+	while (0 < stackSize)
+	{
+		Visit* visit = &stack[stackSize - 1];
+		EPAFace* face = &polytope->faces[visit->face];
+
+		if (0 == visit->step)
+		{
+			if (true == face->bObsolete)
+			{
+				--stackSize;
+				continue;
+			}
 
-		getFaceNormalAndDistanceToOrigin(face, polytope, &normal, &distance);
+			if (XMVectorGetX(XMVector3Dot(face->normal, point)) - face->distance < EPA_COPLANAR_TOLERANCE)
+			{
+				// The face stays, the edge it was entered from is on the horizon
+				polytope->horizon[polytope->horizonSize++] = { visit->face, visit->edge };
+				--stackSize;
+				continue;
+			}
 
-		normals.push_back(normal);
-		facesDistanceToOrigin.push_back(distance);
+			face->bObsolete = true;
+		}
 
-		if (distance < minDistance)
+		// Continue through the two other edges, in winding order so that the horizon comes out as a loop
+		if (2 <= visit->step)
 		{
-			minDistance = distance;
-			minNormal = normal;
+			--stackSize;
+			continue;
 		}
+
+		uint8_t edge = static_cast<uint8_t>((visit->edge + 1 + visit->step) % 3);
+		++visit->step;
+		stack[stackSize++] = { face->adjacentFaces[edge], face->adjacentEdges[edge], 0 };
 	}
+}
 
-	std::vector<XMINT2> edges;
-	edges.reserve(1024);
-	bool bConverged = false;
-	for (size_t it = 0; it < 100; ++it)
+bool EPA(Collider* collider1, Collider* collider2, GJKSimplex* simplex, XMVECTOR* _normal, float* _penetration)
+{
+	EPAPolytope polytope;
+	if (false == polytopeFromGJKSimplex(simplex, &polytope))
 	{
-		XMVECTOR supportPoint = SupportPointOfMinkowskiDifference(collider1, collider2, minNormal);
+		return false;
+	}
 
-		// If the support time lies on the face currently set as the closest to the origin, we are done.
-		float d = XMVectorGetX(XMVector3Dot(minNormal, supportPoint));
-		if (fabsf(d - minDistance) < FLT_EPSILON)
+	const EPAFace* closestFace = nullptr;
+	for (size_t it = 0; it < EPA_MAX_ITERATIONS; ++it)
+	{
+		// Closest face still on the polytope
+		closestFace = nullptr;
+		while (0 < polytope.heapSize)
 		{
-			*_normal = minNormal;
-			*_penetration = minDistance;
-			bConverged = true;
-
-			break;
+			std::pop_heap(polytope.heap, polytope.heap + polytope.heapSize, std::greater<EPAHeapEntry>());
+			const EPAFace* face = &polytope.faces[polytope.heap[--polytope.heapSize].face];
+			if (false == face->bObsolete)
+			{
+				closestFace = face;
+				break;
+			}
 		}
 
-		// Add new point to polytope
-		size_t newPointIndex = polytope.size();
-		polytope.push_back(supportPoint);
-
-		// Expand polytope
-		for (size_t i = 0; i < normals.size(); ++i)
+		if (nullptr == closestFace)
 		{
-			XMVECTOR normal = normals[i];
-			XMINT3 face = faces[i];
+			return false;
+		}
 
-			// If the face normal points towards the support point, we need to reconstruct it.
-			XMVECTOR centroid = triangleCentroid(polytope[face.x], polytope[face.y], polytope[face.z]);
-			if (0.0f < XMVectorGetX(XMVector3Dot(normal, supportPoint - centroid)))
-			{
-				XMINT3 face = faces[i];
+		XMVECTOR supportPoint = SupportPointOfMinkowskiDifference(collider1, collider2, closestFace->normal);
 
-				XMINT2 edge1 = { face.x, face.y };
-				XMINT2 edge2 = { face.y, face.z };
-				XMINT2 edge3 = { face.z, face.x };
+		// If the support point lies on the face currently set as the closest to the origin, we are done.
+		float d = XMVectorGetX(XMVector3Dot(closestFace->normal, supportPoint));
+		if (d - closestFace->distance < EPA_TOLERANCE)
+		{
+			break;
+		}
 
-				addEdge(edges, edge1, polytope);
-				addEdge(edges, edge2, polytope);
-				addEdge(edges, edge3, polytope);
+		// Out of room for the new vertex or its faces (at most one per horizon edge), keep the current estimate
+		if (EPA_MAX_VERTICES <= polytope.numVertices || EPA_MAX_FACES - polytope.numFaces < polytope.numVertices)
+		{
+			break;
+		}
 
-				// Relative order between the two arrays should be kept
-				faces.erase(faces.begin() + i);
-				facesDistanceToOrigin.erase(facesDistanceToOrigin.begin() + i);
-				normals.erase(normals.begin() + i);
+		uint16_t newVertex = static_cast<uint16_t>(polytope.numVertices);
+		polytope.vertices[polytope.numVertices++] = supportPoint;
 
-				--i;
-			}
+		// Remove the faces the support point can see, starting with the closest one
+		uint16_t closestFaceIndex = static_cast<uint16_t>(closestFace - polytope.faces);
+		polytope.faces[closestFaceIndex].bObsolete = true;
+		polytope.horizonSize = 0;
+		for (uint8_t e = 0; e < 3; ++e)
+		{
+			buildHorizon(&polytope, supportPoint, polytope.faces[closestFaceIndex].adjacentFaces[e], polytope.faces[closestFaceIndex].adjacentEdges[e]);
 		}
 
-		for (size_t i = 0; i < edges.size(); ++i)
+		// Fan of new faces from the horizon to the new vertex
+		size_t firstNewFace = polytope.numFaces;
+		bool bDegenerate = false;
+		for (size_t i = 0; i < polytope.horizonSize; ++i)
 		{
-			XMINT2 edge = edges[i];
-			XMINT3 newFace = { edge.x, edge.y, static_cast<int32_t>(newPointIndex) };
-			faces.push_back(newFace);
+			const EPAHorizonEdge* horizonEdge = &polytope.horizon[i];
+			const EPAFace* face = &polytope.faces[horizonEdge->face];
+			uint16_t v0 = face->vertices[horizonEdge->edge];
+			uint16_t v1 = face->vertices[(horizonEdge->edge + 1) % 3];
 
-			XMVECTOR newFaceNormal;
-			float newFaceDistance;
-			getFaceNormalAndDistanceToOrigin(newFace, polytope, &newFaceNormal, &newFaceDistance);
+			uint16_t newFace = static_cast<uint16_t>(polytope.numFaces);
+			if (false == addFace(&polytope, v1, v0, newVertex))
+			{
+				bDegenerate = true;
+				break;
+			}
 
-			normals.push_back(newFaceNormal);
-			facesDistanceToOrigin.push_back(newFaceDistance);
+			linkFaces(&polytope, newFace, 0, horizonEdge->face, horizonEdge->edge);
+			if (firstNewFace < newFace)
+			{
+				linkFaces(&polytope, newFace, 2, static_cast<uint16_t>(newFace - 1), 1);
+			}
 		}
 
-		minDistance = FLT_MAX;
-		for (size_t i = 0; i < facesDistanceToOrigin.size(); ++i)
+		if (true == bDegenerate || 0 == polytope.horizonSize)
 		{
-			float distance = facesDistanceToOrigin[i];
-			if (distance < minDistance)
-			{
-				minDistance = distance;
-				minNormal = normals[i];
-			}
+			// The polytope can't be expanded any further, the closest face is the best estimate
+			break;
 		}
 
-		edges.clear();
+		// Close the fan
+		linkFaces(&polytope, static_cast<uint16_t>(polytope.numFaces - 1), 1, static_cast<uint16_t>(firstNewFace), 2);
 	}
 
-	if (false == bConverged)
-	{
-		OutputDebugString(L"EPA didn't converge.\n");
-	}
+	*_normal = closestFace->normal;
+	*_penetration = closestFace->distance;
 
-	return bConverged;
+	return true;
 }
\ No newline at end of file
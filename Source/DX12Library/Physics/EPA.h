@@ -3,4 +3,7 @@
 #include "Common.h"
 #include "GJK.h"
 
+// Penetration normal and depth of two overlapping colliders, expanding the terminal simplex of GJKCollides.
+// The cost is bounded by a fixed number of iterations and a fixed-size polytope, when either runs out the closest face
+// found so far is returned. Returns false when the simplex is degenerate.
 bool EPA(Collider* collider1, Collider* collider2, GJKSimplex* simplex, XMVECTOR* normal, float* penetration);
\ No newline at end of file
@@ -404,11 +404,34 @@ static bool doSimplex(GJKSimplex* simplex, XMVECTOR* direction)
 	return false;
 }
 
-bool GJKCollides(Collider* collider1, Collider* collider2, GJKSimplex* _simplex)
+static void storeGJKCache(GJKCache* cache, const Collider* collider1, XMVECTOR direction)
+{
+	if (nullptr != cache)
+	{
+		cache->localDirection = GetColliderLocalDirection(collider1, direction);
+		cache->bValid = true;
+	}
+}
+
+bool GJKCollides(Collider* collider1, Collider* collider2, GJKSimplex* _simplex, GJKCache* cache)
 {
 	GJKSimplex simplex;
 
-	simplex.a = SupportPointOfMinkowskiDifference(collider1, collider2, XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f));
+	if (nullptr != cache && true == cache->bValid)
+	{
+		XMVECTOR cachedDirection = GetColliderWorldDirection(collider1, cache->localDirection);
+		simplex.a = SupportPointOfMinkowskiDifference(collider1, collider2, cachedDirection);
+
+		// The last separating direction still separates the pair
+		if (XMVectorGetX(XMVector3Dot(simplex.a, cachedDirection)) < 0.0f)
+		{
+			return false;
+		}
+	}
+	else
+	{
+		simplex.a = SupportPointOfMinkowskiDifference(collider1, collider2, XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f));
+	}
 	simplex.num = 1;
 
 	XMVECTOR direction = -simplex.a;
@@ -420,6 +443,7 @@ bool GJKCollides(Collider* collider1, Collider* collider2, GJKSimplex* _simplex)
 		if (XMVectorGetX(XMVector3Dot(nextPoint, direction)) < 0.0f)
 		{
 			// No intersection
+			storeGJKCache(cache, collider1, direction);
 			return false;
 		}
 
@@ -433,10 +457,324 @@ bool GJKCollides(Collider* collider1, Collider* collider2, GJKSimplex* _simplex)
 				*_simplex = simplex;
 			}
 
+			storeGJKCache(cache, collider1, direction);
 			return true;
 		}
 	}
 
 	OutputDebugString(L"GJK didn't converge.\n");
 	return false;
+}
+
+// Vertex of the simplex of the distance query, with the support points of both colliders that produced it
+struct GJKDistanceVertex
+{
+	XMVECTOR point1;
+	XMVECTOR point2;
+	XMVECTOR w;
+};
+
+// Spheres are reduced to their center and capsules to their segment, their radius is accounted for once the distance between the cores is known
+static XMVECTOR getCoreSupportPoint(Collider* collider, XMVECTOR direction)
+{
+	if (collider->type == ColliderType::SPHERE)
+	{
+		return collider->sphere.center;
+	}
+
+	if (collider->type == ColliderType::CAPSULE)
+	{
+		float halfHeight = XMVectorGetY(GetColliderLocalDirection(collider, direction)) < 0.0f ? -collider->capsule.halfHeight : collider->capsule.halfHeight;
+		return GetColliderWorldPoint(collider, XMVectorSet(0.0f, halfHeight, 0.0f, 0.0f));
+	}
+
+	return SupportPoint(collider, direction);
+}
+
+static float getCoreRadius(const Collider* collider)
+{
+	switch (collider->type)
+	{
+	case ColliderType::SPHERE:
+		return collider->sphere.radius;
+	case ColliderType::CAPSULE:
+		return collider->capsule.radius;
+	}
+
+	return 0.0f;
+}
+
+// Closest point to the origin of the triangle abc (Ericson, Real-Time Collision Detection 5.1.5).
+// The simplex is reduced to the vertices supporting the closest point, and weights receives their barycentric coordinates.
+static void getClosestPointOfTriangle(GJKDistanceVertex* vertices, uint32_t* num, float* weights)
+{
+	GJKDistanceVertex a = vertices[0];
+	GJKDistanceVertex b = vertices[1];
+	GJKDistanceVertex c = vertices[2];
+
+	XMVECTOR ab = b.w - a.w;
+	XMVECTOR ac = c.w - a.w;
+
+	float d1 = XMVectorGetX(XMVector3Dot(ab, -a.w));
+	float d2 = XMVectorGetX(XMVector3Dot(ac, -a.w));
+	if (d1 <= 0.0f && d2 <= 0.0f)
+	{
+		*num = 1;
+		weights[0] = 1.0f;
+		return;
+	}
+
+	float d3 = XMVectorGetX(XMVector3Dot(ab, -b.w));
+	float d4 = XMVectorGetX(XMVector3Dot(ac, -b.w));
+	if (0.0f <= d3 && d4 <= d3)
+	{
+		vertices[0] = b;
+		*num = 1;
+		weights[0] = 1.0f;
+		return;
+	}
+
+	float vc = d1 * d4 - d3 * d2;
+	if (vc <= 0.0f && 0.0f <= d1 && d3 <= 0.0f)
+	{
+		float v = d1 / (d1 - d3);
+		*num = 2;
+		weights[0] = 1.0f - v;
+		weights[1] = v;
+		return;
+	}
+
+	float d5 = XMVectorGetX(XMVector3Dot(ab, -c.w));
+	float d6 = XMVectorGetX(XMVector3Dot(ac, -c.w));
+	if (0.0f <= d6 && d5 <= d6)
+	{
+		vertices[0] = c;
+		*num = 1;
+		weights[0] = 1.0f;
+		return;
+	}
+
+	float vb = d5 * d2 - d1 * d6;
+	if (vb <= 0.0f && 0.0f <= d2 && d6 <= 0.0f)
+	{
+		float w = d2 / (d2 - d6);
+		vertices[1] = c;
+		*num = 2;
+		weights[0] = 1.0f - w;
+		weights[1] = w;
+		return;
+	}
+
+	float va = d3 * d6 - d5 * d4;
+	if (va <= 0.0f && 0.0f <= (d4 - d3) && 0.0f <= (d5 - d6))
+	{
+		float w = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+		vertices[0] = b;
+		vertices[1] = c;
+		*num = 2;
+		weights[0] = 1.0f - w;
+		weights[1] = w;
+		return;
+	}
+
+	float denominator = 1.0f / (va + vb + vc);
+	*num = 3;
+	weights[1] = vb * denominator;
+	weights[2] = vc * denominator;
+	weights[0] = 1.0f - weights[1] - weights[2];
+}
+
+// Reduces the simplex to the vertices supporting its closest point to the origin.
+// Returns false when the origin is inside the tetrahedron.
+static bool reduceDistanceSimplex(GJKDistanceVertex* vertices, uint32_t* num, float* weights)
+{
+	switch (*num)
+	{
+	case 1:
+		weights[0] = 1.0f;
+		return true;
+	case 2:
+	{
+		XMVECTOR ab = vertices[1].w - vertices[0].w;
+		float lengthSquared = XMVectorGetX(XMVector3Dot(ab, ab));
+		float t = 0.0f < lengthSquared ? XMVectorGetX(XMVector3Dot(-vertices[0].w, ab)) / lengthSquared : 0.0f;
+		if (t <= 0.0f)
+		{
+			*num = 1;
+			weights[0] = 1.0f;
+		}
+		else if (1.0f <= t)
+		{
+			vertices[0] = vertices[1];
+			*num = 1;
+			weights[0] = 1.0f;
+		}
+		else
+		{
+			weights[0] = 1.0f - t;
+			weights[1] = t;
+		}
+		return true;
+	}
+	case 3:
+		getClosestPointOfTriangle(vertices, num, weights);
+		return true;
+	case 4:
+	{
+		// Faces of the tetrahedron with the vertex opposite to each of them
+		static constexpr uint32_t faces[4][4] = { { 0, 1, 2, 3 }, { 0, 2, 3, 1 }, { 0, 3, 1, 2 }, { 1, 3, 2, 0 } };
+
+		GJKDistanceVertex bestVertices[3];
+		uint32_t bestNum = 0;
+		float bestWeights[3] = {};
+		float bestDistanceSquared = FLT_MAX;
+		for (size_t f = 0; f < 4; ++f)
+		{
+			XMVECTOR a = vertices[faces[f][0]].w;
+			XMVECTOR normal = XMVector3Cross(vertices[faces[f][1]].w - a, vertices[faces[f][2]].w - a);
+			float originSide = XMVectorGetX(XMVector3Dot(normal, -a));
+			float oppositeSide = XMVectorGetX(XMVector3Dot(normal, vertices[faces[f][3]].w - a));
+
+			// Only the faces separating the origin from the rest of the tetrahedron can hold the closest point
+			if (0.0f < originSide * oppositeSide && FLT_EPSILON < fabsf(oppositeSide))
+			{
+				continue;
+			}
+
+			GJKDistanceVertex faceVertices[3] = { vertices[faces[f][0]], vertices[faces[f][1]], vertices[faces[f][2]] };
+			uint32_t faceNum = 3;
+			float faceWeights[3];
+			getClosestPointOfTriangle(faceVertices, &faceNum, faceWeights);
+
+			XMVECTOR closest = XMVectorZero();
+			for (uint32_t i = 0; i < faceNum; ++i)
+			{
+				closest += faceWeights[i] * faceVertices[i].w;
+			}
+
+			float distanceSquared = XMVectorGetX(XMVector3LengthSq(closest));
+			if (distanceSquared < bestDistanceSquared)
+			{
+				bestDistanceSquared = distanceSquared;
+				bestNum = faceNum;
+				for (uint32_t i = 0; i < faceNum; ++i)
+				{
+					bestVertices[i] = faceVertices[i];
+					bestWeights[i] = faceWeights[i];
+				}
+			}
+		}
+
+		if (0 == bestNum)
+		{
+			return false;
+		}
+
+		*num = bestNum;
+		for (uint32_t i = 0; i < bestNum; ++i)
+		{
+			vertices[i] = bestVertices[i];
+			weights[i] = bestWeights[i];
+		}
+		return true;
+	}
+	}
+
+	assert(false);
+	return false;
+}
+
+bool GJKCoreDistance(Collider* collider1, Collider* collider2, GJKDistanceResult* result)
+{
+	constexpr float RELATIVE_TOLERANCE = 1e-5f;
+	constexpr float OVERLAP_DISTANCE_SQUARED = 1e-12f;
+
+	XMVECTOR direction = collider1->position - collider2->position;
+	if (XMVectorGetX(XMVector3LengthSq(direction)) < OVERLAP_DISTANCE_SQUARED)
+	{
+		direction = XMVectorSet(1.0f, 0.0f, 0.0f, 0.0f);
+	}
+
+	GJKDistanceVertex vertices[4];
+	float weights[4] = { 1.0f, 0.0f, 0.0f, 0.0f };
+	uint32_t num = 1;
+	vertices[0].point1 = getCoreSupportPoint(collider1, -direction);
+	vertices[0].point2 = getCoreSupportPoint(collider2, direction);
+	vertices[0].w = vertices[0].point1 - vertices[0].point2;
+
+	XMVECTOR closest = vertices[0].w;
+	for (size_t i = 0; i < 64; ++i)
+	{
+		float distanceSquared = XMVectorGetX(XMVector3LengthSq(closest));
+		if (distanceSquared < OVERLAP_DISTANCE_SQUARED)
+		{
+			return false;
+		}
+
+		// Search towards the origin from the closest point found so far
+		GJKDistanceVertex vertex;
+		vertex.point1 = getCoreSupportPoint(collider1, -closest);
+		vertex.point2 = getCoreSupportPoint(collider2, closest);
+		vertex.w = vertex.point1 - vertex.point2;
+
+		// No point of the Minkowski difference is significantly closer to the origin along this direction
+		if (distanceSquared - XMVectorGetX(XMVector3Dot(closest, vertex.w)) <= RELATIVE_TOLERANCE * distanceSquared)
+		{
+			break;
+		}
+
+		vertices[num++] = vertex;
+		if (false == reduceDistanceSimplex(vertices, &num, weights))
+		{
+			return false;
+		}
+
+		closest = XMVectorZero();
+		for (uint32_t j = 0; j < num; ++j)
+		{
+			closest += weights[j] * vertices[j].w;
+		}
+	}
+
+	XMVECTOR point1 = XMVectorZero();
+	XMVECTOR point2 = XMVectorZero();
+	for (uint32_t j = 0; j < num; ++j)
+	{
+		point1 += weights[j] * vertices[j].point1;
+		point2 += weights[j] * vertices[j].point2;
+	}
+
+	float coreDistance = XMVectorGetX(XMVector3Length(closest));
+	if (coreDistance < FLT_EPSILON)
+	{
+		return false;
+	}
+
+	result->distance = coreDistance;
+	result->point1 = point1;
+	result->point2 = point2;
+	result->normal = -closest / coreDistance;
+
+	return true;
+}
+
+bool GJKDistance(Collider* collider1, Collider* collider2, GJKDistanceResult* result)
+{
+	if (false == GJKCoreDistance(collider1, collider2, result))
+	{
+		return false;
+	}
+
+	float radius1 = getCoreRadius(collider1);
+	float radius2 = getCoreRadius(collider2);
+	result->distance -= radius1 + radius2;
+	if (result->distance <= 0.0f)
+	{
+		return false;
+	}
+
+	result->point1 += radius1 * result->normal;
+	result->point2 -= radius2 * result->normal;
+
+	return true;
 }
\ No newline at end of file
@@ -12,4 +12,27 @@ struct GJKSimplex
 	uint32_t num;
 };
 
-bool GJKCollides(Collider* collider1, Collider* collider2, GJKSimplex* simplex);
\ No newline at end of file
+// Search direction kept from one query of a collider pair to the next.
+// A separated pair is usually rejected by the first support point along it, an overlapping one starts next to its last simplex.
+struct GJKCache
+{
+	XMVECTOR localDirection;	// in the space of the first collider, so that it follows the pair as it rotates
+	bool bValid;
+};
+
+// cache may be nullptr
+bool GJKCollides(Collider* collider1, Collider* collider2, GJKSimplex* simplex, GJKCache* cache);
+
+struct GJKDistanceResult
+{
+	float distance;
+	XMVECTOR point1;	// closest point on the first collider
+	XMVECTOR point2;	// closest point on the second collider
+	XMVECTOR normal;	// from the first collider to the second one
+};
+
+// Closest points of two separated colliders. Returns false when they overlap.
+bool GJKDistance(Collider* collider1, Collider* collider2, GJKDistanceResult* result);
+
+// Same as GJKDistance for the cores of the colliders: the center of a sphere, the segment of a capsule, the collider itself otherwise.
+bool GJKCoreDistance(Collider* collider1, Collider* collider2, GJKDistanceResult* result);
\ No newline at end of file
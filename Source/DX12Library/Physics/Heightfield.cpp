@@ -0,0 +1,200 @@
+#include "Heightfield.h"
+#include "TriangleMesh.h"
+#include "Support.h"
+
+static float getHeightfieldOrigin(uint32_t numSamples, float cellSize)
+{
+	return -0.5f * static_cast<float>(numSamples - 1) * cellSize;
+}
+
+static XMVECTOR getHeightfieldVertex(const ColliderHeightfield* heightfield, uint32_t sample)
+{
+	uint32_t column = sample % heightfield->numColumns;
+	uint32_t row = sample / heightfield->numColumns;
+
+	return XMVectorSet(getHeightfieldOrigin(heightfield->numColumns, heightfield->cellSize) + static_cast<float>(column) * heightfield->cellSize,
+		heightfield->heights->at(sample),
+		getHeightfieldOrigin(heightfield->numRows, heightfield->cellSize) + static_cast<float>(row) * heightfield->cellSize, 0.0f);
+}
+
+// Samples of a triangle of a cell, wound so that its normal points up. The first triangle of the cell at (column, row) is
+// (column, row), (column, row + 1), (column + 1, row + 1) and the second one (column, row), (column + 1, row + 1), (column + 1, row).
+static void getHeightfieldTriangleSamples(uint32_t numColumns, uint32_t triangleIndex, uint32_t* samples)
+{
+	uint32_t cell = triangleIndex / 2;
+	uint32_t sample = cell / (numColumns - 1) * numColumns + cell % (numColumns - 1);
+
+	samples[0] = sample;
+	if (0 == triangleIndex % 2)
+	{
+		samples[1] = sample + numColumns;
+		samples[2] = sample + numColumns + 1;
+	}
+	else
+	{
+		samples[1] = sample + numColumns + 1;
+		samples[2] = sample + 1;
+	}
+}
+
+void BuildColliderHeightfield(ColliderHeightfield* heightfield, const std::vector<float>& heights, uint32_t numColumns, uint32_t numRows, float cellSize)
+{
+	assert(2 <= numColumns && 2 <= numRows);
+	assert(heights.size() == static_cast<size_t>(numColumns) * numRows);
+	assert(0.0f < cellSize);
+
+	heightfield->heights = new std::vector<float>(heights);
+	heightfield->numColumns = numColumns;
+	heightfield->numRows = numRows;
+	heightfield->cellSize = cellSize;
+
+	size_t numCells = static_cast<size_t>(numColumns - 1) * (numRows - 1);
+	heightfield->cells = new std::vector<ColliderHeightfieldCell>(numCells);
+
+	// Same creases as the triangle mesh of the grid
+	std::vector<XMVECTOR> vertices;
+	vertices.reserve(heights.size());
+	for (uint32_t i = 0; i < static_cast<uint32_t>(heights.size()); ++i)
+	{
+		vertices.push_back(getHeightfieldVertex(heightfield, i));
+	}
+
+	std::vector<uint32_t> indices(6 * numCells);
+	for (uint32_t i = 0; i < 2 * static_cast<uint32_t>(numCells); ++i)
+	{
+		getHeightfieldTriangleSamples(numColumns, i, &indices[3 * i]);
+	}
+
+	std::vector<uint8_t> activeEdges;
+	ComputeTriangleMeshActiveEdges(vertices, indices, &activeEdges);
+
+	heightfield->minHeight = FLT_MAX;
+	heightfield->maxHeight = -FLT_MAX;
+	for (size_t i = 0; i < numCells; ++i)
+	{
+		ColliderHeightfieldCell* cell = &heightfield->cells->at(i);
+		cell->minHeight = FLT_MAX;
+		cell->maxHeight = -FLT_MAX;
+		for (size_t j = 0; j < 6; ++j)
+		{
+			float height = heights[indices[6 * i + j]];
+			cell->minHeight = fminf(cell->minHeight, height);
+			cell->maxHeight = fmaxf(cell->maxHeight, height);
+		}
+		cell->activeEdges = static_cast<uint8_t>(activeEdges[2 * i] | (activeEdges[2 * i + 1] << 3));
+
+		heightfield->minHeight = fminf(heightfield->minHeight, cell->minHeight);
+		heightfield->maxHeight = fmaxf(heightfield->maxHeight, cell->maxHeight);
+	}
+}
+
+void DestroyColliderHeightfield(ColliderHeightfield* heightfield)
+{
+	delete heightfield->heights;
+	delete heightfield->cells;
+}
+
+// Range of the cells along an axis covered by [minimum, maximum], false when it misses the grid
+static bool getHeightfieldCellRange(uint32_t numSamples, float cellSize, float minimum, float maximum, uint32_t* first, uint32_t* last)
+{
+	float origin = getHeightfieldOrigin(numSamples, cellSize);
+	float end = origin + static_cast<float>(numSamples - 1) * cellSize;
+	if (maximum < origin || end < minimum)
+	{
+		return false;
+	}
+
+	float lastCell = static_cast<float>(numSamples - 2);
+	*first = static_cast<uint32_t>(fminf(fmaxf(floorf((minimum - origin) / cellSize), 0.0f), lastCell));
+	*last = static_cast<uint32_t>(fminf(fmaxf(floorf((maximum - origin) / cellSize), 0.0f), lastCell));
+	return true;
+}
+
+void QueryColliderHeightfield(const ColliderHeightfield* heightfield, FXMVECTOR localMin, FXMVECTOR localMax, PBDArenaVector<uint32_t>& triangles)
+{
+	float minY = XMVectorGetY(localMin);
+	float maxY = XMVectorGetY(localMax);
+	if (maxY < heightfield->minHeight || heightfield->maxHeight < minY)
+	{
+		return;
+	}
+
+	uint32_t firstColumn;
+	uint32_t lastColumn;
+	uint32_t firstRow;
+	uint32_t lastRow;
+	if (false == getHeightfieldCellRange(heightfield->numColumns, heightfield->cellSize, XMVectorGetX(localMin), XMVectorGetX(localMax), &firstColumn, &lastColumn) ||
+		false == getHeightfieldCellRange(heightfield->numRows, heightfield->cellSize, XMVectorGetZ(localMin), XMVectorGetZ(localMax), &firstRow, &lastRow))
+	{
+		return;
+	}
+
+	uint32_t numCellColumns = heightfield->numColumns - 1;
+	for (uint32_t row = firstRow; row <= lastRow; ++row)
+	{
+		for (uint32_t column = firstColumn; column <= lastColumn; ++column)
+		{
+			uint32_t cellIndex = row * numCellColumns + column;
+			const ColliderHeightfieldCell& cell = (*heightfield->cells)[cellIndex];
+			if (cell.maxHeight < minY || maxY < cell.minHeight)
+			{
+				continue;
+			}
+
+			triangles.push_back(2 * cellIndex);
+			triangles.push_back(2 * cellIndex + 1);
+		}
+	}
+}
+
+static void getHeightfieldTriangle(const Collider* heightfield, uint32_t triangleIndex, Collider* triangle, uint8_t* activeEdges)
+{
+	uint32_t samples[3];
+	getHeightfieldTriangleSamples(heightfield->heightfield.numColumns, triangleIndex, samples);
+
+	triangle->type = ColliderType::TRIANGLE;
+	for (size_t i = 0; i < 3; ++i)
+	{
+		triangle->triangle.vertices[i] = getHeightfieldVertex(&heightfield->heightfield, samples[i]);
+	}
+	triangle->position = heightfield->position;
+	triangle->rotation = heightfield->rotation;
+
+	*activeEdges = static_cast<uint8_t>((heightfield->heightfield.cells->at(triangleIndex / 2).activeEdges >> (3 * (triangleIndex % 2))) & 0x7);
+}
+
+void GetConvexHeightfieldContacts(Collider* convex, Collider* heightfield, float speculativeDistance, PBDArenaVector<ColliderContact>& contacts)
+{
+	assert(heightfield->type == ColliderType::HEIGHTFIELD);
+
+	XMVECTOR localMin;
+	XMVECTOR localMax;
+	GetSupportBox(convex, heightfield, fmaxf(speculativeDistance, 0.0f), &localMin, &localMax);
+
+	PBDArenaVector<uint32_t> triangles;
+	QueryColliderHeightfield(&heightfield->heightfield, localMin, localMax, triangles);
+
+	GetConvexTrianglesContacts(convex, triangles,
+		[heightfield](uint32_t triangleIndex, Collider* triangle, uint8_t* activeEdges)
+		{
+			getHeightfieldTriangle(heightfield, triangleIndex, triangle, activeEdges);
+		}, speculativeDistance, contacts);
+}
+
+bool GetConvexHeightfieldDistance(Collider* convex, Collider* heightfield, float maxDistance, GJKDistanceResult* result)
+{
+	assert(heightfield->type == ColliderType::HEIGHTFIELD);
+
+	XMVECTOR localMin;
+	XMVECTOR localMax;
+	GetSupportBox(convex, heightfield, maxDistance, &localMin, &localMax);
+
+	PBDArenaVector<uint32_t> triangles;
+	QueryColliderHeightfield(&heightfield->heightfield, localMin, localMax, triangles);
+
+	return GetConvexTrianglesDistance(convex, triangles,
+		[heightfield](uint32_t triangleIndex, Collider* triangle, uint8_t* activeEdges)
+		{
+			getHeightfieldTriangle(heightfield, triangleIndex, triangle, activeEdges);
+		}, maxDistance, result);
+}
\ No newline at end of file
@@ -0,0 +1,17 @@
+#pragma once
+
+#include "Collider.h"
+#include "GJK.h"
+
+void BuildColliderHeightfield(ColliderHeightfield* heightfield, const std::vector<float>& heights, uint32_t numColumns, uint32_t numRows, float cellSize);
+void DestroyColliderHeightfield(ColliderHeightfield* heightfield);
+
+// Triangles of the cells under the box given in the space of the heightfield, two per cell (2 * cell + 0 or 1)
+void QueryColliderHeightfield(const ColliderHeightfield* heightfield, FXMVECTOR localMin, FXMVECTOR localMax, PBDArenaVector<uint32_t>& triangles);
+
+// Contacts of a collider with the cells of a HEIGHTFIELD collider under it, the heightfield being the second collider of the contacts
+void GetConvexHeightfieldContacts(Collider* convex, Collider* heightfield, float speculativeDistance, PBDArenaVector<ColliderContact>& contacts);
+
+// Closest points of a collider and the triangles of a heightfield within maxDistance of it, result->distance is FLT_MAX when there are none.
+// Returns false when the collider overlaps the heightfield.
+bool GetConvexHeightfieldDistance(Collider* convex, Collider* heightfield, float maxDistance, GJKDistanceResult* result);
\ No newline at end of file
@@ -1,16 +1,26 @@
 #include "PBD.h"
-#include "Broad.h"
 #include "PBDBaseConstraint.h"
-
-static std::vector<Constraint>* copyConstraints(std::vector<Constraint>* constraints)
+#include "PBDConstraintBatches.h"
+#include "PBDContactSolver.h"
+#include "PBDContinuousCollision.h"
+#include "PBDGraphColoring.h"
+#include "PBDSleeping.h"
+#include "PBDSphereContacts.h"
+
+// Copies the external constraints of an island, with their lambdas reset
+static void copyConstraints(const std::vector<Constraint>* constraints, const uint32_t* indices, size_t numIndices,
+	PBDArenaVector<Constraint>* copiedConstraints)
 {
 	if (nullptr == constraints)
 	{
-		return new std::vector<Constraint>;
+		return;
 	}
 
-	std::vector<Constraint>* copiedConstraints = new std::vector<Constraint>;
-	std::copy(constraints->begin(), constraints->end(), copiedConstraints->begin());
+	copiedConstraints->reserve(numIndices);
+	for (size_t i = 0; i < numIndices; ++i)
+	{
+		copiedConstraints->push_back(constraints->at(indices[i]));
+	}
 
 	for (size_t i = 0; i < copiedConstraints->size(); ++i)
 	{
@@ -28,313 +38,887 @@ static std::vector<Constraint>* copyConstraints(std::vector<Constraint>* constra
 			break;
 		}
 	}
-
-	return copiedConstraints;
 }
 
-static void clippingContactToCollisionConstraint(std::shared_ptr<DX12Library::RigidBodyShape> s1, std::shared_ptr<DX12Library::RigidBodyShape> s2,
-	ColliderContact* contact, Constraint* constraint)
+static void clippingContactToCollisionConstraint(const PBDBodyStore& bodies, size_t s1, size_t s2, ColliderContact* contact, Constraint* constraint)
 {
 	constraint->type = ConstraintType::COLLISION_CONSTRAINT;
-	constraint->s1_id = s1->id;
-	constraint->s2_id = s2->id;
+	constraint->s1_id = bodies.slotToHandle[s1];
+	constraint->s2_id = bodies.slotToHandle[s2];
 	constraint->collision_constraint.normal = contact->collision_normal;
 	constraint->collision_constraint.lambda_t = 0.0f;
 	constraint->collision_constraint.lambda_n = 0.0f;
+	constraint->collision_constraint.lambda_n_warm = 0.0f;
+	constraint->collision_constraint.cached_contact = nullptr;
 
-	XMVECTOR r1_world = contact->collision_point1 - s1->worldPosition;
-	XMVECTOR r2_world = contact->collision_point2 - s2->worldPosition;
+	XMVECTOR r1_world = contact->collision_point1 - bodies.positions[s1];
+	XMVECTOR r2_world = contact->collision_point2 - bodies.positions[s2];
 
-	constraint->collision_constraint.r1_local = XMVector3InverseRotate(r1_world, s1->worldRotation);
-	constraint->collision_constraint.r2_local = XMVector3InverseRotate(r2_world, s2->worldRotation);
+	constraint->collision_constraint.r1_local = XMVector3InverseRotate(r1_world, bodies.rotations[s1]);
+	constraint->collision_constraint.r2_local = XMVector3InverseRotate(r2_world, bodies.rotations[s2]);
 }
 
-static void solvePositionalConstraint(Constraint* constraint, float h, std::unordered_map<size_t, std::shared_ptr<DX12Library::RigidBodyShape>>& shapes)
+static void solvePositionalConstraint(const PBDConstraintBodyPair& constraintBodies, PBDPositionalConstraintData* constraint, float h, PBDBodyStore& bodies)
 {
-	assert(constraint->type == ConstraintType::POSITIONAL_CONSTRAINT);
+	size_t s1 = constraintBodies.s1;
+	size_t s2 = constraintBodies.s2;
 
-	std::shared_ptr<DX12Library::RigidBodyShape> s1 = shapes[constraint->s1_id];
-	std::shared_ptr<DX12Library::RigidBodyShape> s2 = shapes[constraint->s2_id];
-
-	XMVECTOR attachmentDistance = s1->worldPosition - s2->worldPosition;
-	XMVECTOR delta_x = attachmentDistance - constraint->positional_constraint.distance;
+	XMVECTOR attachmentDistance = bodies.positions[s1] - bodies.positions[s2];
+	XMVECTOR delta_x = attachmentDistance - XMLoadFloat3(&constraint->distance);
 
 	PositionalConstraintPreprocessedData pcpd;
-	CalculatePositionalConstraintPreprocessedData(s1, s2, constraint->positional_constraint.r1_local, constraint->positional_constraint.r2_local, &pcpd);
-	float delta_lambda = GetPositionalConstraintDeltaLambda(&pcpd, h, constraint->positional_constraint.compliance, constraint->positional_constraint.lambda, delta_x);
-	ApplyPositionalConstraint(&pcpd, delta_lambda, delta_x);
-	constraint->positional_constraint.lambda += delta_lambda;
+	CalculatePositionalConstraintPreprocessedData(bodies, s1, s2, XMLoadFloat3(&constraint->r1_local), XMLoadFloat3(&constraint->r2_local), &pcpd);
+	float delta_lambda = GetPositionalConstraintDeltaLambda(bodies, &pcpd, h, constraint->compliance, constraint->lambda, delta_x);
+	ApplyPositionalConstraint(bodies, &pcpd, delta_lambda, delta_x);
+	constraint->lambda += delta_lambda;
 }
 
-static void solveCollisionConstraint(Constraint* constraint, float h, std::unordered_map<size_t, std::shared_ptr<DX12Library::RigidBodyShape>>& shapes)
+// Fixed bodies don't move, their colliders are updated once per step before the islands are simulated
+// Only the pose is copied, the narrowphase transforms the few hull points it looks at
+static void updateBodyColliders(PBDBodyStore& bodies, size_t s)
 {
-	assert(constraint->type == ConstraintType::COLLISION_CONSTRAINT);
+	if (0 != bodies.bFixed[s])
+	{
+		return;
+	}
 
-	std::shared_ptr<DX12Library::RigidBodyShape> s1 = shapes[constraint->s1_id];
-	std::shared_ptr<DX12Library::RigidBodyShape> s2 = shapes[constraint->s2_id];
+	UpdateColliders(bodies.shapes[s]->colliders, bodies.positions[s], bodies.rotations[s]);
+}
 
-	PositionalConstraintPreprocessedData pcpd;
-	CalculatePositionalConstraintPreprocessedData(s1, s2, constraint->collision_constraint.r1_local, constraint->collision_constraint.r2_local, &pcpd);
+static void refreshContactManifold(PBDBodyStore& bodies, size_t s1, size_t s2, float speculativeDistance, PBDContactManifold* manifold)
+{
+	DX12Library::RigidBodyShape* shape1 = bodies.shapes[s1];
+	DX12Library::RigidBodyShape* shape2 = bodies.shapes[s2];
+
+	updateBodyColliders(bodies, s1);
+	updateBodyColliders(bodies, s2);
 
-	// Calculate p1 and p2 in order to calculate d
-	XMVECTOR p1 = s1->worldPosition + pcpd.r1_world;
-	XMVECTOR p2 = s2->worldPosition + pcpd.r2_world;
-	float d = XMVectorGetX(XMVector3Dot(p1 - p2, constraint->collision_constraint.normal));
+	ColliderPairCache emptyPairCache = { GJKCache{ XMVectorZero(), false }, BoxBoxCache{ 0, false } };
+	manifold->pairCaches.resize(shape1->colliders.size() * shape2->colliders.size(), emptyPairCache);
 
-	if (0.0f < d)
+	PBDArenaVector<ColliderContact> contacts;
+	GetCollidersContacts(shape1->colliders, shape2->colliders, manifold->pairCaches.data(), speculativeDistance, contacts);
+
+	// The manifold is rebuilt in place so that it keeps its capacity from frame to frame
+	PBDArenaVector<PBDCachedContact> previousContacts(manifold->contacts.begin(), manifold->contacts.end());
+	manifold->contacts.clear();
+	for (size_t i = 0; i < contacts.size(); ++i)
 	{
-		XMVECTOR delta_x = d * constraint->collision_constraint.normal;
-		float delta_lambda = GetPositionalConstraintDeltaLambda(&pcpd, h, 0.0f, constraint->collision_constraint.lambda_n, delta_x);
-		ApplyPositionalConstraint(&pcpd, delta_lambda, delta_x);
-		constraint->collision_constraint.lambda_n += delta_lambda;
+		ColliderContact* contact = &contacts[i];
+		Constraint constraint;
+		clippingContactToCollisionConstraint(bodies, s1, s2, contact, &constraint);
+
+		PBDCachedContact cachedContact;
+		cachedContact.featureId = contact->feature_id;
+		cachedContact.r1_local = constraint.collision_constraint.r1_local;
+		cachedContact.r2_local = constraint.collision_constraint.r2_local;
+		cachedContact.normal_local = XMVector3InverseRotate(contact->collision_normal, bodies.rotations[s1]);
+		cachedContact.lambda_n = 0.0f;
+
+		// Carry the lambda of the same feature over
+		const PBDCachedContact* previousContact = FindPBDCachedContact(previousContacts.data(), previousContacts.size(), contact->feature_id);
+		if (nullptr != previousContact)
+		{
+			cachedContact.lambda_n = previousContact->lambda_n;
+		}
 
-		// Recalculate shape pair preprocessed data and p1, p2
-		CalculatePositionalConstraintPreprocessedData(s1, s2, constraint->collision_constraint.r1_local, constraint->collision_constraint.r2_local, &pcpd);
+		manifold->contacts.push_back(cachedContact);
+	}
 
-		p1 = s1->worldPosition + pcpd.r1_world;
-		p2 = s2->worldPosition + pcpd.r2_world;
+	manifold->bValid = true;
+}
 
-		delta_lambda = GetPositionalConstraintDeltaLambda(&pcpd, h, 0.0f, constraint->collision_constraint.lambda_t, delta_x);
+static void generateCollisionConstraints(PBDWorld& world, size_t s1, size_t s2, PBDArenaVector<Constraint>* constraints)
+{
+	PBDBodyStore& bodies = world.bodies;
 
-		// Static friction
-		const float staticFrictionCoefficient = (s1->staticFrictionCoefficient + s2->staticFrictionCoefficient) * 0.5f;
+	if (false == world.settings.bEnableContactCache)
+	{
+		DX12Library::RigidBodyShape* shape1 = bodies.shapes[s1];
+		DX12Library::RigidBodyShape* shape2 = bodies.shapes[s2];
 
-		float lambda_t = constraint->collision_constraint.lambda_t + delta_lambda;
-		float lambda_n = constraint->collision_constraint.lambda_n;
-		if (staticFrictionCoefficient * lambda_n < lambda_t)
-		{
-			XMVECTOR p1_til = s1->prevWorldPosition + XMVector3Rotate(constraint->collision_constraint.r1_local, s1->prevWorldRotation);
-			XMVECTOR p2_til = s2->prevWorldPosition + XMVector3Rotate(constraint->collision_constraint.r2_local, s2->prevWorldRotation);
-			XMVECTOR delta_p = (p1 - p1_til) - (p2 - p2_til);
-			XMVECTOR delta_p_t = delta_p - XMVectorGetX(XMVector3Dot(delta_p, constraint->collision_constraint.normal)) * constraint->collision_constraint.normal;
+		updateBodyColliders(bodies, s1);
+		updateBodyColliders(bodies, s2);
 
-			ApplyPositionalConstraint(&pcpd, delta_lambda, delta_p_t);
-			constraint->collision_constraint.lambda_t += delta_lambda;
+		PBDArenaVector<ColliderContact> contacts;
+		GetCollidersContacts(shape1->colliders, shape2->colliders, nullptr, world.settings.speculativeContactDistance, contacts);
+		for (size_t l = 0; l < contacts.size(); ++l)
+		{
+			ColliderContact* contact = &contacts[l];
+			Constraint constraint;
+			clippingContactToCollisionConstraint(bodies, s1, s2, contact, &constraint);
+			constraints->push_back(constraint);
 		}
+
+		return;
+	}
+
+	// The cached manifold is expressed for a fixed body order
+	if (bodies.slotToHandle[s2] < bodies.slotToHandle[s1])
+	{
+		size_t temp = s1;
+		s1 = s2;
+		s2 = temp;
+	}
+
+	PBDContactCache& cache = world.contactCache;
+	PBDContactManifold* manifold = FindOrCreatePBDContactManifold(cache, bodies.slotToHandle[s1], bodies.slotToHandle[s2]);
+
+	XMVECTOR relativePosition = XMVector3InverseRotate(bodies.positions[s2] - bodies.positions[s1], bodies.rotations[s1]);
+	XMVECTOR relativeRotation = XMQuaternionMultiply(bodies.rotations[s2], XMQuaternionInverse(bodies.rotations[s1]));
+
+	if (true == IsPBDContactManifoldReusable(manifold, relativePosition, relativeRotation,
+		world.settings.contactCacheLinearThreshold, world.settings.contactCacheAngularThreshold))
+	{
+		++cache.numNarrowphaseSkips;
+	}
+	else
+	{
+		++cache.numNarrowphaseRuns;
+
+		refreshContactManifold(bodies, s1, s2, world.settings.speculativeContactDistance, manifold);
+		manifold->relativePosition = relativePosition;
+		manifold->relativeRotation = relativeRotation;
+	}
+
+	for (size_t i = 0; i < manifold->contacts.size(); ++i)
+	{
+		PBDCachedContact* cachedContact = &manifold->contacts[i];
+
+		Constraint constraint;
+		constraint.type = ConstraintType::COLLISION_CONSTRAINT;
+		constraint.s1_id = bodies.slotToHandle[s1];
+		constraint.s2_id = bodies.slotToHandle[s2];
+		constraint.collision_constraint.r1_local = cachedContact->r1_local;
+		constraint.collision_constraint.r2_local = cachedContact->r2_local;
+		constraint.collision_constraint.normal = XMVector3Rotate(cachedContact->normal_local, bodies.rotations[s1]);
+		constraint.collision_constraint.lambda_t = 0.0f;
+		constraint.collision_constraint.lambda_n = 0.0f;
+		constraint.collision_constraint.lambda_n_warm = cachedContact->lambda_n;
+		constraint.collision_constraint.cached_contact = cachedContact;
+		constraints->push_back(constraint);
 	}
 }
 
-static void solveConstraint(Constraint* constraint, float h, std::unordered_map<size_t, std::shared_ptr<DX12Library::RigidBodyShape>>& shapes)
+static void storeCachedContactLambdas(PBDCollisionConstraintBatch& batch)
 {
-	switch (constraint->type)
+	for (size_t i = 0; i < batch.constraints.size(); ++i)
 	{
-	case ConstraintType::POSITIONAL_CONSTRAINT:
-		solvePositionalConstraint(constraint, h, shapes);
-		return;
-		break;
-	case ConstraintType::COLLISION_CONSTRAINT:
-		solveCollisionConstraint(constraint, h, shapes);
-		return;
-		break;
+		PBDCollisionConstraintData* constraint = &batch.constraints[i];
+		if (nullptr != constraint->cached_contact)
+		{
+			constraint->cached_contact->lambda_n = constraint->lambda_n;
+		}
 	}
-	
-	assert(false);
 }
 
-static void simulatePBDWithConstraints(float dt, std::unordered_map<size_t, std::shared_ptr<DX12Library::RigidBodyShape>>& shapes,
-	std::vector<Constraint>* externalConstraints, size_t numSubsteps, size_t numPosIters, bool bEnableCollision)
+static PBDJobSystem* getJobSystem(PBDWorld& world)
 {
-	if (dt <= 0.0f)
+	if (nullptr == world.jobSystem)
 	{
-		return;
+		size_t numThreads = 0 == world.settings.numThreads ? PBDJobSystem::GetDefaultNumThreads() : world.settings.numThreads;
+		world.jobSystem = std::make_unique<PBDJobSystem>(numThreads);
 	}
 
-	float h = dt / static_cast<float>(numSubsteps);
+	// The island tasks take the arena of the thread running them
+	while (world.frameArenas.size() < world.jobSystem->GetNumThreads())
+	{
+		world.frameArenas.push_back(std::make_unique<PBDFrameArena>());
+	}
 
-	std::vector<BroadCollisionPair> broadCollisionPairs;
-	GetBroadCollisionPairs(shapes, broadCollisionPairs);
+	return world.jobSystem.get();
+}
 
-	// Main loop of the PBD simulation
-	for (size_t i = 0; i < numSubsteps; ++i)
+static void solveJoint(const PBDJointBatch& batch, size_t k, float h, PBDJointStore& joints, PBDBodyStore& bodies)
+{
+	SolvePBDJoint(bodies, joints, batch.indices[k], batch.bodies[k].s1, batch.bodies[k].s2, h);
+}
+
+static void solveConstraintsSequential(PBDConstraintBatches& batches, float h, size_t numPosIters, PBDJointStore& joints, PBDBodyStore& bodies)
+{
+	PBDJointBatch& jointBatch = batches.joints;
+	PBDPositionalConstraintBatch& positional = batches.positional;
+	PBDCollisionConstraintBatch& collision = batches.collision;
+
+	for (size_t j = 0; j < numPosIters; ++j)
 	{
-		std::unordered_map<size_t, std::shared_ptr<DX12Library::RigidBodyShape>>::iterator shape;
-		for (shape = shapes.begin(); shape != shapes.end(); ++shape)
+		for (size_t k = 0; k < jointBatch.indices.size(); ++k)
 		{
-			std::shared_ptr<DX12Library::RigidBodyShape> s = shape->second;
+			solveJoint(jointBatch, k, h, joints, bodies);
+		}
+
+		for (size_t k = 0; k < positional.constraints.size(); ++k)
+		{
+			solvePositionalConstraint(positional.bodies[k], &positional.constraints[k], h, bodies);
+		}
+
+		for (size_t k = 0; k < collision.constraints.size(); ++k)
+		{
+			SolvePBDContactConstraint(bodies, collision.bodies[k], &collision.constraints[k], h);
+		}
+	}
+}
 
-			// Store the previous position and orientation of the shape
-			s->prevWorldPosition = s->worldPosition;
-			s->prevWorldRotation = s->worldRotation;
+static void solveConstraintsGraphColored(PBDConstraintBatches& batches, const PBDConstraintColoring& jointColoring,
+	const PBDConstraintColoring& positionalColoring, const PBDConstraintColoring& collisionColoring, float h, size_t numPosIters, PBDWorld& world)
+{
+	PBDBodyStore& bodies = world.bodies;
+	PBDJointStore& joints = world.joints;
+	PBDJobSystem* jobSystem = getJobSystem(world);
+	PBDJointBatch& jointBatch = batches.joints;
+	PBDPositionalConstraintBatch& positional = batches.positional;
+	PBDCollisionConstraintBatch& collision = batches.collision;
+
+	size_t numJointColors = GetPBDConstraintColorCount(&jointColoring);
+	size_t numPositionalColors = GetPBDConstraintColorCount(&positionalColoring);
+	size_t numCollisionColors = GetPBDConstraintColorCount(&collisionColoring);
+
+	// Constraints of the same color don't share any non-fixed body, so they can be solved in any order and on any thread
+	size_t colorBegin = 0;
+	PBDJobSystem::RangeJob solveJointColor = [&](size_t begin, size_t end, size_t threadIndex)
+		{
+			UNREFERENCED_PARAMETER(threadIndex);
 
-			if (true == s->bFixed || false == s->bActive)
+			for (size_t k = colorBegin + begin; k < colorBegin + end; ++k)
 			{
-				continue;
+				solveJoint(jointBatch, jointColoring.constraintIndices[k], h, joints, bodies);
 			}
+		};
+	PBDJobSystem::RangeJob solvePositionalColor = [&](size_t begin, size_t end, size_t threadIndex)
+		{
+			UNREFERENCED_PARAMETER(threadIndex);
 
-			// Calculate the external force and torque of the shape
-			XMVECTOR externalForce = XMVectorZero();
-			XMVECTOR externalTorque = XMVectorZero();
+			for (size_t k = colorBegin + begin; k < colorBegin + end; ++k)
 			{
-				const XMVECTOR centerOfMass = XMVectorZero();
-				for (size_t i = 0; i < s->forces.size(); ++i)
-				{
-					externalForce += s->forces[i].force;
+				size_t index = positionalColoring.constraintIndices[k];
+				solvePositionalConstraint(positional.bodies[index], &positional.constraints[index], h, bodies);
+			}
+		};
+	const bool bWideContacts = world.settings.bWideContactSolve;
+	const bool bVerifyWideContacts = world.settings.bVerifyWideContactSolve;
+	std::atomic<size_t> numWideContactMismatches{ 0 };
+	PBDJobSystem::RangeJob solveCollisionColor = [&](size_t begin, size_t end, size_t threadIndex)
+		{
+			UNREFERENCED_PARAMETER(threadIndex);
 
-					XMVECTOR distance = s->forces[i].position - centerOfMass;
-					externalTorque += XMVector3Cross(distance, s->forces[i].force);
+			const size_t* indices = collisionColoring.constraintIndices.data() + colorBegin + begin;
+			if (true == bVerifyWideContacts)
+			{
+				numWideContactMismatches += VerifyPBDContactConstraintsWide(bodies, collision, indices, end - begin, h,
+					world.settings.wideContactVerifyTolerance);
+			}
+			else if (true == bWideContacts)
+			{
+				SolvePBDContactConstraintsWide(bodies, collision, indices, end - begin);
+			}
+			else
+			{
+				for (size_t k = 0; k < end - begin; ++k)
+				{
+					SolvePBDContactConstraint(bodies, collision.bodies[indices[k]], &collision.constraints[indices[k]], h);
 				}
 			}
+		};
+
+	for (size_t j = 0; j < numPosIters; ++j)
+	{
+		for (size_t c = 0; c < numJointColors; ++c)
+		{
+			colorBegin = jointColoring.colorOffsets[c];
+			jobSystem->ParallelFor(jointColoring.colorOffsets[c + 1] - colorBegin, world.settings.constraintBatchSize, solveJointColor);
+		}
+
+		for (size_t k = jointColoring.sequentialOffset; k < jointBatch.indices.size(); ++k)
+		{
+			solveJoint(jointBatch, jointColoring.constraintIndices[k], h, joints, bodies);
+		}
+
+		for (size_t c = 0; c < numPositionalColors; ++c)
+		{
+			colorBegin = positionalColoring.colorOffsets[c];
+			jobSystem->ParallelFor(positionalColoring.colorOffsets[c + 1] - colorBegin, world.settings.constraintBatchSize, solvePositionalColor);
+		}
+
+		for (size_t k = positionalColoring.sequentialOffset; k < positional.constraints.size(); ++k)
+		{
+			size_t index = positionalColoring.constraintIndices[k];
+			solvePositionalConstraint(positional.bodies[index], &positional.constraints[index], h, bodies);
+		}
+
+		for (size_t c = 0; c < numCollisionColors; ++c)
+		{
+			colorBegin = collisionColoring.colorOffsets[c];
+			jobSystem->ParallelFor(collisionColoring.colorOffsets[c + 1] - colorBegin, world.settings.constraintBatchSize, solveCollisionColor);
+		}
+
+		for (size_t k = collisionColoring.sequentialOffset; k < collision.constraints.size(); ++k)
+		{
+			size_t index = collisionColoring.constraintIndices[k];
+			SolvePBDContactConstraint(bodies, collision.bodies[index], &collision.constraints[index], h);
+		}
+	}
+
+	world.lastStepWideContactMismatches += numWideContactMismatches;
+}
+
+// Velocity pass of a contact: dynamic friction and restitution
+static void solveCollisionVelocity(const PBDConstraintBodyPair& constraintBodies, const PBDCollisionConstraintData* constraint, float h, PBDBodyStore& bodies)
+{
+	size_t s1 = constraintBodies.s1;
+	size_t s2 = constraintBodies.s2;
+	XMVECTOR n = XMLoadFloat3(&constraint->normal);
+	float lambda_n = constraint->lambda_n;
+
+	// Speculative contacts that never touched during the solve don't affect the velocities
+	if (0.0f == lambda_n)
+	{
+		return;
+	}
+
+	PositionalConstraintPreprocessedData pcpd;
+	CalculatePositionalConstraintPreprocessedData(bodies, s1, s2, XMLoadFloat3(&constraint->r1_local), XMLoadFloat3(&constraint->r2_local), &pcpd);
+
+	XMVECTOR v1 = bodies.linearVelocities[s1];
+	XMVECTOR w1 = bodies.angularVelocities[s1];
+	XMVECTOR v2 = bodies.linearVelocities[s2];
+	XMVECTOR w2 = bodies.angularVelocities[s2];
+
+	// Calculate the relative normal and tangential velocities at the contact point
+	XMVECTOR v = (v1 + XMVector3Cross(w1, pcpd.r1_world)) - (v2 + XMVector3Cross(w2, pcpd.r2_world));
+	float vn = XMVectorGetX(XMVector3Dot(n, v));
+	XMVECTOR vt = v - vn * n;
+
+	// delta_v stores the velocity change
+	XMVECTOR delta_v = XMVectorZero();
+
+	// Coulomb's dynamic friction
+	const float dynamicFrictionCoefficient = (bodies.dynamicFrictionCoefficients[s1] + bodies.dynamicFrictionCoefficients[s2]) * 0.5f;
+	float fn = lambda_n / h;
+	float fact = fminf(dynamicFrictionCoefficient * fabsf(fn), XMVectorGetX(XMVector3Length(vt)));
+	delta_v += -fact * XMVector3Normalize(vt);
+
+	// Restitution
+	XMVECTOR old_v1 = bodies.prevLinearVelocities[s1];
+	XMVECTOR old_w1 = bodies.prevAngularVelocities[s1];
+	XMVECTOR old_v2 = bodies.prevLinearVelocities[s2];
+	XMVECTOR old_w2 = bodies.prevAngularVelocities[s2];
+	XMVECTOR v_til = (old_v1 - XMVector3Cross(old_w1, pcpd.r1_world)) - (old_v2 - XMVector3Cross(old_w2, pcpd.r2_world));
+	float vn_til = XMVectorGetX(XMVector3Dot(n, v_til));
+	float e = bodies.restitutionCoefficients[s1] * bodies.restitutionCoefficients[s2];
+	fact = -vn + fminf(-e * vn_til, 0.0f);
+	delta_v += fact * n;
+
+	// Applying delta_v considering the inverse masses of both shapes
+	float _w1 = GetPBDBodyGeneralizedInverseMass(bodies, s1, pcpd.r1_world, n);
+	float _w2 = GetPBDBodyGeneralizedInverseMass(bodies, s2, pcpd.r2_world, n);
+	XMVECTOR p = (1.0f / (_w1 + _w2)) * delta_v;
+
+	if (0 == bodies.bFixed[s1])
+	{
+		bodies.linearVelocities[s1] += bodies.inverseMasses[s1] * p;
+		bodies.angularVelocities[s1] += TransformPBDSymmetricMatrix3(bodies.worldInverseInertiaTensors[s1], XMVector3Cross(pcpd.r1_world, p));
+	}
+	if (0 == bodies.bFixed[s2])
+	{
+		bodies.linearVelocities[s2] -= bodies.inverseMasses[s2] * p;
+		bodies.angularVelocities[s2] -= TransformPBDSymmetricMatrix3(bodies.worldInverseInertiaTensors[s2], XMVector3Cross(pcpd.r2_world, p));
+	}
+}
+
+// Contacts of the same color don't share any non-fixed body, so their velocities can also be solved concurrently
+static void solveVelocitiesGraphColored(const PBDCollisionConstraintBatch& collision, const PBDConstraintColoring& coloring, float h, PBDWorld& world)
+{
+	PBDBodyStore& bodies = world.bodies;
+	PBDJobSystem* jobSystem = getJobSystem(world);
+	size_t numColors = GetPBDConstraintColorCount(&coloring);
+
+	size_t colorBegin = 0;
+	PBDJobSystem::RangeJob solveColor = [&](size_t begin, size_t end, size_t threadIndex)
+		{
+			UNREFERENCED_PARAMETER(threadIndex);
+
+			for (size_t k = colorBegin + begin; k < colorBegin + end; ++k)
+			{
+				size_t index = coloring.constraintIndices[k];
+				solveCollisionVelocity(collision.bodies[index], &collision.constraints[index], h, bodies);
+			}
+		};
 
-			// Update the shape position and linear velocity based on the current velocity and applied forces
-			s->linearVelocity += h * s->inverseMass * externalForce;
-			s->worldPosition += h * s->linearVelocity;
+	for (size_t c = 0; c < numColors; ++c)
+	{
+		colorBegin = coloring.colorOffsets[c];
+		jobSystem->ParallelFor(coloring.colorOffsets[c + 1] - colorBegin, world.settings.constraintBatchSize, solveColor);
+	}
+
+	for (size_t k = coloring.sequentialOffset; k < collision.constraints.size(); ++k)
+	{
+		size_t index = coloring.constraintIndices[k];
+		solveCollisionVelocity(collision.bodies[index], &collision.constraints[index], h, bodies);
+	}
+}
+
+// Integrates the velocities and poses of the given bodies over a substep, from the external forces and gravity.
+// Every body only touches its own slot, so disjoint ranges can be integrated concurrently.
+static void predictBodies(PBDBodyStore& bodies, const uint32_t* slots, size_t count, float h, FXMVECTOR gravity)
+{
+	for (size_t b = 0; b < count; ++b)
+	{
+		size_t s = slots[b];
 
-			// Update the shape orientation and angular velocity based on the current velocity and applied torques
-			s->angularVelocity += h * XMVector3Transform(externalTorque - XMVector3Cross(s->angularVelocity,
-				XMVector3Transform(s->angularVelocity, s->GetDynamicInertiaTensor())), s->GetDynamicInverseInertiaTensor());
-			XMVECTOR angularQ = XMVectorSet(XMVectorGetX(s->angularVelocity), XMVectorGetY(s->angularVelocity), XMVectorGetZ(s->angularVelocity), 0.0f);
-			XMVECTOR q = XMQuaternionMultiply(angularQ, s->worldRotation);
-			s->worldRotation += h * 0.5f * q;
-			s->worldRotation = XMQuaternionNormalize(s->worldRotation);
+		// Store the previous position and orientation of the shape
+		bodies.prevPositions[s] = bodies.positions[s];
+		bodies.prevRotations[s] = bodies.rotations[s];
+
+		if (false == IsPBDBodySimulated(bodies, s))
+		{
+			continue;
+		}
+
+		// The external force and torque of the shape were accumulated before the substeps
+		XMVECTOR externalForce = bodies.externalForces[s];
+		XMVECTOR externalTorque = bodies.externalTorques[s];
+
+		// Update the shape position and linear velocity based on the current velocity and applied forces
+		bodies.linearVelocities[s] += h * (gravity + bodies.inverseMasses[s] * externalForce);
+		bodies.positions[s] += h * bodies.linearVelocities[s];
+
+		// Update the shape orientation and angular velocity based on the current velocity and applied torques
+		XMVECTOR angularVelocity = bodies.angularVelocities[s];
+		angularVelocity += h * TransformPBDSymmetricMatrix3(bodies.worldInverseInertiaTensors[s], externalTorque - XMVector3Cross(angularVelocity,
+			XMVector3Transform(angularVelocity, GetPBDBodyDynamicInertiaTensor(bodies, s))));
+		bodies.angularVelocities[s] = angularVelocity;
+
+		XMVECTOR angularQ = XMVectorSelect(XMVectorZero(), angularVelocity, g_XMSelect1110);
+		XMVECTOR q = XMQuaternionMultiply(angularQ, bodies.rotations[s]);
+		bodies.rotations[s] += h * 0.5f * q;
+		bodies.rotations[s] = XMQuaternionNormalize(bodies.rotations[s]);
+
+		// The only refresh of the substep, the constraint corrections read the tensor of the predicted rotation
+		UpdatePBDBodyWorldInverseInertia(bodies, s);
+	}
+}
+
+// Derives the velocities of the given bodies from their motion during the substep
+static void updateBodyVelocities(PBDBodyStore& bodies, const uint32_t* slots, size_t count, float h)
+{
+	for (size_t b = 0; b < count; ++b)
+	{
+		size_t s = slots[b];
+
+		if (false == IsPBDBodySimulated(bodies, s))
+		{
+			continue;
 		}
 
-		// Create the constraints array
-		std::vector<Constraint>* constraints = copyConstraints(externalConstraints);
+		// Storing the current velocity for the velocity solver
+		bodies.prevLinearVelocities[s] = bodies.linearVelocities[s];
+		bodies.prevAngularVelocities[s] = bodies.angularVelocities[s];
+
+		// Update linear velocity based on the position difference
+		bodies.linearVelocities[s] = (1.0f / h) * (bodies.positions[s] - bodies.prevPositions[s]);
+
+		// Update angular velocity based on the orientation difference, taking the shortest arc
+		XMVECTOR invQ = XMQuaternionInverse(bodies.prevRotations[s]);
+		XMVECTOR delta_q = XMQuaternionMultiply(bodies.rotations[s], invQ);
+		float angularScale = 0.0f <= XMVectorGetW(delta_q) ? 2.0f / h : -2.0f / h;
+		bodies.angularVelocities[s] = angularScale * XMVectorSelect(XMVectorZero(), delta_q, g_XMSelect1110);
+	}
+}
+
+// Runs a per-body pass over the bodies of an island, split across the threads in chunks of PBDSettings::bodyBatchSize when bParallel is set
+static void forEachIslandBodyRange(PBDWorld& world, const PBDIslandRange& island, bool bParallel, const PBDJobSystem::RangeJob& job)
+{
+	if (true == bParallel)
+	{
+		getJobSystem(world)->ParallelFor(island.numBodies, world.settings.bodyBatchSize, job);
+	}
+	else
+	{
+		job(0, island.numBodies, 0);
+	}
+}
+
+// Runs the substeps over the bodies of one island.
+// Islands share no non-fixed body, so different islands can be simulated concurrently as long as bParallelSolve is false.
+static void simulateIsland(float h, PBDWorld& world, const std::vector<Constraint>* externalConstraints,
+	const PBDArenaVector<BroadCollisionPair>& broadCollisionPairs, const PBDIslandRange& island,
+	size_t numSubsteps, size_t numPosIters, bool bEnableCollision, bool bParallelSolve)
+{
+	PBDBodyStore& bodies = world.bodies;
+	const XMVECTOR gravity = XMLoadFloat3(&world.settings.gravity);
+
+	const bool bBatchSpheres = world.settings.bBatchSphereContacts;
+	PBDArenaVector<uint32_t> sphereSlots1;
+	PBDArenaVector<uint32_t> sphereSlots2;
+	PBDArenaVector<Constraint> constraints;
+	PBDConstraintBatches batches;
+
+	// The graph colored solver runs every pass of the substeps across the threads
+	const bool bGraphColored = true == bParallelSolve && PBDSolverMode::GRAPH_COLORED_PARALLEL == world.settings.solverMode;
+	PBDConstraintColoring jointColoring;
+	PBDConstraintColoring positionalColoring;
+	PBDConstraintColoring collisionColoring;
+
+	// The joints are solved in place in the joint store, and they keep their bodies and colors for the whole step
+	PBDJointStore& joints = world.joints;
+	BuildPBDJointBatch(bodies, joints, island.joints, island.numJoints, &batches.joints);
+	if (true == bGraphColored)
+	{
+		ColorPBDConstraints(bodies, batches.joints.bodies, &jointColoring);
+	}
+
+	// Main loop of the PBD simulation
+	for (size_t i = 0; i < numSubsteps; ++i)
+	{
+		// Integrate the bodies without the constraints
+		forEachIslandBodyRange(world, island, bGraphColored, [&](size_t begin, size_t end, size_t threadIndex)
+			{
+				UNREFERENCED_PARAMETER(threadIndex);
+
+				predictBodies(bodies, island.bodies + begin, end - begin, h, gravity);
+			});
+
+		// Reset the lambdas of the joints, like the ones of the copied external constraints
+		for (size_t j = 0; j < island.numJoints; ++j)
+		{
+			joints.positionalLambdas[island.joints[j]] = 0.0f;
+			joints.angularLambdas[island.joints[j]] = 0.0f;
+		}
+
+		// Create the constraints array, reusing the storage of the previous substep
+		constraints.clear();
+		copyConstraints(externalConstraints, island.constraints, island.numConstraints, &constraints);
 
 		// In each substep we need to check for collisions
 		if (true == bEnableCollision)
 		{
-			for (size_t j = 0; j < broadCollisionPairs.size(); ++j)
+			for (size_t j = 0; j < island.numPairs; ++j)
 			{
-				std::shared_ptr<DX12Library::RigidBodyShape> s1 = shapes[broadCollisionPairs[j].s1_id];
-				std::shared_ptr<DX12Library::RigidBodyShape> s2 = shapes[broadCollisionPairs[j].s2_id];
+				const BroadCollisionPair* pair = &broadCollisionPairs[island.pairs[j]];
+				size_t s1 = GetPBDBodySlot(bodies, pair->s1_id);
+				size_t s2 = GetPBDBodySlot(bodies, pair->s2_id);
 
 				// If e1 is "colliding" with e2, they must be either both active or both inactive
-				if (!s1->bFixed && !s2->bFixed) {
-					assert((s1->bActive && s2->bActive) || (!s1->bActive && !s2->bActive));
+				if (0 == bodies.bFixed[s1] && 0 == bodies.bFixed[s2]) {
+					assert(bodies.bActive[s1] == bodies.bActive[s2]);
 				}
 
 				// No need to solve the collision if both entities are either inactive or fixed
-				if ((s1->bFixed || !s1->bActive) && (s2->bFixed || !s2->bActive)) {
+				if (false == IsPBDBodySimulated(bodies, s1) && false == IsPBDBodySimulated(bodies, s2)) {
+					continue;
+				}
+
+				bool bContinuous = true == world.settings.bEnableContinuousCollision &&
+					true == IsPBDPairMovingFast(bodies, s1, s2, world.settings.continuousCollisionMotionRatio);
+
+				// Sphere pairs are batched below
+				if (false == bContinuous && true == bBatchSpheres && 0 != bodies.bSingleSphere[s1] && 0 != bodies.bSingleSphere[s2])
+				{
+					sphereSlots1.push_back(static_cast<uint32_t>(s1));
+					sphereSlots2.push_back(static_cast<uint32_t>(s2));
 					continue;
 				}
 
-				UpdateColliders(s1->colliders, s1->worldPosition, s1->worldRotation);
-				UpdateColliders(s2->colliders, s2->worldPosition, s2->worldRotation);
+				size_t numConstraints = constraints.size();
+				generateCollisionConstraints(world, s1, s2, &constraints);
 
-				std::vector<ColliderContact> contacts = GetCollidersContacts(s1->colliders, s2->colliders);
-				for (size_t l = 0; l < contacts.size(); ++l)
+				// A fast pair that ended the substep apart may have crossed on the way
+				Constraint timeOfImpactConstraint;
+				if (true == bContinuous && numConstraints == constraints.size() &&
+					true == GetPBDTimeOfImpactConstraint(bodies, s1, s2, &timeOfImpactConstraint))
 				{
-					ColliderContact* contact = &contacts[l];
-					Constraint constraint;
-					clippingContactToCollisionConstraint(s1, s2, contact, &constraint);
-					constraints->push_back(constraint);
+					constraints.push_back(timeOfImpactConstraint);
 				}
 			}
+
+			GenerateSphereContactConstraints(bodies, sphereSlots1.data(), sphereSlots2.data(), sphereSlots1.size(), world.settings.speculativeContactDistance, &constraints);
+			sphereSlots1.clear();
+			sphereSlots2.clear();
 		}
 
 		// Now we run the PBD solver with NUM_POS_ITERS iterations
-		for (size_t j = 0; j < numPosIters; ++j)
+		if (true == bGraphColored && true == world.settings.bDeterministic)
 		{
-			for (size_t k = 0; k < constraints->size(); ++k)
-			{
-				Constraint* constraint = &constraints->at(k);
-				solveConstraint(constraint, h, shapes);
-			}
+			SortPBDConstraintsByBodies(constraints);
+		}
+
+		BuildPBDConstraintBatches(bodies, constraints, &batches);
+
+		if (true == bGraphColored)
+		{
+			// Each batch is colored on its own, so that a color only holds constraints of one type.
+			// The contact colors are used again by the velocity solver.
+			ColorPBDConstraints(bodies, batches.positional.bodies, &positionalColoring);
+			ColorPBDConstraints(bodies, batches.collision.bodies, &collisionColoring);
+			solveConstraintsGraphColored(batches, jointColoring, positionalColoring, collisionColoring, h, numPosIters, world);
+		}
+		else
+		{
+			solveConstraintsSequential(batches, h, numPosIters, joints, bodies);
+		}
+
+		if (true == world.settings.bEnableContactCache)
+		{
+			storeCachedContactLambdas(batches.collision);
 		}
 
 		// PBD velocity update
-		//std::unordered_map<size_t, std::shared_ptr<DX12Library::RigidBodyShape>>::iterator shape;
-		for (shape = shapes.begin(); shape != shapes.end(); ++shape)
+		forEachIslandBodyRange(world, island, bGraphColored, [&](size_t begin, size_t end, size_t threadIndex)
+			{
+				UNREFERENCED_PARAMETER(threadIndex);
+
+				updateBodyVelocities(bodies, island.bodies + begin, end - begin, h);
+			});
+
+		// Velocity solver for every collision
+		if (true == bGraphColored)
 		{
-			std::shared_ptr<DX12Library::RigidBodyShape> s = shape->second;
-			if (true == s->bFixed || false == s->bActive)
+			solveVelocitiesGraphColored(batches.collision, collisionColoring, h, world);
+		}
+		else
+		{
+			for (size_t j = 0; j < batches.collision.constraints.size(); ++j)
 			{
-				continue;
+				solveCollisionVelocity(batches.collision.bodies[j], &batches.collision.constraints[j], h, bodies);
 			}
+		}
+	}
+}
+
+// Forces added to a body and changes of the external constraints wake the bodies involved
+static void wakeBodiesForExternalChanges(PBDWorld& world, const std::vector<Constraint>* externalConstraints)
+{
+	PBDBodyStore& bodies = world.bodies;
 
-			// Storing the current velocity for the velocity solver
-			s->prevLinearVelocity = s->linearVelocity;
-			s->prevAngularVelocity = s->angularVelocity;
+	size_t numBodies = GetPBDBodyCount(bodies);
+	for (size_t s = 0; s < numBodies; ++s)
+	{
+		if (false == bodies.shapes[s]->forces.empty())
+		{
+			WakePBDBody(bodies, bodies.slotToHandle[s]);
+		}
+	}
+
+	// FNV-1a over the types and bodies of the constraints
+	uint64_t signature = 14695981039346656037ull;
+	PBDArenaVector<size_t> constraintBodies;
+	size_t numExternalConstraints = nullptr == externalConstraints ? 0 : externalConstraints->size();
+	for (size_t i = 0; i < numExternalConstraints; ++i)
+	{
+		const Constraint* constraint = &externalConstraints->at(i);
+		signature = (signature ^ static_cast<uint64_t>(constraint->type)) * 1099511628211ull;
+		signature = (signature ^ static_cast<uint64_t>(constraint->s1_id)) * 1099511628211ull;
+		signature = (signature ^ static_cast<uint64_t>(constraint->s2_id)) * 1099511628211ull;
+		constraintBodies.push_back(constraint->s1_id);
+		constraintBodies.push_back(constraint->s2_id);
+	}
+
+	if (signature == world.externalConstraintsSignature)
+	{
+		return;
+	}
+
+	// Wake the bodies of the removed constraints as well as the ones of the new constraints
+	world.externalConstraintBodies.insert(world.externalConstraintBodies.end(), constraintBodies.begin(), constraintBodies.end());
+	for (size_t i = 0; i < world.externalConstraintBodies.size(); ++i)
+	{
+		size_t handle = world.externalConstraintBodies[i];
+		if (handle < bodies.handleToSlot.size() && SIZE_MAX != bodies.handleToSlot[handle])
+		{
+			WakePBDBody(bodies, handle);
+		}
+	}
+
+	world.externalConstraintsSignature = signature;
+	world.externalConstraintBodies.assign(constraintBodies.begin(), constraintBodies.end());
+}
+
+static void simulatePBDStep(float dt, PBDWorld& world,
+	const std::vector<Constraint>* externalConstraints, size_t numSubsteps, size_t numPosIters, bool bEnableCollision)
+{
+	PBDBodyStore& bodies = world.bodies;
+
+	float h = dt / static_cast<float>(numSubsteps);
+	size_t numBodies = GetPBDBodyCount(bodies);
 
-			// Update linear velocity based on the position difference
-			s->linearVelocity = (1.0f / h) * (s->worldPosition - s->prevWorldPosition);
+	GatherPBDBodyForces(bodies);
+	BeginPBDContactCacheStep(world.contactCache);
 
-			// Update angular velocity based on the orientation difference
-			XMVECTOR invQ = XMQuaternionInverse(s->prevWorldRotation);
-			XMVECTOR delta_q = XMQuaternionMultiply(s->worldRotation, invQ);
-			if (0.0f <= XMVectorGetW(delta_q))
+	// Only the spatial hash runs in parallel, no need to start the threads for the other broadphases
+	PBDJobSystem* broadphaseJobSystem = PBDBroadphaseType::SPATIAL_HASH == world.broadphase.type ? getJobSystem(world) : nullptr;
+
+	PBDArenaVector<BroadCollisionPair> broadCollisionPairs;
+	if (true == bEnableCollision)
+	{
+		GetBroadCollisionPairs(world.broadphase, bodies, dt, broadphaseJobSystem, broadCollisionPairs);
+	}
+
+	// Fixed bodies don't move during the step
+	for (size_t s = 0; s < numBodies; ++s)
+	{
+		if (0 != bodies.bFixed[s])
+		{
+			bodies.prevPositions[s] = bodies.positions[s];
+			bodies.prevRotations[s] = bodies.rotations[s];
+			UpdateColliders(bodies.shapes[s]->colliders, bodies.positions[s], bodies.rotations[s]);
+		}
+	}
+
+	if (true == world.settings.bEnableSleeping)
+	{
+		wakeBodiesForExternalChanges(world, externalConstraints);
+	}
+
+	// Islands are also the unit of sleeping
+	PBDIslands islands;
+	if (true == world.settings.bEnableIslands || true == world.settings.bEnableSleeping)
+	{
+		BuildPBDIslands(bodies, broadCollisionPairs, externalConstraints, world.joints, &islands);
+
+		if (true == world.settings.bEnableSleeping)
+		{
+			WakePBDIslands(bodies, &islands);
+		}
+	}
+
+	if (false == world.settings.bEnableIslands)
+	{
+		// The whole world as a single island
+		PBDArenaVector<uint32_t> allBodies(numBodies);
+		for (size_t s = 0; s < numBodies; ++s)
+		{
+			allBodies[s] = static_cast<uint32_t>(s);
+		}
+
+		PBDArenaVector<uint32_t> allPairs(broadCollisionPairs.size());
+		for (size_t j = 0; j < broadCollisionPairs.size(); ++j)
+		{
+			allPairs[j] = static_cast<uint32_t>(j);
+		}
+
+		size_t numExternalConstraints = nullptr == externalConstraints ? 0 : externalConstraints->size();
+		PBDArenaVector<uint32_t> allConstraints(numExternalConstraints);
+		for (size_t j = 0; j < numExternalConstraints; ++j)
+		{
+			allConstraints[j] = static_cast<uint32_t>(j);
+		}
+
+		size_t numJoints = GetPBDJointCount(world.joints);
+		PBDArenaVector<uint32_t> allJoints(numJoints);
+		for (size_t j = 0; j < numJoints; ++j)
+		{
+			allJoints[j] = static_cast<uint32_t>(j);
+		}
+
+		PBDIslandRange island{ allBodies.data(), allBodies.size(), allPairs.data(), allPairs.size(), allConstraints.data(), allConstraints.size(),
+			allJoints.data(), allJoints.size() };
+		simulateIsland(h, world, externalConstraints, broadCollisionPairs, island, numSubsteps, numPosIters, bEnableCollision, true);
+	}
+	else
+	{
+		// The cache must not be modified from the island tasks, so the manifolds of every pair are created beforehand
+		if (true == world.settings.bEnableContactCache)
+		{
+			for (size_t j = 0; j < broadCollisionPairs.size(); ++j)
 			{
-				s->angularVelocity = (2.0f / h) * XMVectorSet(XMVectorGetX(delta_q), XMVectorGetY(delta_q), XMVectorGetZ(delta_q), 0.0f);
+				size_t handle1 = broadCollisionPairs[j].s1_id;
+				size_t handle2 = broadCollisionPairs[j].s2_id;
+				FindOrCreatePBDContactManifold(world.contactCache, handle1 < handle2 ? handle1 : handle2, handle1 < handle2 ? handle2 : handle1);
+			}
+		}
+
+		// Large islands are simulated one after another, each of them spread over the threads by the solver.
+		// The others are simulated concurrently, one task per island.
+		PBDArenaVector<size_t> smallIslands;
+		PBDArenaVector<size_t> largeIslands;
+		size_t numIslands = GetPBDIslandCount(&islands);
+		for (size_t j = 0; j < numIslands; ++j)
+		{
+			// The bodies of an island are all asleep or all awake, sleeping islands aren't simulated at all
+			PBDIslandRange island = GetPBDIsland(&islands, j);
+			if (0 == bodies.bActive[island.bodies[0]])
+			{
+				continue;
+			}
+
+			if (world.settings.largeIslandBodyCount < island.numBodies)
+			{
+				largeIslands.push_back(j);
 			}
 			else
 			{
-				s->angularVelocity = (-2.0f / h) * XMVectorSet(XMVectorGetX(delta_q), XMVectorGetY(delta_q), XMVectorGetZ(delta_q), 0.0f);
+				smallIslands.push_back(j);
 			}
 		}
 
-		// Velocity solver for every collision
-		for (size_t j = 0; j < constraints->size(); ++j)
-		{
-			Constraint* constraint = &constraints->at(j);
-			if (constraint->type == ConstraintType::COLLISION_CONSTRAINT)
+		PBDJobSystem* jobSystem = getJobSystem(world);
+		jobSystem->ParallelFor(smallIslands.size(), 1, [&](size_t begin, size_t end, size_t threadIndex)
 			{
-				std::shared_ptr<DX12Library::RigidBodyShape> s1 = shapes[constraint->s1_id];
-				std::shared_ptr<DX12Library::RigidBodyShape> s2 = shapes[constraint->s2_id];
-				XMVECTOR n = constraint->collision_constraint.normal;
-				float lambda_t = constraint->collision_constraint.lambda_t;
-				float lambda_n = constraint->collision_constraint.lambda_n;
-
-				PositionalConstraintPreprocessedData pcpd;
-				CalculatePositionalConstraintPreprocessedData(s1, s2, constraint->collision_constraint.r1_local, constraint->collision_constraint.r2_local, &pcpd);
-
-				XMVECTOR v1 = s1->linearVelocity;
-				XMVECTOR w1 = s1->angularVelocity;
-				XMVECTOR v2 = s2->linearVelocity;
-				XMVECTOR w2 = s2->angularVelocity;
-
-				// Calculate the relative normal and tangential velocities at the contact point
-				XMVECTOR v = (v1 + XMVector3Cross(w1, pcpd.r1_world)) - (v2 + XMVector3Cross(w2, pcpd.r2_world));
-				float vn = XMVectorGetX(XMVector3Dot(n, v));
-				XMVECTOR vt = v - vn * n;
-
-				// delta_v stores the velocity change
-				XMVECTOR delta_v = XMVectorZero();
-
-				// Coulomb's dynamic friction
-				const float dynamicFrictionCoefficient = (s1->dynamicFrictionCoefficient + s2->dynamicFrictionCoefficient) * 0.5f;
-				float fn = lambda_n / h;
-				float fact = fminf(dynamicFrictionCoefficient * fabsf(fn), XMVectorGetX(XMVector3Length(vt)));
-				delta_v += -fact * XMVector3Normalize(vt);
-
-				// Restitution
-				XMVECTOR old_v1 = s1->prevLinearVelocity;
-				XMVECTOR old_w1 = s1->prevAngularVelocity;
-				XMVECTOR old_v2 = s2->prevLinearVelocity;
-				XMVECTOR old_w2 = s2->prevAngularVelocity;
-				XMVECTOR v_til = (old_v1 - XMVector3Cross(old_w1, pcpd.r1_world)) - (old_v2 - XMVector3Cross(old_w2, pcpd.r2_world));
-				float vn_til = XMVectorGetX(XMVector3Dot(n, v_til));
-				float e = s1->restitutionCoefficient * s2->restitutionCoefficient;
-				fact = -vn + fminf(-e * vn_til, 0.0f);
-				delta_v += fact * n;
-
-				// Applying delta_v considering the inverse masses of both shapes
-				float _w1 = s1->inverseMass + XMVectorGetX(XMVector3Dot(XMVector3Cross(pcpd.r1_world, n),
-					XMVector3Transform(XMVector3Cross(pcpd.r1_world, n), pcpd.s1_inverseInertiaTensor)));
-				float _w2 = s2->inverseMass + XMVectorGetX(XMVector3Dot(XMVector3Cross(pcpd.r2_world, n),
-					XMVector3Transform(XMVector3Cross(pcpd.r2_world, n), pcpd.s2_inverseInertiaTensor)));
-				//float _w1 = s1->inverseMass;
-				//float _w2 = s2->inverseMass;
-				XMVECTOR p = (1.0f / (_w1 + _w2)) * delta_v;
-
-				if (false == s1->bFixed)
-				{
-					s1->linearVelocity += s1->inverseMass * p;
-					s1->angularVelocity += XMVector3Transform(XMVector3Cross(pcpd.r1_world, p), pcpd.s1_inverseInertiaTensor);
-				}
-				if (false == s2->bFixed)
+				PBDFrameArena* previousFrameArena = GetPBDThreadFrameArena();
+				SetPBDThreadFrameArena(world.frameArenas[threadIndex].get());
+
+				for (size_t j = begin; j < end; ++j)
 				{
-					s2->linearVelocity -= s2->inverseMass * p;
-					s2->angularVelocity -= XMVector3Transform(XMVector3Cross(pcpd.r2_world, p), pcpd.s2_inverseInertiaTensor);
+					PBDIslandRange island = GetPBDIsland(&islands, smallIslands[j]);
+					simulateIsland(h, world, externalConstraints, broadCollisionPairs, island, numSubsteps, numPosIters, bEnableCollision, false);
 				}
-			}
+
+				SetPBDThreadFrameArena(previousFrameArena);
+			});
+
+		for (size_t j = 0; j < largeIslands.size(); ++j)
+		{
+			PBDIslandRange island = GetPBDIsland(&islands, largeIslands[j]);
+			simulateIsland(h, world, externalConstraints, broadCollisionPairs, island, numSubsteps, numPosIters, bEnableCollision, true);
 		}
+	}
 
-		delete constraints;
+	if (true == world.settings.bEnableSleeping)
+	{
+		UpdatePBDIslandsSleep(bodies, &islands, world.settings, dt);
 	}
+
+	EndPBDContactCacheStep(world.contactCache);
+	ScatterPBDBodyStates(bodies);
 }
 
-void SimulatePBD(float dt, std::unordered_map<size_t, std::shared_ptr<DX12Library::RigidBodyShape>>& shapes, size_t numSubsteps, size_t numPosIters, bool bEnableCollision)
+static void simulatePBDWithConstraints(float dt, PBDWorld& world,
+	std::vector<Constraint>* externalConstraints, size_t numSubsteps, size_t numPosIters, bool bEnableCollision)
 {
-	simulatePBDWithConstraints(dt, shapes, nullptr, numSubsteps, numPosIters, bEnableCollision);
+	if (dt <= 0.0f)
+	{
+		return;
+	}
+
+	// Every PBDArenaVector created on this thread until the end of the step draws from the first arena
+	if (true == world.frameArenas.empty())
+	{
+		world.frameArenas.push_back(std::make_unique<PBDFrameArena>());
+	}
+	for (size_t j = 0; j < world.frameArenas.size(); ++j)
+	{
+		ResetPBDFrameArena(*world.frameArenas[j]);
+	}
+	PBDFrameArena* previousFrameArena = GetPBDThreadFrameArena();
+	SetPBDThreadFrameArena(world.frameArenas[0].get());
+	size_t numUnboundAllocations = GetPBDUnboundArenaAllocationCount();
+	world.lastStepWideContactMismatches = 0;
+
+	simulatePBDStep(dt, world, externalConstraints, numSubsteps, numPosIters, bEnableCollision);
+
+	SetPBDThreadFrameArena(previousFrameArena);
+
+	// The unbound allocations of the other worlds stepped at the same time are counted as well
+	world.lastStepHeapAllocations = GetPBDUnboundArenaAllocationCount() - numUnboundAllocations;
+	world.lastStepArenaBytes = 0;
+	for (size_t j = 0; j < world.frameArenas.size(); ++j)
+	{
+		world.lastStepHeapAllocations += world.frameArenas[j]->numHeapAllocations;
+		world.lastStepArenaBytes += world.frameArenas[j]->numBytesAllocated;
+	}
 }
+
+void SimulatePBD(float dt, PBDWorld& world, size_t numSubsteps, size_t numPosIters, bool bEnableCollision)
+{
+	simulatePBDWithConstraints(dt, world, nullptr, numSubsteps, numPosIters, bEnableCollision);
+}
\ No newline at end of file
@@ -1,7 +1,11 @@
 #pragma once
 
-#include "Shapes/RigidBodyShape.h"
-#include <unordered_map>
+#include "PBDBodyStore.h"
+#include "PBDJobSystem.h"
+#include "PBDFrameArena.h"
+#include "PBDContactCache.h"
+#include "PBDJoints.h"
+#include "Broad.h"
 
 enum class PBDAxisType
 {
@@ -35,6 +39,13 @@ struct CollisionConstraint
 	XMVECTOR normal;
 	float lambda_t;
 	float lambda_n;
+
+	// Normal lambda reached by the same contact in the previous substep, used to bound the static friction
+	// before this substep's own lambda_n has built up
+	float lambda_n_warm;
+
+	// Entry of the contact cache that receives the final lambdas (nullptr when the contact isn't cached)
+	PBDCachedContact* cached_contact;
 };
 
 struct Constraint
@@ -50,4 +61,101 @@ struct Constraint
 	};
 };
 
-void SimulatePBD(float dt, std::unordered_map<size_t, std::shared_ptr<DX12Library::RigidBodyShape>>& shapes, size_t numSubsteps, size_t numPosIters, bool bEnableCollision);
\ No newline at end of file
+enum class PBDSolverMode
+{
+	// Solves the constraints one after another on the calling thread
+	SEQUENTIAL,
+	// Colors the constraint graph and solves each color across the worker threads
+	GRAPH_COLORED_PARALLEL
+};
+
+struct PBDSettings
+{
+	PBDSolverMode solverMode = PBDSolverMode::SEQUENTIAL;
+
+	// Sort the constraints by body handles before coloring them, so that the solve order (and thus the result)
+	// doesn't depend on the order in which the contacts were generated
+	bool bDeterministic = false;
+
+	// Number of threads used by the parallel phases, including the calling thread (0 means one per hardware thread)
+	size_t numThreads = 0;
+
+	// Number of constraints handed to a worker at once
+	size_t constraintBatchSize = 64;
+
+	// Number of bodies handed to a worker at once by the integration and velocity update passes of the graph colored solver
+	size_t bodyBatchSize = 256;
+
+	// Solve the contacts of each color with the SIMD contact kernel, 4 contacts at a time with SSE (8 with AVX).
+	// Only used by the graph colored solver, whose colors guarantee that the contacts solved together share no non-fixed body.
+	bool bWideContactSolve = true;
+
+	// Debugging aid: also solve each group of contacts with the scalar contact solve, and count the contacts whose bodies or
+	// lambdas differ by more than wideContactVerifyTolerance (relative) in PBDWorld::lastStepWideContactMismatches
+	bool bVerifyWideContactSolve = false;
+	float wideContactVerifyTolerance = 1e-4f;
+
+	// Keep the contacts of every body pair across substeps and frames, and only run the narrowphase again
+	// once the relative motion of the pair exceeds the thresholds
+	bool bEnableContactCache = false;
+	float contactCacheLinearThreshold = 0.005f;
+	float contactCacheAngularThreshold = 0.01f;	// radians
+
+	// Generate the contacts between single sphere bodies with the SIMD sphere kernel, bypassing the contact cache
+	bool bBatchSphereContacts = true;
+
+	// Also generate contacts between bodies closer than this distance. They only act once the bodies touch during the solve,
+	// and are ready in the contact cache when the bodies come into contact.
+	float speculativeContactDistance = 0.0f;
+
+	// Pairs moving relative to each other by more than continuousCollisionMotionRatio times their smaller bounding radius
+	// in a substep, and apart at its end, are checked for a time of impact during the substep so that they can't tunnel
+	// through each other. This allows fewer substeps for fast bodies.
+	bool bEnableContinuousCollision = false;
+	float continuousCollisionMotionRatio = 0.5f;
+
+	// Split the bodies into islands that don't interact, and simulate the islands concurrently.
+	// An island with more bodies than largeIslandBodyCount is simulated on its own with the solver mode above,
+	// the smaller ones are simulated one per thread with the sequential solver.
+	bool bEnableIslands = false;
+	size_t largeIslandBodyCount = 1024;
+
+	// Acceleration applied to every non-fixed body. Unlike a force added to a shape, it doesn't keep the bodies awake
+	XMFLOAT3 gravity = XMFLOAT3(0.0f, 0.0f, 0.0f);
+
+	// Put islands to sleep once all their bodies stayed under the velocity thresholds for timeToSleep seconds.
+	// Sleeping bodies are woken up by a force, by contact with an awake body or by a change of the external constraints.
+	bool bEnableSleeping = false;
+	float sleepLinearVelocityThreshold = 0.05f;
+	float sleepAngularVelocityThreshold = 0.05f;
+	float timeToSleep = 0.5f;
+};
+
+struct PBDWorld
+{
+	PBDBodyStore bodies;
+	PBDJointStore joints;
+	PBDSettings settings;
+	PBDContactCache contactCache;
+	PBDBroadphase broadphase;
+
+	// Created on the first step that needs it
+	std::unique_ptr<PBDJobSystem> jobSystem;
+
+	// Scratch memory of the steps, one arena per thread of the job system
+	std::vector<std::unique_ptr<PBDFrameArena>> frameArenas;
+
+	// Heap allocations made by the scratch memory of the last step, zero once the arenas have grown to fit it
+	size_t lastStepHeapAllocations = 0;
+	size_t lastStepArenaBytes = 0;
+
+	// Contacts solved differently by the wide contact kernel and the scalar contact solve during the last step,
+	// only counted with PBDSettings::bVerifyWideContactSolve
+	size_t lastStepWideContactMismatches = 0;
+
+	// External constraints of the last step, to wake their bodies up when they change
+	uint64_t externalConstraintsSignature = 0;
+	std::vector<size_t> externalConstraintBodies;
+};
+
+void SimulatePBD(float dt, PBDWorld& world, size_t numSubsteps, size_t numPosIters, bool bEnableCollision);
\ No newline at end of file
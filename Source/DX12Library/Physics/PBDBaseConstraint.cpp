@@ -1,18 +1,22 @@
 #include "PBDBaseConstraint.h"
 
-void CalculatePositionalConstraintPreprocessedData(std::shared_ptr<DX12Library::RigidBodyShape> s1, std::shared_ptr<DX12Library::RigidBodyShape> s2, XMVECTOR r1_local, XMVECTOR r2_local, PositionalConstraintPreprocessedData* pcpd)
+void CalculatePositionalConstraintPreprocessedData(const PBDBodyStore& bodies, size_t s1, size_t s2, XMVECTOR r1_local, XMVECTOR r2_local, PositionalConstraintPreprocessedData* pcpd)
 {
 	pcpd->s1 = s1;
 	pcpd->s2 = s2;
 
-	pcpd->r1_world = XMVector3Rotate(r1_local, s1->worldRotation);
-	pcpd->r2_world = XMVector3Rotate(r2_local, s2->worldRotation);
+	pcpd->r1_world = XMVector3Rotate(r1_local, bodies.rotations[s1]);
+	pcpd->r2_world = XMVector3Rotate(r2_local, bodies.rotations[s2]);
+}
+
+float GetPBDBodyGeneralizedInverseMass(const PBDBodyStore& bodies, size_t slot, XMVECTOR r_world, XMVECTOR n)
+{
+	XMVECTOR rn = XMVector3Cross(r_world, n);
 
-	pcpd->s1_inverseInertiaTensor = s1->GetDynamicInverseInertiaTensor();
-	pcpd->s2_inverseInertiaTensor = s2->GetDynamicInverseInertiaTensor();
+	return bodies.inverseMasses[slot] + XMVectorGetX(XMVector3Dot(rn, TransformPBDSymmetricMatrix3(bodies.worldInverseInertiaTensors[slot], rn)));
 }
 
-float GetPositionalConstraintDeltaLambda(PositionalConstraintPreprocessedData* pcpd, float h, float compliance, float lambda, XMVECTOR delta_x)
+float GetPositionalConstraintDeltaLambda(const PBDBodyStore& bodies, PositionalConstraintPreprocessedData* pcpd, float h, float compliance, float lambda, XMVECTOR delta_x)
 {
 	float c = XMVectorGetX(XMVector3Length(delta_x));
 
@@ -21,18 +25,16 @@ float GetPositionalConstraintDeltaLambda(PositionalConstraintPreprocessedData* p
 		return 0.0f;
 	}
 
-	std::shared_ptr<DX12Library::RigidBodyShape> s1 = pcpd->s1;
-	std::shared_ptr<DX12Library::RigidBodyShape> s2 = pcpd->s2;
+	size_t s1 = pcpd->s1;
+	size_t s2 = pcpd->s2;
 	XMVECTOR r1_world = pcpd->r1_world;
 	XMVECTOR r2_world = pcpd->r2_world;
-	XMMATRIX s1_inverseInertiaTensor = pcpd->s1_inverseInertiaTensor;
-	XMMATRIX s2_inverseInertiaTensor = pcpd->s2_inverseInertiaTensor;
 
 	XMVECTOR n = delta_x / c;
 
 	// Calculate the inverse masses of both shapes
-	float w1 = s1->inverseMass + XMVectorGetX(XMVector3Dot(XMVector3Cross(r1_world, n), XMVector3Transform(XMVector3Cross(r1_world, n), s1_inverseInertiaTensor)));
-	float w2 = s2->inverseMass + XMVectorGetX(XMVector3Dot(XMVector3Cross(r2_world, n), XMVector3Transform(XMVector3Cross(r2_world, n), s2_inverseInertiaTensor)));
+	float w1 = GetPBDBodyGeneralizedInverseMass(bodies, s1, r1_world, n);
+	float w2 = GetPBDBodyGeneralizedInverseMass(bodies, s2, r2_world, n);
 
 	assert(0.0f != w1 + w2);
 
@@ -43,7 +45,7 @@ float GetPositionalConstraintDeltaLambda(PositionalConstraintPreprocessedData* p
 	return delta_lambda;
 }
 
-void ApplyPositionalConstraint(PositionalConstraintPreprocessedData* pcpd, float delta_lambda, XMVECTOR delta_x)
+void ApplyPositionalConstraint(PBDBodyStore& bodies, PositionalConstraintPreprocessedData* pcpd, float delta_lambda, XMVECTOR delta_x)
 {
 	float c = XMVectorGetX(XMVector3Length(delta_x));
 
@@ -52,12 +54,10 @@ void ApplyPositionalConstraint(PositionalConstraintPreprocessedData* pcpd, float
 		return;
 	}
 
-	std::shared_ptr<DX12Library::RigidBodyShape> s1 = pcpd->s1;
-	std::shared_ptr<DX12Library::RigidBodyShape> s2 = pcpd->s2;
+	size_t s1 = pcpd->s1;
+	size_t s2 = pcpd->s2;
 	XMVECTOR r1_world = pcpd->r1_world;
 	XMVECTOR r2_world = pcpd->r2_world;
-	XMMATRIX s1_inverseInertiaTensor = pcpd->s1_inverseInertiaTensor;
-	XMMATRIX s2_inverseInertiaTensor = pcpd->s2_inverseInertiaTensor;
 
 	XMVECTOR n = delta_x / c;
 
@@ -65,30 +65,79 @@ void ApplyPositionalConstraint(PositionalConstraintPreprocessedData* pcpd, float
 	XMVECTOR positionalImpulse = delta_lambda * n;
 
 	// Update the position of the shapes
-	if (false == s1->bFixed)
+	if (0 == bodies.bFixed[s1])
 	{
-		s1->worldPosition += s1->inverseMass * positionalImpulse;
+		bodies.positions[s1] += bodies.inverseMasses[s1] * positionalImpulse;
 	}
-	if (false == s2->bFixed)
+	if (0 == bodies.bFixed[s2])
 	{
-		s2->worldPosition -= s2->inverseMass * positionalImpulse;
+		bodies.positions[s2] -= bodies.inverseMasses[s2] * positionalImpulse;
 	}
 
 	// Update the rotation of the shapes
-	XMVECTOR angular1 = XMVector3Transform(XMVector3Cross(r1_world, positionalImpulse), s1_inverseInertiaTensor);
-	XMVECTOR angular2 = XMVector3Transform(XMVector3Cross(r2_world, positionalImpulse), s2_inverseInertiaTensor);
-	angular1 = XMVectorSetW(angular1, 0.0f);
-	angular2 = XMVectorSetW(angular2, 0.0f);
-	XMVECTOR q1 = XMQuaternionMultiply(angular1, s1->worldRotation);
-	XMVECTOR q2 = XMQuaternionMultiply(angular2, s2->worldRotation);
-	if (false == s1->bFixed)
+	XMVECTOR angular1 = TransformPBDSymmetricMatrix3(bodies.worldInverseInertiaTensors[s1], XMVector3Cross(r1_world, positionalImpulse));
+	XMVECTOR angular2 = TransformPBDSymmetricMatrix3(bodies.worldInverseInertiaTensors[s2], XMVector3Cross(r2_world, positionalImpulse));
+	XMVECTOR q1 = XMQuaternionMultiply(angular1, bodies.rotations[s1]);
+	XMVECTOR q2 = XMQuaternionMultiply(angular2, bodies.rotations[s2]);
+	if (0 == bodies.bFixed[s1])
 	{
-		s1->worldRotation += 0.5f * q1;
-		s1->worldRotation = XMQuaternionNormalize(s1->worldRotation);
+		bodies.rotations[s1] += 0.5f * q1;
+		bodies.rotations[s1] = XMQuaternionNormalize(bodies.rotations[s1]);
 	}
-	if (false == s2->bFixed)
+	if (0 == bodies.bFixed[s2])
 	{
-		s2->worldRotation += 0.5f * q2;
-		s2->worldRotation = XMQuaternionNormalize(s2->worldRotation);
+		bodies.rotations[s2] += 0.5f * q2;
+		bodies.rotations[s2] = XMQuaternionNormalize(bodies.rotations[s2]);
 	}
 }
+
+
+float GetAngularConstraintDeltaLambda(const PBDBodyStore& bodies, size_t s1, size_t s2, float h, float compliance, float lambda, XMVECTOR delta_q)
+{
+	float theta = XMVectorGetX(XMVector3Length(delta_q));
+
+	if (theta <= FLT_EPSILON)
+	{
+		return 0.0f;
+	}
+
+	XMVECTOR n = delta_q / theta;
+
+	// Calculate the inverse inertias of both shapes around the axis
+	float w1 = XMVectorGetX(XMVector3Dot(n, TransformPBDSymmetricMatrix3(bodies.worldInverseInertiaTensors[s1], n)));
+	float w2 = XMVectorGetX(XMVector3Dot(n, TransformPBDSymmetricMatrix3(bodies.worldInverseInertiaTensors[s2], n)));
+
+	assert(0.0f != w1 + w2);
+
+	float compliance_til = compliance / (h * h);
+	float delta_lambda = (-theta - compliance_til * lambda) / (w1 + w2 + compliance_til);
+
+	return delta_lambda;
+}
+
+void ApplyAngularConstraint(PBDBodyStore& bodies, size_t s1, size_t s2, float delta_lambda, XMVECTOR delta_q)
+{
+	float theta = XMVectorGetX(XMVector3Length(delta_q));
+
+	if (theta <= FLT_EPSILON)
+	{
+		return;
+	}
+
+	// Calculate the angular impulse, the first body turns against delta_q and the second one along it
+	XMVECTOR angularImpulse = (delta_lambda / theta) * delta_q;
+
+	// The impulse is in world space, so its rotation is applied on the left of the body rotation
+	if (0 == bodies.bFixed[s1])
+	{
+		XMVECTOR angular1 = TransformPBDSymmetricMatrix3(bodies.worldInverseInertiaTensors[s1], angularImpulse);
+		bodies.rotations[s1] += 0.5f * XMQuaternionMultiply(bodies.rotations[s1], angular1);
+		bodies.rotations[s1] = XMQuaternionNormalize(bodies.rotations[s1]);
+	}
+	if (0 == bodies.bFixed[s2])
+	{
+		XMVECTOR angular2 = TransformPBDSymmetricMatrix3(bodies.worldInverseInertiaTensors[s2], angularImpulse);
+		bodies.rotations[s2] -= 0.5f * XMQuaternionMultiply(bodies.rotations[s2], angular2);
+		bodies.rotations[s2] = XMQuaternionNormalize(bodies.rotations[s2]);
+	}
+}
\ No newline at end of file
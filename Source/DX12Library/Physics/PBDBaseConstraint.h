@@ -2,20 +2,24 @@
 
 #include "Common.h"
 #include "Collider.h"
-#include "Shapes/RigidBodyShape.h"
+#include "PBDBodyStore.h"
 
 struct PositionalConstraintPreprocessedData 
 {
-	std::shared_ptr<DX12Library::RigidBodyShape> s1;
-	std::shared_ptr<DX12Library::RigidBodyShape> s2;
+	size_t s1;
+	size_t s2;
 	XMVECTOR r1_world;
 	XMVECTOR r2_world;
-	XMMATRIX s1_inverseInertiaTensor;
-	XMMATRIX s2_inverseInertiaTensor;
 };
 
 // Positional constraint
-void CalculatePositionalConstraintPreprocessedData(std::shared_ptr<DX12Library::RigidBodyShape> s1, std::shared_ptr<DX12Library::RigidBodyShape> s2,
+void CalculatePositionalConstraintPreprocessedData(const PBDBodyStore& bodies, size_t s1, size_t s2,
 	XMVECTOR r1_local, XMVECTOR r2_local, PositionalConstraintPreprocessedData* pcpd);
-float GetPositionalConstraintDeltaLambda(PositionalConstraintPreprocessedData* pcpd, float h, float compliance, float lambda, XMVECTOR delta_x);
-void ApplyPositionalConstraint(PositionalConstraintPreprocessedData* pcpd, float delta_lambda, XMVECTOR delta_x);
\ No newline at end of file
+float GetPositionalConstraintDeltaLambda(const PBDBodyStore& bodies, PositionalConstraintPreprocessedData* pcpd, float h, float compliance, float lambda, XMVECTOR delta_x);
+float GetPBDBodyGeneralizedInverseMass(const PBDBodyStore& bodies, size_t slot, XMVECTOR r_world, XMVECTOR n);
+void ApplyPositionalConstraint(PBDBodyStore& bodies, PositionalConstraintPreprocessedData* pcpd, float delta_lambda, XMVECTOR delta_x);
+
+// Angular constraint. delta_q is the rotation vector (in world space) of the first body relative to the second one
+// that the constraint removes, its length is the angle
+float GetAngularConstraintDeltaLambda(const PBDBodyStore& bodies, size_t s1, size_t s2, float h, float compliance, float lambda, XMVECTOR delta_q);
+void ApplyAngularConstraint(PBDBodyStore& bodies, size_t s1, size_t s2, float delta_lambda, XMVECTOR delta_q);
\ No newline at end of file
@@ -0,0 +1,192 @@
+#include "PBDBodyStore.h"
+
+template<typename T>
+static void moveLastSlotInto(std::vector<T>& values, size_t slot)
+{
+	values[slot] = values.back();
+	values.pop_back();
+}
+
+size_t AddPBDBody(PBDBodyStore& bodies, DX12Library::RigidBodyShape* shape)
+{
+	assert(nullptr != shape);
+
+	size_t slot = bodies.shapes.size();
+
+	// Reuse the handle of a removed body when possible, so that the handle table stays compact
+	size_t handle;
+	if (false == bodies.freeHandles.empty())
+	{
+		handle = bodies.freeHandles.back();
+		bodies.freeHandles.pop_back();
+		bodies.handleToSlot[handle] = slot;
+	}
+	else
+	{
+		handle = bodies.handleToSlot.size();
+		bodies.handleToSlot.push_back(slot);
+	}
+
+	shape->id = handle;
+
+	bodies.positions.push_back(shape->worldPosition);
+	bodies.rotations.push_back(shape->worldRotation);
+	bodies.linearVelocities.push_back(shape->linearVelocity);
+	bodies.angularVelocities.push_back(shape->angularVelocity);
+	bodies.prevPositions.push_back(shape->worldPosition);
+	bodies.prevRotations.push_back(shape->worldRotation);
+	bodies.prevLinearVelocities.push_back(shape->prevLinearVelocity);
+	bodies.prevAngularVelocities.push_back(shape->prevAngularVelocity);
+	bodies.externalForces.push_back(XMVectorZero());
+	bodies.externalTorques.push_back(XMVectorZero());
+	bodies.inverseMasses.push_back(shape->inverseMass);
+	bodies.inertiaTensors.push_back(shape->inertiaTensor);
+	bodies.inverseInertiaTensors.push_back(shape->inverseInertiaTensor);
+	bodies.worldInverseInertiaTensors.push_back(PBDSymmetricMatrix3{});
+	bodies.staticFrictionCoefficients.push_back(shape->staticFrictionCoefficient);
+	bodies.dynamicFrictionCoefficients.push_back(shape->dynamicFrictionCoefficient);
+	bodies.restitutionCoefficients.push_back(shape->restitutionCoefficient);
+	bodies.boundingSphereRadii.push_back(shape->boundingSphereRadius);
+	bodies.bFixed.push_back(static_cast<uint8_t>(shape->bFixed));
+	bodies.bActive.push_back(static_cast<uint8_t>(shape->bActive));
+	bodies.deactivationTimes.push_back(shape->deactivationTime);
+	bodies.bSingleSphere.push_back(static_cast<uint8_t>(1 == shape->colliders.size() && ColliderType::SPHERE == shape->colliders[0].type));
+	bodies.shapes.push_back(shape);
+	bodies.slotToHandle.push_back(handle);
+
+	UpdatePBDBodyWorldInverseInertia(bodies, slot);
+
+	return handle;
+}
+
+void RemovePBDBody(PBDBodyStore& bodies, size_t handle)
+{
+	size_t slot = GetPBDBodySlot(bodies, handle);
+	size_t lastSlot = bodies.shapes.size() - 1;
+
+	// The last body takes over the freed slot
+	size_t movedHandle = bodies.slotToHandle[lastSlot];
+	bodies.handleToSlot[movedHandle] = slot;
+	bodies.handleToSlot[handle] = SIZE_MAX;
+	bodies.freeHandles.push_back(handle);
+
+	moveLastSlotInto(bodies.positions, slot);
+	moveLastSlotInto(bodies.rotations, slot);
+	moveLastSlotInto(bodies.linearVelocities, slot);
+	moveLastSlotInto(bodies.angularVelocities, slot);
+	moveLastSlotInto(bodies.prevPositions, slot);
+	moveLastSlotInto(bodies.prevRotations, slot);
+	moveLastSlotInto(bodies.prevLinearVelocities, slot);
+	moveLastSlotInto(bodies.prevAngularVelocities, slot);
+	moveLastSlotInto(bodies.externalForces, slot);
+	moveLastSlotInto(bodies.externalTorques, slot);
+	moveLastSlotInto(bodies.inverseMasses, slot);
+	moveLastSlotInto(bodies.inertiaTensors, slot);
+	moveLastSlotInto(bodies.inverseInertiaTensors, slot);
+	moveLastSlotInto(bodies.worldInverseInertiaTensors, slot);
+	moveLastSlotInto(bodies.staticFrictionCoefficients, slot);
+	moveLastSlotInto(bodies.dynamicFrictionCoefficients, slot);
+	moveLastSlotInto(bodies.restitutionCoefficients, slot);
+	moveLastSlotInto(bodies.boundingSphereRadii, slot);
+	moveLastSlotInto(bodies.bFixed, slot);
+	moveLastSlotInto(bodies.bActive, slot);
+	moveLastSlotInto(bodies.deactivationTimes, slot);
+	moveLastSlotInto(bodies.bSingleSphere, slot);
+	moveLastSlotInto(bodies.shapes, slot);
+	moveLastSlotInto(bodies.slotToHandle, slot);
+}
+
+size_t GetPBDBodyCount(const PBDBodyStore& bodies)
+{
+	return bodies.shapes.size();
+}
+
+size_t GetPBDBodySlot(const PBDBodyStore& bodies, size_t handle)
+{
+	assert(handle < bodies.handleToSlot.size());
+	assert(SIZE_MAX != bodies.handleToSlot[handle]);
+
+	return bodies.handleToSlot[handle];
+}
+
+bool IsPBDBodySimulated(const PBDBodyStore& bodies, size_t slot)
+{
+	return 0 == bodies.bFixed[slot] && 0 != bodies.bActive[slot];
+}
+
+void GatherPBDBodyForces(PBDBodyStore& bodies)
+{
+	const XMVECTOR centerOfMass = XMVectorZero();
+
+	for (size_t i = 0; i < bodies.shapes.size(); ++i)
+	{
+		const std::vector<PhysicsForce>& forces = bodies.shapes[i]->forces;
+
+		XMVECTOR externalForce = XMVectorZero();
+		XMVECTOR externalTorque = XMVectorZero();
+		for (size_t j = 0; j < forces.size(); ++j)
+		{
+			externalForce += forces[j].force;
+
+			XMVECTOR distance = forces[j].position - centerOfMass;
+			externalTorque += XMVector3Cross(distance, forces[j].force);
+		}
+
+		bodies.externalForces[i] = externalForce;
+		bodies.externalTorques[i] = externalTorque;
+	}
+}
+
+void ScatterPBDBodyStates(PBDBodyStore& bodies)
+{
+	for (size_t i = 0; i < bodies.shapes.size(); ++i)
+	{
+		DX12Library::RigidBodyShape* shape = bodies.shapes[i];
+
+		shape->worldPosition = bodies.positions[i];
+		shape->worldRotation = bodies.rotations[i];
+		shape->linearVelocity = bodies.linearVelocities[i];
+		shape->angularVelocity = bodies.angularVelocities[i];
+		shape->prevWorldPosition = bodies.prevPositions[i];
+		shape->prevWorldRotation = bodies.prevRotations[i];
+		shape->prevLinearVelocity = bodies.prevLinearVelocities[i];
+		shape->prevAngularVelocity = bodies.prevAngularVelocities[i];
+		shape->bActive = (0 != bodies.bActive[i]);
+		shape->deactivationTime = bodies.deactivationTimes[i];
+	}
+}
+
+const XMMATRIX GetPBDBodyDynamicInertiaTensor(const PBDBodyStore& bodies, size_t slot)
+{
+	XMMATRIX rotationMatrix = XMMatrixRotationQuaternion(bodies.rotations[slot]);
+
+	return rotationMatrix * bodies.inertiaTensors[slot] * XMMatrixTranspose(rotationMatrix);
+}
+
+void UpdatePBDBodyWorldInverseInertia(PBDBodyStore& bodies, size_t slot)
+{
+	// Same product as rotationMatrix * inverseInertiaTensor * transpose(rotationMatrix), without the redundant half
+	XMMATRIX rotationMatrix = XMMatrixRotationQuaternion(bodies.rotations[slot]);
+	const XMMATRIX& inverseInertiaTensor = bodies.inverseInertiaTensors[slot];
+
+	XMVECTOR row0 = XMVector3TransformNormal(rotationMatrix.r[0], inverseInertiaTensor);
+	XMVECTOR row1 = XMVector3TransformNormal(rotationMatrix.r[1], inverseInertiaTensor);
+	XMVECTOR row2 = XMVector3TransformNormal(rotationMatrix.r[2], inverseInertiaTensor);
+
+	PBDSymmetricMatrix3& m = bodies.worldInverseInertiaTensors[slot];
+	m.xx = XMVectorGetX(XMVector3Dot(row0, rotationMatrix.r[0]));
+	m.yy = XMVectorGetX(XMVector3Dot(row1, rotationMatrix.r[1]));
+	m.zz = XMVectorGetX(XMVector3Dot(row2, rotationMatrix.r[2]));
+	m.xy = XMVectorGetX(XMVector3Dot(row0, rotationMatrix.r[1]));
+	m.xz = XMVectorGetX(XMVector3Dot(row0, rotationMatrix.r[2]));
+	m.yz = XMVectorGetX(XMVector3Dot(row1, rotationMatrix.r[2]));
+}
+
+XMVECTOR TransformPBDSymmetricMatrix3(const PBDSymmetricMatrix3& m, FXMVECTOR v)
+{
+	float x = XMVectorGetX(v);
+	float y = XMVectorGetY(v);
+	float z = XMVectorGetZ(v);
+
+	return XMVectorSet(m.xx * x + m.xy * y + m.xz * z, m.xy * x + m.yy * y + m.yz * z, m.xz * x + m.yz * y + m.zz * z, 0.0f);
+}
\ No newline at end of file
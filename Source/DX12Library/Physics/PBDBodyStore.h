@@ -0,0 +1,80 @@
+#pragma once
+
+#include "Shapes/RigidBodyShape.h"
+
+// Symmetric 3x3 matrix, only the upper triangle is stored
+struct PBDSymmetricMatrix3
+{
+	float xx, yy, zz;
+	float xy, xz, yz;
+};
+
+// Dense storage of every rigid body simulated by the PBD solver.
+// Each property lives in its own packed array indexed by slot, so the hot loops of the simulation walk contiguous memory.
+// Bodies are referenced from the outside by a stable handle (RigidBodyShape::id) which maps onto the current slot.
+// Removing a body moves the last slot into the freed one, therefore slots must not be kept across removals.
+struct PBDBodyStore
+{
+	// Dynamic state
+	std::vector<XMVECTOR> positions;
+	std::vector<XMVECTOR> rotations;
+	std::vector<XMVECTOR> linearVelocities;
+	std::vector<XMVECTOR> angularVelocities;
+
+	// PBD support
+	std::vector<XMVECTOR> prevPositions;
+	std::vector<XMVECTOR> prevRotations;
+	std::vector<XMVECTOR> prevLinearVelocities;
+	std::vector<XMVECTOR> prevAngularVelocities;
+
+	// Accumulated external force and torque, gathered from the shapes once per step
+	std::vector<XMVECTOR> externalForces;
+	std::vector<XMVECTOR> externalTorques;
+
+	// Mass properties
+	std::vector<float> inverseMasses;
+	std::vector<XMMATRIX> inertiaTensors;
+	std::vector<XMMATRIX> inverseInertiaTensors;
+
+	// Inverse inertia tensor in world space, refreshed by UpdatePBDBodyWorldInverseInertia once per substep after the bodies are integrated.
+	// The constraint corrections of the substep read it without refreshing it, so the solver loops do no matrix work.
+	std::vector<PBDSymmetricMatrix3> worldInverseInertiaTensors;
+
+	// Material properties
+	std::vector<float> staticFrictionCoefficients;
+	std::vector<float> dynamicFrictionCoefficients;
+	std::vector<float> restitutionCoefficients;
+	std::vector<float> boundingSphereRadii;
+
+	// Flags (kept as bytes so that different slots can be written concurrently)
+	std::vector<uint8_t> bFixed;
+	std::vector<uint8_t> bActive;
+
+	// The body has a single sphere collider centered on it, its radius is the bounding sphere radius
+	std::vector<uint8_t> bSingleSphere;
+
+	// Time spent under the sleep velocity thresholds
+	std::vector<float> deactivationTimes;
+
+	// Slot <-> handle mapping
+	std::vector<DX12Library::RigidBodyShape*> shapes;
+	std::vector<size_t> slotToHandle;
+	std::vector<size_t> handleToSlot;
+	std::vector<size_t> freeHandles;
+};
+
+size_t AddPBDBody(PBDBodyStore& bodies, DX12Library::RigidBodyShape* shape);
+void RemovePBDBody(PBDBodyStore& bodies, size_t handle);
+size_t GetPBDBodyCount(const PBDBodyStore& bodies);
+size_t GetPBDBodySlot(const PBDBodyStore& bodies, size_t handle);
+bool IsPBDBodySimulated(const PBDBodyStore& bodies, size_t slot);
+
+// Synchronization with the shapes seen by the game
+void GatherPBDBodyForces(PBDBodyStore& bodies);
+void ScatterPBDBodyStates(PBDBodyStore& bodies);
+
+const XMMATRIX GetPBDBodyDynamicInertiaTensor(const PBDBodyStore& bodies, size_t slot);
+
+// Called for the integrated rotations at the start of every substep, and after setting a rotation from outside the solver
+void UpdatePBDBodyWorldInverseInertia(PBDBodyStore& bodies, size_t slot);
+XMVECTOR TransformPBDSymmetricMatrix3(const PBDSymmetricMatrix3& m, FXMVECTOR v);
\ No newline at end of file
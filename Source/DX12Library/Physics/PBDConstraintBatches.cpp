@@ -0,0 +1,74 @@
+#include "PBDConstraintBatches.h"
+
+static PBDConstraintBodyPair makeConstraintBodyPair(const PBDBodyStore& bodies, const Constraint* constraint)
+{
+	PBDConstraintBodyPair pair;
+	pair.s1 = static_cast<uint32_t>(GetPBDBodySlot(bodies, constraint->s1_id));
+	pair.s2 = static_cast<uint32_t>(GetPBDBodySlot(bodies, constraint->s2_id));
+
+	return pair;
+}
+
+void BuildPBDJointBatch(const PBDBodyStore& bodies, const PBDJointStore& joints, const uint32_t* indices, size_t count, PBDJointBatch* batch)
+{
+	batch->bodies.resize(count);
+	batch->indices.assign(indices, indices + count);
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		const PBDJoint* joint = &joints.joints[indices[i]];
+		batch->bodies[i].s1 = static_cast<uint32_t>(GetPBDBodySlot(bodies, joint->s1_id));
+		batch->bodies[i].s2 = static_cast<uint32_t>(GetPBDBodySlot(bodies, joint->s2_id));
+	}
+}
+
+void BuildPBDConstraintBatches(const PBDBodyStore& bodies, const PBDArenaVector<Constraint>& constraints, PBDConstraintBatches* batches)
+{
+	PBDPositionalConstraintBatch& positional = batches->positional;
+	PBDCollisionConstraintBatch& collision = batches->collision;
+
+	positional.bodies.clear();
+	positional.constraints.clear();
+	collision.bodies.clear();
+	collision.constraints.clear();
+
+	for (size_t i = 0; i < constraints.size(); ++i)
+	{
+		const Constraint* constraint = &constraints[i];
+
+		switch (constraint->type)
+		{
+		case ConstraintType::POSITIONAL_CONSTRAINT:
+		{
+			PBDPositionalConstraintData data;
+			XMStoreFloat3(&data.r1_local, constraint->positional_constraint.r1_local);
+			XMStoreFloat3(&data.r2_local, constraint->positional_constraint.r2_local);
+			XMStoreFloat3(&data.distance, constraint->positional_constraint.distance);
+			data.compliance = constraint->positional_constraint.compliance;
+			data.lambda = constraint->positional_constraint.lambda;
+
+			positional.bodies.push_back(makeConstraintBodyPair(bodies, constraint));
+			positional.constraints.push_back(data);
+			break;
+		}
+		case ConstraintType::COLLISION_CONSTRAINT:
+		{
+			PBDCollisionConstraintData data;
+			XMStoreFloat3(&data.r1_local, constraint->collision_constraint.r1_local);
+			XMStoreFloat3(&data.r2_local, constraint->collision_constraint.r2_local);
+			XMStoreFloat3(&data.normal, constraint->collision_constraint.normal);
+			data.lambda_t = constraint->collision_constraint.lambda_t;
+			data.lambda_n = constraint->collision_constraint.lambda_n;
+			data.lambda_n_warm = constraint->collision_constraint.lambda_n_warm;
+			data.cached_contact = constraint->collision_constraint.cached_contact;
+
+			collision.bodies.push_back(makeConstraintBodyPair(bodies, constraint));
+			collision.constraints.push_back(data);
+			break;
+		}
+		default:
+			assert(false);
+			break;
+		}
+	}
+}
\ No newline at end of file
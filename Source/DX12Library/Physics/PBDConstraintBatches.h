@@ -0,0 +1,67 @@
+#pragma once
+
+#include "PBD.h"
+
+// Slots of the two bodies of a packed constraint, valid until the end of the step
+struct PBDConstraintBodyPair
+{
+	uint32_t s1;
+	uint32_t s2;
+};
+
+struct PBDPositionalConstraintData
+{
+	XMFLOAT3 r1_local;
+	XMFLOAT3 r2_local;
+	XMFLOAT3 distance;
+	float compliance;
+	float lambda;
+};
+
+struct PBDCollisionConstraintData
+{
+	XMFLOAT3 r1_local;
+	XMFLOAT3 r2_local;
+	XMFLOAT3 normal;
+	float lambda_t;
+	float lambda_n;
+	float lambda_n_warm;
+	PBDCachedContact* cached_contact;
+};
+
+// The bodies and the data of constraint i are at index i of both arrays.
+// The bodies are kept apart so that the coloring only walks them.
+struct PBDPositionalConstraintBatch
+{
+	PBDArenaVector<PBDConstraintBodyPair> bodies;
+	PBDArenaVector<PBDPositionalConstraintData> constraints;
+};
+
+struct PBDCollisionConstraintBatch
+{
+	PBDArenaVector<PBDConstraintBodyPair> bodies;
+	PBDArenaVector<PBDCollisionConstraintData> constraints;
+};
+
+// Joints of an island. The data and lambdas of joint i stay in the joint store of the world, at index indices[i].
+struct PBDJointBatch
+{
+	PBDArenaVector<PBDConstraintBodyPair> bodies;
+	PBDArenaVector<uint32_t> indices;
+};
+
+// Constraints of a substep in the form read by the solver, one tightly packed batch per constraint type.
+// The solver dispatches once per batch instead of once per constraint.
+struct PBDConstraintBatches
+{
+	PBDJointBatch joints;
+	PBDPositionalConstraintBatch positional;
+	PBDCollisionConstraintBatch collision;
+};
+
+// Sorts the constraints by type, keeping their order inside of each type. The previous content of the batches is discarded,
+// except for the joints.
+void BuildPBDConstraintBatches(const PBDBodyStore& bodies, const PBDArenaVector<Constraint>& constraints, PBDConstraintBatches* batches);
+
+// Looks up the bodies of the given joints. The joints don't change during a step, so this is done once per step.
+void BuildPBDJointBatch(const PBDBodyStore& bodies, const PBDJointStore& joints, const uint32_t* indices, size_t count, PBDJointBatch* batch);
\ No newline at end of file
@@ -0,0 +1,90 @@
+#include "PBDContactCache.h"
+
+uint64_t GetPBDContactPairKey(size_t s1_id, size_t s2_id)
+{
+	assert(s1_id <= UINT32_MAX && s2_id <= UINT32_MAX);
+
+	return (static_cast<uint64_t>(s1_id) << 32) | static_cast<uint64_t>(s2_id);
+}
+
+PBDContactManifold* FindOrCreatePBDContactManifold(PBDContactCache& cache, size_t s1_id, size_t s2_id)
+{
+	uint64_t key = GetPBDContactPairKey(s1_id, s2_id);
+
+	std::unordered_map<uint64_t, PBDContactManifold>::iterator found = cache.manifolds.find(key);
+	if (found == cache.manifolds.end())
+	{
+		PBDContactManifold manifold;
+		manifold.relativePosition = XMVectorZero();
+		manifold.relativeRotation = XMQuaternionIdentity();
+		manifold.lastUsedStep = cache.currentStep;
+		manifold.bValid = false;
+
+		found = cache.manifolds.emplace(key, manifold).first;
+	}
+
+	found->second.lastUsedStep = cache.currentStep;
+
+	return &found->second;
+}
+
+bool IsPBDContactManifoldReusable(const PBDContactManifold* manifold, XMVECTOR relativePosition, XMVECTOR relativeRotation,
+	float linearThreshold, float angularThreshold)
+{
+	if (false == manifold->bValid)
+	{
+		return false;
+	}
+
+	float linearMotionSq = XMVectorGetX(XMVector3LengthSq(relativePosition - manifold->relativePosition));
+	if (linearThreshold * linearThreshold < linearMotionSq)
+	{
+		return false;
+	}
+
+	// The angle between two unit quaternions q1 and q2 is 2 * acos(|q1 . q2|)
+	float cosHalfAngle = fabsf(XMVectorGetX(XMQuaternionDot(relativeRotation, manifold->relativeRotation)));
+	if (cosHalfAngle < cosf(0.5f * angularThreshold))
+	{
+		return false;
+	}
+
+	return true;
+}
+
+const PBDCachedContact* FindPBDCachedContact(const PBDCachedContact* contacts, size_t numContacts, uint32_t featureId)
+{
+	for (size_t i = 0; i < numContacts; ++i)
+	{
+		if (contacts[i].featureId == featureId)
+		{
+			return &contacts[i];
+		}
+	}
+
+	return nullptr;
+}
+
+void BeginPBDContactCacheStep(PBDContactCache& cache)
+{
+	++cache.currentStep;
+	cache.numNarrowphaseRuns = 0;
+	cache.numNarrowphaseSkips = 0;
+}
+
+void EndPBDContactCacheStep(PBDContactCache& cache)
+{
+	// Drop the manifolds of the pairs that weren't close enough to be tested during this step
+	std::unordered_map<uint64_t, PBDContactManifold>::iterator manifold = cache.manifolds.begin();
+	while (manifold != cache.manifolds.end())
+	{
+		if (manifold->second.lastUsedStep != cache.currentStep)
+		{
+			manifold = cache.manifolds.erase(manifold);
+		}
+		else
+		{
+			++manifold;
+		}
+	}
+}
\ No newline at end of file
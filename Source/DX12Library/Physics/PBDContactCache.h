@@ -0,0 +1,53 @@
+#pragma once
+
+#include "Common.h"
+#include "ColliderPairCache.h"
+#include <atomic>
+#include <unordered_map>
+
+// Contact kept from one substep to the next, expressed in the local frames of the two bodies
+struct PBDCachedContact
+{
+	uint32_t featureId;
+	XMVECTOR r1_local;
+	XMVECTOR r2_local;
+	XMVECTOR normal_local;	// in the local frame of the first body
+
+	// Normal lambda of the last substep, the warm start of the static friction bound.
+	// The tangential lambda isn't kept, the friction correction of every substep starts from the contact points again.
+	float lambda_n;
+};
+
+// Contacts of a body pair, together with the relative pose of the bodies when the narrowphase generated them
+struct PBDContactManifold
+{
+	XMVECTOR relativePosition;	// position of the second body in the local frame of the first one
+	XMVECTOR relativeRotation;	// rotation of the second body relative to the first one
+	uint64_t lastUsedStep;
+	bool bValid;
+	std::vector<PBDCachedContact> contacts;
+
+	// One per collider pair of the two bodies, also kept while the bodies are separated
+	std::vector<ColliderPairCache> pairCaches;
+};
+
+// Persistent cache of the contact manifolds, keyed by body pair
+// A manifold is reused as long as the relative motion of its bodies since the last narrowphase stays under the thresholds,
+// and dropped when its pair isn't seen by the broadphase during a step.
+struct PBDContactCache
+{
+	std::unordered_map<uint64_t, PBDContactManifold> manifolds;
+	uint64_t currentStep = 0;
+
+	// Statistics of the current step (islands may be simulated concurrently)
+	std::atomic<size_t> numNarrowphaseRuns = 0;
+	std::atomic<size_t> numNarrowphaseSkips = 0;
+};
+
+uint64_t GetPBDContactPairKey(size_t s1_id, size_t s2_id);
+PBDContactManifold* FindOrCreatePBDContactManifold(PBDContactCache& cache, size_t s1_id, size_t s2_id);
+bool IsPBDContactManifoldReusable(const PBDContactManifold* manifold, XMVECTOR relativePosition, XMVECTOR relativeRotation,
+	float linearThreshold, float angularThreshold);
+const PBDCachedContact* FindPBDCachedContact(const PBDCachedContact* contacts, size_t numContacts, uint32_t featureId);
+void BeginPBDContactCacheStep(PBDContactCache& cache);
+void EndPBDContactCacheStep(PBDContactCache& cache);
\ No newline at end of file
@@ -0,0 +1,603 @@
+#include "PBDContactSolver.h"
+#include "PBDBaseConstraint.h"
+#include "PBDSimdLanes.h"
+
+constexpr size_t CONTACT_SOLVE_MAX_WIDTH = PBD_WIDE_LANES_MAX_WIDTH;
+
+// Structure of arrays of one side of the contacts of a group
+struct ContactBodyGroup
+{
+	float px[CONTACT_SOLVE_MAX_WIDTH];
+	float py[CONTACT_SOLVE_MAX_WIDTH];
+	float pz[CONTACT_SOLVE_MAX_WIDTH];
+	float qx[CONTACT_SOLVE_MAX_WIDTH];
+	float qy[CONTACT_SOLVE_MAX_WIDTH];
+	float qz[CONTACT_SOLVE_MAX_WIDTH];
+	float qw[CONTACT_SOLVE_MAX_WIDTH];
+	float inverseMass[CONTACT_SOLVE_MAX_WIDTH];
+
+	// World inverse inertia tensor
+	float ixx[CONTACT_SOLVE_MAX_WIDTH];
+	float iyy[CONTACT_SOLVE_MAX_WIDTH];
+	float izz[CONTACT_SOLVE_MAX_WIDTH];
+	float ixy[CONTACT_SOLVE_MAX_WIDTH];
+	float ixz[CONTACT_SOLVE_MAX_WIDTH];
+	float iyz[CONTACT_SOLVE_MAX_WIDTH];
+
+	// Pose at the start of the substep, read by the static friction
+	float prevPx[CONTACT_SOLVE_MAX_WIDTH];
+	float prevPy[CONTACT_SOLVE_MAX_WIDTH];
+	float prevPz[CONTACT_SOLVE_MAX_WIDTH];
+	float prevQx[CONTACT_SOLVE_MAX_WIDTH];
+	float prevQy[CONTACT_SOLVE_MAX_WIDTH];
+	float prevQz[CONTACT_SOLVE_MAX_WIDTH];
+	float prevQw[CONTACT_SOLVE_MAX_WIDTH];
+};
+
+// Structure of arrays of one group of contacts
+struct ContactSolveGroup
+{
+	uint32_t s1[CONTACT_SOLVE_MAX_WIDTH];
+	uint32_t s2[CONTACT_SOLVE_MAX_WIDTH];
+	ContactBodyGroup body1;
+	ContactBodyGroup body2;
+
+	float r1x[CONTACT_SOLVE_MAX_WIDTH];
+	float r1y[CONTACT_SOLVE_MAX_WIDTH];
+	float r1z[CONTACT_SOLVE_MAX_WIDTH];
+	float r2x[CONTACT_SOLVE_MAX_WIDTH];
+	float r2y[CONTACT_SOLVE_MAX_WIDTH];
+	float r2z[CONTACT_SOLVE_MAX_WIDTH];
+	float nx[CONTACT_SOLVE_MAX_WIDTH];
+	float ny[CONTACT_SOLVE_MAX_WIDTH];
+	float nz[CONTACT_SOLVE_MAX_WIDTH];
+	float staticFriction[CONTACT_SOLVE_MAX_WIDTH];
+	float lambdaN[CONTACT_SOLVE_MAX_WIDTH];
+	float lambdaNWarm[CONTACT_SOLVE_MAX_WIDTH];
+	float lambdaT[CONTACT_SOLVE_MAX_WIDTH];
+};
+
+template<typename Lanes>
+struct Vector3Lanes
+{
+	typename Lanes::Type x, y, z;
+};
+
+template<typename Lanes>
+struct QuaternionLanes
+{
+	typename Lanes::Type x, y, z, w;
+};
+
+template<typename Lanes>
+struct ContactBodyLanes
+{
+	Vector3Lanes<Lanes> position;
+	QuaternionLanes<Lanes> rotation;
+	typename Lanes::Type inverseMass;
+	typename Lanes::Type ixx, iyy, izz, ixy, ixz, iyz;
+};
+
+template<typename Lanes>
+static Vector3Lanes<Lanes> loadVector3(const float* x, const float* y, const float* z)
+{
+	return { Lanes::Load(x), Lanes::Load(y), Lanes::Load(z) };
+}
+
+template<typename Lanes>
+static Vector3Lanes<Lanes> add3(const Vector3Lanes<Lanes>& a, const Vector3Lanes<Lanes>& b)
+{
+	return { Lanes::Add(a.x, b.x), Lanes::Add(a.y, b.y), Lanes::Add(a.z, b.z) };
+}
+
+template<typename Lanes>
+static Vector3Lanes<Lanes> sub3(const Vector3Lanes<Lanes>& a, const Vector3Lanes<Lanes>& b)
+{
+	return { Lanes::Sub(a.x, b.x), Lanes::Sub(a.y, b.y), Lanes::Sub(a.z, b.z) };
+}
+
+template<typename Lanes>
+static Vector3Lanes<Lanes> scale3(typename Lanes::Type s, const Vector3Lanes<Lanes>& v)
+{
+	return { Lanes::Mul(s, v.x), Lanes::Mul(s, v.y), Lanes::Mul(s, v.z) };
+}
+
+template<typename Lanes>
+static Vector3Lanes<Lanes> divide3(const Vector3Lanes<Lanes>& v, typename Lanes::Type s)
+{
+	return { Lanes::Div(v.x, s), Lanes::Div(v.y, s), Lanes::Div(v.z, s) };
+}
+
+template<typename Lanes>
+static typename Lanes::Type dot3(const Vector3Lanes<Lanes>& a, const Vector3Lanes<Lanes>& b)
+{
+	return Lanes::Add(Lanes::Add(Lanes::Mul(a.x, b.x), Lanes::Mul(a.y, b.y)), Lanes::Mul(a.z, b.z));
+}
+
+template<typename Lanes>
+static Vector3Lanes<Lanes> cross3(const Vector3Lanes<Lanes>& a, const Vector3Lanes<Lanes>& b)
+{
+	return {
+		Lanes::Sub(Lanes::Mul(a.y, b.z), Lanes::Mul(a.z, b.y)),
+		Lanes::Sub(Lanes::Mul(a.z, b.x), Lanes::Mul(a.x, b.z)),
+		Lanes::Sub(Lanes::Mul(a.x, b.y), Lanes::Mul(a.y, b.x)) };
+}
+
+// v + 2w(u x v) + 2u x (u x v), the rotation of XMVector3Rotate
+template<typename Lanes>
+static Vector3Lanes<Lanes> rotate3(const Vector3Lanes<Lanes>& v, const QuaternionLanes<Lanes>& q)
+{
+	Vector3Lanes<Lanes> u = { q.x, q.y, q.z };
+	Vector3Lanes<Lanes> t = scale3<Lanes>(Lanes::Set1(2.0f), cross3<Lanes>(u, v));
+
+	return add3<Lanes>(add3<Lanes>(v, scale3<Lanes>(q.w, t)), cross3<Lanes>(u, t));
+}
+
+template<typename Lanes>
+static Vector3Lanes<Lanes> transformInverseInertia(const ContactBodyLanes<Lanes>& body, const Vector3Lanes<Lanes>& v)
+{
+	return {
+		Lanes::Add(Lanes::Add(Lanes::Mul(body.ixx, v.x), Lanes::Mul(body.ixy, v.y)), Lanes::Mul(body.ixz, v.z)),
+		Lanes::Add(Lanes::Add(Lanes::Mul(body.ixy, v.x), Lanes::Mul(body.iyy, v.y)), Lanes::Mul(body.iyz, v.z)),
+		Lanes::Add(Lanes::Add(Lanes::Mul(body.ixz, v.x), Lanes::Mul(body.iyz, v.y)), Lanes::Mul(body.izz, v.z)) };
+}
+
+template<typename Lanes>
+static typename Lanes::Type getGeneralizedInverseMass(const ContactBodyLanes<Lanes>& body, const Vector3Lanes<Lanes>& r_world, const Vector3Lanes<Lanes>& n)
+{
+	Vector3Lanes<Lanes> rn = cross3<Lanes>(r_world, n);
+
+	return Lanes::Add(body.inverseMass, dot3<Lanes>(rn, transformInverseInertia<Lanes>(body, rn)));
+}
+
+// Correction of ApplyPositionalConstraint for one side of the contacts.
+// The position moves along the impulse (against it when bAgainstImpulse is set), the rotation is turned by the angular
+// impulse r_world x impulse and renormalized.
+template<typename Lanes>
+static void correctBody(ContactBodyLanes<Lanes>& body, const Vector3Lanes<Lanes>& r_world, const Vector3Lanes<Lanes>& impulse, bool bAgainstImpulse)
+{
+	typedef typename Lanes::Type Type;
+
+	Vector3Lanes<Lanes> linear = scale3<Lanes>(body.inverseMass, impulse);
+	body.position = true == bAgainstImpulse ? sub3<Lanes>(body.position, linear) : add3<Lanes>(body.position, linear);
+
+	// q * (angular, 0), as computed by XMQuaternionMultiply(angular, q)
+	Vector3Lanes<Lanes> a = transformInverseInertia<Lanes>(body, cross3<Lanes>(r_world, impulse));
+	const QuaternionLanes<Lanes>& q = body.rotation;
+	Type dqx = Lanes::Sub(Lanes::Add(Lanes::Mul(q.w, a.x), Lanes::Mul(q.y, a.z)), Lanes::Mul(q.z, a.y));
+	Type dqy = Lanes::Add(Lanes::Sub(Lanes::Mul(q.w, a.y), Lanes::Mul(q.x, a.z)), Lanes::Mul(q.z, a.x));
+	Type dqz = Lanes::Sub(Lanes::Add(Lanes::Mul(q.w, a.z), Lanes::Mul(q.x, a.y)), Lanes::Mul(q.y, a.x));
+	Type dqw = Lanes::Sub(Lanes::Sub(Lanes::Sub(Lanes::Set1(0.0f), Lanes::Mul(q.x, a.x)), Lanes::Mul(q.y, a.y)), Lanes::Mul(q.z, a.z));
+
+	Type half = Lanes::Set1(0.5f);
+	Type x = Lanes::Add(q.x, Lanes::Mul(half, dqx));
+	Type y = Lanes::Add(q.y, Lanes::Mul(half, dqy));
+	Type z = Lanes::Add(q.z, Lanes::Mul(half, dqz));
+	Type w = Lanes::Add(q.w, Lanes::Mul(half, dqw));
+	Type length = Lanes::Sqrt(Lanes::Add(Lanes::Add(Lanes::Add(Lanes::Mul(x, x), Lanes::Mul(y, y)), Lanes::Mul(z, z)), Lanes::Mul(w, w)));
+	body.rotation = { Lanes::Div(x, length), Lanes::Div(y, length), Lanes::Div(z, length), Lanes::Div(w, length) };
+}
+
+template<typename Lanes>
+static ContactBodyLanes<Lanes> loadBody(const ContactBodyGroup& group)
+{
+	ContactBodyLanes<Lanes> body;
+	body.position = loadVector3<Lanes>(group.px, group.py, group.pz);
+	body.rotation = { Lanes::Load(group.qx), Lanes::Load(group.qy), Lanes::Load(group.qz), Lanes::Load(group.qw) };
+	body.inverseMass = Lanes::Load(group.inverseMass);
+	body.ixx = Lanes::Load(group.ixx);
+	body.iyy = Lanes::Load(group.iyy);
+	body.izz = Lanes::Load(group.izz);
+	body.ixy = Lanes::Load(group.ixy);
+	body.ixz = Lanes::Load(group.ixz);
+	body.iyz = Lanes::Load(group.iyz);
+
+	return body;
+}
+
+template<typename Lanes>
+static void storeBodyPose(const ContactBodyLanes<Lanes>& body, ContactBodyGroup* group)
+{
+	Lanes::Store(group->px, body.position.x);
+	Lanes::Store(group->py, body.position.y);
+	Lanes::Store(group->pz, body.position.z);
+	Lanes::Store(group->qx, body.rotation.x);
+	Lanes::Store(group->qy, body.rotation.y);
+	Lanes::Store(group->qz, body.rotation.z);
+	Lanes::Store(group->qw, body.rotation.w);
+}
+
+// Reads the pose and the world inverse inertia of the bodies, padding the lanes past count with a resting body
+static void gatherBodies(const PBDBodyStore& bodies, const uint32_t* slots, size_t count, size_t width, ContactBodyGroup* group)
+{
+	for (size_t l = 0; l < width; ++l)
+	{
+		if (l < count)
+		{
+			size_t s = slots[l];
+			XMFLOAT3 p;
+			XMFLOAT4 q;
+			XMStoreFloat3(&p, bodies.positions[s]);
+			XMStoreFloat4(&q, bodies.rotations[s]);
+			const PBDSymmetricMatrix3& m = bodies.worldInverseInertiaTensors[s];
+
+			group->px[l] = p.x;
+			group->py[l] = p.y;
+			group->pz[l] = p.z;
+			group->qx[l] = q.x;
+			group->qy[l] = q.y;
+			group->qz[l] = q.z;
+			group->qw[l] = q.w;
+			group->inverseMass[l] = bodies.inverseMasses[s];
+			group->ixx[l] = m.xx;
+			group->iyy[l] = m.yy;
+			group->izz[l] = m.zz;
+			group->ixy[l] = m.xy;
+			group->ixz[l] = m.xz;
+			group->iyz[l] = m.yz;
+		}
+		else
+		{
+			group->px[l] = group->py[l] = group->pz[l] = 0.0f;
+			group->qx[l] = group->qy[l] = group->qz[l] = 0.0f;
+			group->qw[l] = 1.0f;
+			group->inverseMass[l] = 1.0f;
+			group->ixx[l] = group->iyy[l] = group->izz[l] = 1.0f;
+			group->ixy[l] = group->ixz[l] = group->iyz[l] = 0.0f;
+		}
+	}
+}
+
+static void gatherPreviousPoses(const PBDBodyStore& bodies, const uint32_t* slots, size_t count, size_t width, ContactBodyGroup* group)
+{
+	for (size_t l = 0; l < width; ++l)
+	{
+		XMFLOAT3 p = XMFLOAT3(0.0f, 0.0f, 0.0f);
+		XMFLOAT4 q = XMFLOAT4(0.0f, 0.0f, 0.0f, 1.0f);
+		if (l < count)
+		{
+			XMStoreFloat3(&p, bodies.prevPositions[slots[l]]);
+			XMStoreFloat4(&q, bodies.prevRotations[slots[l]]);
+		}
+
+		group->prevPx[l] = p.x;
+		group->prevPy[l] = p.y;
+		group->prevPz[l] = p.z;
+		group->prevQx[l] = q.x;
+		group->prevQy[l] = q.y;
+		group->prevQz[l] = q.z;
+		group->prevQw[l] = q.w;
+	}
+}
+
+// Writes the corrected poses of the lanes set in mask back to the bodies. Fixed bodies are never written,
+// as they may be shared by several lanes and by other threads.
+static void scatterBodies(PBDBodyStore& bodies, const uint32_t* slots, size_t count, int mask, const ContactBodyGroup* group)
+{
+	for (size_t l = 0; l < count; ++l)
+	{
+		size_t s = slots[l];
+		if (0 == (mask & (1 << l)) || 0 != bodies.bFixed[s])
+		{
+			continue;
+		}
+
+		bodies.positions[s] = XMVectorSet(group->px[l], group->py[l], group->pz[l], XMVectorGetW(bodies.positions[s]));
+		bodies.rotations[s] = XMVectorSet(group->qx[l], group->qy[l], group->qz[l], group->qw[l]);
+	}
+}
+
+template<typename Lanes>
+static void solveContactGroup(PBDBodyStore& bodies, PBDCollisionConstraintBatch& batch, const size_t* indices, size_t count, ContactSolveGroup* group)
+{
+	typedef typename Lanes::Type Type;
+
+	// Gather the contacts, padding the last group with contacts whose bodies are never apart
+	for (size_t l = 0; l < Lanes::WIDTH; ++l)
+	{
+		if (l < count)
+		{
+			const PBDConstraintBodyPair& pair = batch.bodies[indices[l]];
+			const PBDCollisionConstraintData& constraint = batch.constraints[indices[l]];
+
+			group->s1[l] = pair.s1;
+			group->s2[l] = pair.s2;
+			group->r1x[l] = constraint.r1_local.x;
+			group->r1y[l] = constraint.r1_local.y;
+			group->r1z[l] = constraint.r1_local.z;
+			group->r2x[l] = constraint.r2_local.x;
+			group->r2y[l] = constraint.r2_local.y;
+			group->r2z[l] = constraint.r2_local.z;
+			group->nx[l] = constraint.normal.x;
+			group->ny[l] = constraint.normal.y;
+			group->nz[l] = constraint.normal.z;
+			group->staticFriction[l] = (bodies.staticFrictionCoefficients[pair.s1] + bodies.staticFrictionCoefficients[pair.s2]) * 0.5f;
+			group->lambdaN[l] = constraint.lambda_n;
+			group->lambdaNWarm[l] = constraint.lambda_n_warm;
+			group->lambdaT[l] = constraint.lambda_t;
+		}
+		else
+		{
+			group->r1x[l] = group->r1y[l] = group->r1z[l] = 0.0f;
+			group->r2x[l] = group->r2y[l] = group->r2z[l] = 0.0f;
+			group->nx[l] = group->ny[l] = group->nz[l] = 0.0f;
+			group->staticFriction[l] = 0.0f;
+			group->lambdaN[l] = group->lambdaNWarm[l] = group->lambdaT[l] = 0.0f;
+		}
+	}
+
+	gatherBodies(bodies, group->s1, count, Lanes::WIDTH, &group->body1);
+	gatherBodies(bodies, group->s2, count, Lanes::WIDTH, &group->body2);
+
+	const Type zero = Lanes::Set1(0.0f);
+	const Type epsilon = Lanes::Set1(FLT_EPSILON);
+	Vector3Lanes<Lanes> r1_local = loadVector3<Lanes>(group->r1x, group->r1y, group->r1z);
+	Vector3Lanes<Lanes> r2_local = loadVector3<Lanes>(group->r2x, group->r2y, group->r2z);
+	Vector3Lanes<Lanes> n = loadVector3<Lanes>(group->nx, group->ny, group->nz);
+
+	// Penetration along the normal
+	ContactBodyLanes<Lanes> b1 = loadBody<Lanes>(group->body1);
+	ContactBodyLanes<Lanes> b2 = loadBody<Lanes>(group->body2);
+	Vector3Lanes<Lanes> r1_world = rotate3<Lanes>(r1_local, b1.rotation);
+	Vector3Lanes<Lanes> r2_world = rotate3<Lanes>(r2_local, b2.rotation);
+	Type d = dot3<Lanes>(sub3<Lanes>(add3<Lanes>(b1.position, r1_world), add3<Lanes>(b2.position, r2_world)), n);
+
+	int contactMask = Lanes::CompareLess(zero, d);
+	if (0 == contactMask)
+	{
+		return;
+	}
+
+	// The correction is skipped (delta lambda is zero) where the penetration is too small to give a direction
+	Vector3Lanes<Lanes> delta_x = scale3<Lanes>(d, n);
+	Type c = Lanes::Sqrt(dot3<Lanes>(delta_x, delta_x));
+	int normalMask = contactMask & Lanes::CompareLess(epsilon, c);
+	Vector3Lanes<Lanes> direction = divide3<Lanes>(delta_x, c);
+
+	Type w1 = getGeneralizedInverseMass<Lanes>(b1, r1_world, direction);
+	Type w2 = getGeneralizedInverseMass<Lanes>(b2, r2_world, direction);
+	Type deltaLambda = Lanes::SelectLess(epsilon, c, Lanes::Div(Lanes::Sub(zero, c), Lanes::Add(w1, w2)), zero);
+	Type lambdaN = Lanes::Add(Lanes::Load(group->lambdaN), deltaLambda);
+
+	Vector3Lanes<Lanes> impulse = scale3<Lanes>(deltaLambda, direction);
+	correctBody<Lanes>(b1, r1_world, impulse, false);
+	correctBody<Lanes>(b2, r2_world, impulse, true);
+	storeBodyPose<Lanes>(b1, &group->body1);
+	storeBodyPose<Lanes>(b2, &group->body2);
+	scatterBodies(bodies, group->s1, count, normalMask, &group->body1);
+	scatterBodies(bodies, group->s2, count, normalMask, &group->body2);
+
+	// Tangential delta lambda along the same direction, with the corrected poses
+	gatherBodies(bodies, group->s1, count, Lanes::WIDTH, &group->body1);
+	gatherBodies(bodies, group->s2, count, Lanes::WIDTH, &group->body2);
+	b1 = loadBody<Lanes>(group->body1);
+	b2 = loadBody<Lanes>(group->body2);
+	r1_world = rotate3<Lanes>(r1_local, b1.rotation);
+	r2_world = rotate3<Lanes>(r2_local, b2.rotation);
+
+	w1 = getGeneralizedInverseMass<Lanes>(b1, r1_world, direction);
+	w2 = getGeneralizedInverseMass<Lanes>(b2, r2_world, direction);
+	deltaLambda = Lanes::SelectLess(epsilon, c, Lanes::Div(Lanes::Sub(zero, c), Lanes::Add(w1, w2)), zero);
+
+	// Static friction, where the tangential lambda stays within the cone of the (warm-started) normal lambda.
+	// Lambdas are negative, so the warm-started bound is the smaller of the two
+	Type lambdaT = Lanes::Add(Lanes::Load(group->lambdaT), deltaLambda);
+	Type lambdaNBound = Lanes::Min(lambdaN, Lanes::Load(group->lambdaNWarm));
+	int frictionMask = contactMask & Lanes::CompareLess(Lanes::Mul(Lanes::Load(group->staticFriction), lambdaNBound), lambdaT);
+
+	if (0 != frictionMask)
+	{
+		gatherPreviousPoses(bodies, group->s1, count, Lanes::WIDTH, &group->body1);
+		gatherPreviousPoses(bodies, group->s2, count, Lanes::WIDTH, &group->body2);
+		const ContactBodyGroup& g1 = group->body1;
+		const ContactBodyGroup& g2 = group->body2;
+		QuaternionLanes<Lanes> prevRotation1 = { Lanes::Load(g1.prevQx), Lanes::Load(g1.prevQy), Lanes::Load(g1.prevQz), Lanes::Load(g1.prevQw) };
+		QuaternionLanes<Lanes> prevRotation2 = { Lanes::Load(g2.prevQx), Lanes::Load(g2.prevQy), Lanes::Load(g2.prevQz), Lanes::Load(g2.prevQw) };
+
+		Vector3Lanes<Lanes> p1 = add3<Lanes>(b1.position, r1_world);
+		Vector3Lanes<Lanes> p2 = add3<Lanes>(b2.position, r2_world);
+		Vector3Lanes<Lanes> p1_til = add3<Lanes>(loadVector3<Lanes>(g1.prevPx, g1.prevPy, g1.prevPz), rotate3<Lanes>(r1_local, prevRotation1));
+		Vector3Lanes<Lanes> p2_til = add3<Lanes>(loadVector3<Lanes>(g2.prevPx, g2.prevPy, g2.prevPz), rotate3<Lanes>(r2_local, prevRotation2));
+		Vector3Lanes<Lanes> delta_p = sub3<Lanes>(sub3<Lanes>(p1, p1_til), sub3<Lanes>(p2, p2_til));
+		Vector3Lanes<Lanes> delta_p_t = sub3<Lanes>(delta_p, scale3<Lanes>(dot3<Lanes>(delta_p, n), n));
+
+		Type c_t = Lanes::Sqrt(dot3<Lanes>(delta_p_t, delta_p_t));
+		int tangentMask = frictionMask & Lanes::CompareLess(epsilon, c_t);
+		impulse = scale3<Lanes>(deltaLambda, divide3<Lanes>(delta_p_t, c_t));
+		correctBody<Lanes>(b1, r1_world, impulse, false);
+		correctBody<Lanes>(b2, r2_world, impulse, true);
+		storeBodyPose<Lanes>(b1, &group->body1);
+		storeBodyPose<Lanes>(b2, &group->body2);
+		scatterBodies(bodies, group->s1, count, tangentMask, &group->body1);
+		scatterBodies(bodies, group->s2, count, tangentMask, &group->body2);
+	}
+
+	Lanes::Store(group->lambdaN, lambdaN);
+	Lanes::Store(group->lambdaT, lambdaT);
+	for (size_t l = 0; l < count; ++l)
+	{
+		PBDCollisionConstraintData& constraint = batch.constraints[indices[l]];
+		if (0 != (contactMask & (1 << l)))
+		{
+			constraint.lambda_n = group->lambdaN[l];
+		}
+		if (0 != (frictionMask & (1 << l)))
+		{
+			constraint.lambda_t = group->lambdaT[l];
+		}
+	}
+}
+
+void SolvePBDContactConstraint(PBDBodyStore& bodies, const PBDConstraintBodyPair& constraintBodies, PBDCollisionConstraintData* constraint, float h)
+{
+	size_t s1 = constraintBodies.s1;
+	size_t s2 = constraintBodies.s2;
+	XMVECTOR r1_local = XMLoadFloat3(&constraint->r1_local);
+	XMVECTOR r2_local = XMLoadFloat3(&constraint->r2_local);
+	XMVECTOR normal = XMLoadFloat3(&constraint->normal);
+
+	PositionalConstraintPreprocessedData pcpd;
+	CalculatePositionalConstraintPreprocessedData(bodies, s1, s2, r1_local, r2_local, &pcpd);
+
+	// Calculate p1 and p2 in order to calculate d
+	XMVECTOR p1 = bodies.positions[s1] + pcpd.r1_world;
+	XMVECTOR p2 = bodies.positions[s2] + pcpd.r2_world;
+	float d = XMVectorGetX(XMVector3Dot(p1 - p2, normal));
+
+	if (0.0f < d)
+	{
+		XMVECTOR delta_x = d * normal;
+		float delta_lambda = GetPositionalConstraintDeltaLambda(bodies, &pcpd, h, 0.0f, constraint->lambda_n, delta_x);
+		ApplyPositionalConstraint(bodies, &pcpd, delta_lambda, delta_x);
+		constraint->lambda_n += delta_lambda;
+
+		// Recalculate shape pair preprocessed data and p1, p2
+		CalculatePositionalConstraintPreprocessedData(bodies, s1, s2, r1_local, r2_local, &pcpd);
+
+		p1 = bodies.positions[s1] + pcpd.r1_world;
+		p2 = bodies.positions[s2] + pcpd.r2_world;
+
+		delta_lambda = GetPositionalConstraintDeltaLambda(bodies, &pcpd, h, 0.0f, constraint->lambda_t, delta_x);
+
+		// Static friction
+		const float staticFrictionCoefficient = (bodies.staticFrictionCoefficients[s1] + bodies.staticFrictionCoefficients[s2]) * 0.5f;
+
+		// Lambdas are negative, so the warm-started bound is the smaller of the two
+		float lambda_t = constraint->lambda_t + delta_lambda;
+		float lambda_n = fminf(constraint->lambda_n, constraint->lambda_n_warm);
+		if (staticFrictionCoefficient * lambda_n < lambda_t)
+		{
+			XMVECTOR p1_til = bodies.prevPositions[s1] + XMVector3Rotate(r1_local, bodies.prevRotations[s1]);
+			XMVECTOR p2_til = bodies.prevPositions[s2] + XMVector3Rotate(r2_local, bodies.prevRotations[s2]);
+			XMVECTOR delta_p = (p1 - p1_til) - (p2 - p2_til);
+			XMVECTOR delta_p_t = delta_p - XMVectorGetX(XMVector3Dot(delta_p, normal)) * normal;
+
+			ApplyPositionalConstraint(bodies, &pcpd, delta_lambda, delta_p_t);
+			constraint->lambda_t += delta_lambda;
+		}
+	}
+}
+
+void SolvePBDContactConstraintsWide(PBDBodyStore& bodies, PBDCollisionConstraintBatch& batch, const size_t* indices, size_t count)
+{
+	ContactSolveGroup group;
+
+	for (size_t i = 0; i < count; i += PBDWideLanes::WIDTH)
+	{
+		size_t groupCount = count - i < PBDWideLanes::WIDTH ? count - i : PBDWideLanes::WIDTH;
+		solveContactGroup<PBDWideLanes>(bodies, batch, indices + i, groupCount, &group);
+	}
+}
+
+// State written by the contact solves for one contact
+struct ContactSolveResult
+{
+	XMVECTOR positions[2];
+	XMVECTOR rotations[2];
+	float lambda_n;
+	float lambda_t;
+};
+
+static void readContactSolveResult(const PBDBodyStore& bodies, const PBDCollisionConstraintBatch& batch, size_t index, ContactSolveResult* result)
+{
+	const PBDConstraintBodyPair& pair = batch.bodies[index];
+	size_t slots[2] = { pair.s1, pair.s2 };
+
+	for (size_t b = 0; b < 2; ++b)
+	{
+		result->positions[b] = bodies.positions[slots[b]];
+		result->rotations[b] = bodies.rotations[slots[b]];
+	}
+	result->lambda_n = batch.constraints[index].lambda_n;
+	result->lambda_t = batch.constraints[index].lambda_t;
+}
+
+// Only the non-fixed bodies are written back, the fixed ones are never modified by the solves
+static void writeContactSolveResult(PBDBodyStore& bodies, PBDCollisionConstraintBatch& batch, size_t index, const ContactSolveResult* result)
+{
+	const PBDConstraintBodyPair& pair = batch.bodies[index];
+	size_t slots[2] = { pair.s1, pair.s2 };
+
+	for (size_t b = 0; b < 2; ++b)
+	{
+		if (0 == bodies.bFixed[slots[b]])
+		{
+			bodies.positions[slots[b]] = result->positions[b];
+			bodies.rotations[slots[b]] = result->rotations[b];
+		}
+	}
+	batch.constraints[index].lambda_n = result->lambda_n;
+	batch.constraints[index].lambda_t = result->lambda_t;
+}
+
+// Relative to the magnitude of the values, so that large lambdas get the same number of matching digits as the poses
+static bool isNearlyEqual(float a, float b, float tolerance)
+{
+	return fabsf(a - b) <= tolerance * fmaxf(1.0f, fmaxf(fabsf(a), fabsf(b)));
+}
+
+static bool isNearlyEqual(FXMVECTOR a, FXMVECTOR b, float tolerance)
+{
+	XMFLOAT4 va;
+	XMFLOAT4 vb;
+	XMStoreFloat4(&va, a);
+	XMStoreFloat4(&vb, b);
+
+	return true == isNearlyEqual(va.x, vb.x, tolerance) && true == isNearlyEqual(va.y, vb.y, tolerance) &&
+		true == isNearlyEqual(va.z, vb.z, tolerance) && true == isNearlyEqual(va.w, vb.w, tolerance);
+}
+
+static bool isNearlyEqual(const ContactSolveResult& a, const ContactSolveResult& b, float tolerance)
+{
+	for (size_t i = 0; i < 2; ++i)
+	{
+		if (false == isNearlyEqual(a.positions[i], b.positions[i], tolerance) || false == isNearlyEqual(a.rotations[i], b.rotations[i], tolerance))
+		{
+			return false;
+		}
+	}
+
+	return true == isNearlyEqual(a.lambda_n, b.lambda_n, tolerance) && true == isNearlyEqual(a.lambda_t, b.lambda_t, tolerance);
+}
+
+size_t VerifyPBDContactConstraintsWide(PBDBodyStore& bodies, PBDCollisionConstraintBatch& batch, const size_t* indices, size_t count,
+	float h, float tolerance)
+{
+	ContactSolveGroup group;
+	ContactSolveResult initial[CONTACT_SOLVE_MAX_WIDTH];
+	ContactSolveResult scalar[CONTACT_SOLVE_MAX_WIDTH];
+	ContactSolveResult wide;
+	size_t numMismatches = 0;
+
+	for (size_t i = 0; i < count; i += PBDWideLanes::WIDTH)
+	{
+		size_t groupCount = count - i < PBDWideLanes::WIDTH ? count - i : PBDWideLanes::WIDTH;
+
+		// The contacts of a group share no non-fixed body, so each one can be solved alone from the state it starts from,
+		// which is then restored for the wide kernel
+		for (size_t l = 0; l < groupCount; ++l)
+		{
+			readContactSolveResult(bodies, batch, indices[i + l], &initial[l]);
+		}
+		for (size_t l = 0; l < groupCount; ++l)
+		{
+			size_t index = indices[i + l];
+			SolvePBDContactConstraint(bodies, batch.bodies[index], &batch.constraints[index], h);
+			readContactSolveResult(bodies, batch, index, &scalar[l]);
+			writeContactSolveResult(bodies, batch, index, &initial[l]);
+		}
+
+		solveContactGroup<PBDWideLanes>(bodies, batch, indices + i, groupCount, &group);
+
+		for (size_t l = 0; l < groupCount; ++l)
+		{
+			readContactSolveResult(bodies, batch, indices[i + l], &wide);
+			if (false == isNearlyEqual(wide, scalar[l], tolerance))
+			{
+				++numMismatches;
+			}
+		}
+	}
+
+	return numMismatches;
+}
\ No newline at end of file
@@ -0,0 +1,18 @@
+#pragma once
+
+#include "PBDConstraintBatches.h"
+
+// Position solve of one contact constraint: normal correction, then static friction against the friction bound
+// warm-started from the cached normal lambda
+void SolvePBDContactConstraint(PBDBodyStore& bodies, const PBDConstraintBodyPair& constraintBodies, PBDCollisionConstraintData* constraint, float h);
+
+// Position solve of contact constraints, 4 contacts at a time with SSE (8 with AVX).
+// Same steps as SolvePBDContactConstraint, with the branches turned into lane masks. indices point into the collision batch, and the contacts must share no non-fixed body,
+// which holds for the contacts of a color of the graph coloring.
+void SolvePBDContactConstraintsWide(PBDBodyStore& bodies, PBDCollisionConstraintBatch& batch, const size_t* indices, size_t count);
+
+// Solves the contacts with both the wide kernel and SolvePBDContactConstraint, starting from the same state, and compares the
+// bodies and lambdas they write. The bodies are left as the wide kernel wrote them. Returns the number of contacts whose results
+// differ by more than tolerance, relative to the magnitude of the values.
+size_t VerifyPBDContactConstraintsWide(PBDBodyStore& bodies, PBDCollisionConstraintBatch& batch, const size_t* indices, size_t count,
+	float h, float tolerance);
\ No newline at end of file
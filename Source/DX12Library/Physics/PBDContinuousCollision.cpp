@@ -0,0 +1,188 @@
+#include "PBDContinuousCollision.h"
+#include "TriangleMesh.h"
+#include "Heightfield.h"
+
+// The advancement stops once the bodies are closer than this fraction of the smaller bounding radius
+static constexpr float TIME_OF_IMPACT_TOLERANCE_RATIO = 0.02f;
+static constexpr size_t TIME_OF_IMPACT_MAX_ITERATIONS = 32;
+
+bool IsPBDPairMovingFast(const PBDBodyStore& bodies, size_t s1, size_t s2, float motionRatio)
+{
+	XMVECTOR motion1 = bodies.positions[s1] - bodies.prevPositions[s1];
+	XMVECTOR motion2 = bodies.positions[s2] - bodies.prevPositions[s2];
+	float relativeMotion = XMVectorGetX(XMVector3Length(motion1 - motion2));
+	float minRadius = fminf(bodies.boundingSphereRadii[s1], bodies.boundingSphereRadii[s2]);
+
+	return motionRatio * minRadius < relativeMotion;
+}
+
+// Pose of the body at the fraction t of the substep
+static void getBodyPose(const PBDBodyStore& bodies, size_t s, float t, XMVECTOR* position, XMVECTOR* rotation)
+{
+	if (1.0f <= t)
+	{
+		*position = bodies.positions[s];
+		*rotation = bodies.rotations[s];
+		return;
+	}
+
+	*position = XMVectorLerp(bodies.prevPositions[s], bodies.positions[s], t);
+	*rotation = XMQuaternionSlerp(bodies.prevRotations[s], bodies.rotations[s], t);
+}
+
+// Fixed bodies keep their pose, which also keeps their colliders untouched by the concurrent islands
+static void setBodyCollidersPose(PBDBodyStore& bodies, size_t s, float t)
+{
+	if (0 != bodies.bFixed[s])
+	{
+		return;
+	}
+
+	XMVECTOR position;
+	XMVECTOR rotation;
+	getBodyPose(bodies, s, t, &position, &rotation);
+	UpdateColliders(bodies.shapes[s]->colliders, position, rotation);
+}
+
+// Rotation angle of the body over the substep
+static float getBodyRotationAngle(const PBDBodyStore& bodies, size_t s)
+{
+	XMVECTOR deltaRotation = XMQuaternionMultiply(bodies.rotations[s], XMQuaternionInverse(bodies.prevRotations[s]));
+	return 2.0f * acosf(fminf(fabsf(XMVectorGetW(deltaRotation)), 1.0f));
+}
+
+// Triangle meshes and heightfields only take the triangles within maxDistance of the other collider into account,
+// the other collider being first
+static bool getStaticGeometryDistance(Collider* convex, Collider* geometry, float maxDistance, GJKDistanceResult* result)
+{
+	if (geometry->type == ColliderType::TRIANGLE_MESH)
+	{
+		return GetConvexTriangleMeshDistance(convex, geometry, maxDistance, result);
+	}
+
+	return GetConvexHeightfieldDistance(convex, geometry, maxDistance, result);
+}
+
+static bool getColliderDistance(Collider* collider1, Collider* collider2, float maxDistance, GJKDistanceResult* result)
+{
+	if (true == IsColliderStaticGeometry(collider2))
+	{
+		return getStaticGeometryDistance(collider1, collider2, maxDistance, result);
+	}
+
+	if (true == IsColliderStaticGeometry(collider1))
+	{
+		if (false == getStaticGeometryDistance(collider2, collider1, maxDistance, result))
+		{
+			return false;
+		}
+
+		XMVECTOR point1 = result->point1;
+		result->point1 = result->point2;
+		result->point2 = point1;
+		result->normal = -result->normal;
+		return true;
+	}
+
+	return GJKDistance(collider1, collider2, result);
+}
+
+// Closest points of the nearest collider pair, false when any of them overlap or none is within maxDistance
+static bool getCollidersDistance(std::vector<Collider>& colliders1, std::vector<Collider>& colliders2, float maxDistance, GJKDistanceResult* result)
+{
+	result->distance = FLT_MAX;
+	for (size_t i = 0; i < colliders1.size(); ++i)
+	{
+		for (size_t j = 0; j < colliders2.size(); ++j)
+		{
+			GJKDistanceResult distance;
+			if (false == getColliderDistance(&colliders1[i], &colliders2[j], maxDistance, &distance))
+			{
+				return false;
+			}
+
+			if (distance.distance < result->distance)
+			{
+				*result = distance;
+			}
+		}
+	}
+
+	return FLT_MAX != result->distance;
+}
+
+bool GetPBDTimeOfImpactConstraint(PBDBodyStore& bodies, size_t s1, size_t s2, Constraint* constraint)
+{
+	std::vector<Collider>& colliders1 = bodies.shapes[s1]->colliders;
+	std::vector<Collider>& colliders2 = bodies.shapes[s2]->colliders;
+
+	const float tolerance = TIME_OF_IMPACT_TOLERANCE_RATIO * fminf(bodies.boundingSphereRadii[s1], bodies.boundingSphereRadii[s2]);
+	const XMVECTOR motion1 = bodies.positions[s1] - bodies.prevPositions[s1];
+	const XMVECTOR motion2 = bodies.positions[s2] - bodies.prevPositions[s2];
+	const float angularMotionBound = getBodyRotationAngle(bodies, s1) * bodies.boundingSphereRadii[s1]
+		+ getBodyRotationAngle(bodies, s2) * bodies.boundingSphereRadii[s2];
+
+	// No point of the bodies gets closer than this over the substep
+	const float maxApproach = XMVectorGetX(XMVector3Length(motion1 - motion2)) + angularMotionBound;
+
+	float t = 0.0f;
+	bool bImpact = false;
+	GJKDistanceResult distance;
+	for (size_t i = 0; i < TIME_OF_IMPACT_MAX_ITERATIONS; ++i)
+	{
+		setBodyCollidersPose(bodies, s1, t);
+		setBodyCollidersPose(bodies, s2, t);
+
+		if (false == getCollidersDistance(colliders1, colliders2, maxApproach, &distance))
+		{
+			// Already overlapping at the start of the substep, which the discrete contacts take care of, or out of reach
+			break;
+		}
+
+		if (distance.distance < tolerance)
+		{
+			bImpact = true;
+			break;
+		}
+
+		// No point of the bodies closes the gap faster than this over the substep
+		float approachBound = XMVectorGetX(XMVector3Dot(motion1 - motion2, distance.normal)) + angularMotionBound;
+		if (approachBound <= 0.0f)
+		{
+			break;
+		}
+
+		t += distance.distance / approachBound;
+		if (1.0f < t)
+		{
+			break;
+		}
+	}
+
+	if (true == bImpact)
+	{
+		XMVECTOR position1;
+		XMVECTOR position2;
+		XMVECTOR rotation1;
+		XMVECTOR rotation2;
+		getBodyPose(bodies, s1, 0 != bodies.bFixed[s1] ? 1.0f : t, &position1, &rotation1);
+		getBodyPose(bodies, s2, 0 != bodies.bFixed[s2] ? 1.0f : t, &position2, &rotation2);
+
+		constraint->type = ConstraintType::COLLISION_CONSTRAINT;
+		constraint->s1_id = bodies.slotToHandle[s1];
+		constraint->s2_id = bodies.slotToHandle[s2];
+		constraint->collision_constraint.normal = distance.normal;
+		constraint->collision_constraint.r1_local = XMVector3InverseRotate(distance.point1 - position1, rotation1);
+		constraint->collision_constraint.r2_local = XMVector3InverseRotate(distance.point2 - position2, rotation2);
+		constraint->collision_constraint.lambda_t = 0.0f;
+		constraint->collision_constraint.lambda_n = 0.0f;
+		constraint->collision_constraint.lambda_n_warm = 0.0f;
+		constraint->collision_constraint.cached_contact = nullptr;
+	}
+
+	// Back to the current poses
+	setBodyCollidersPose(bodies, s1, 1.0f);
+	setBodyCollidersPose(bodies, s2, 1.0f);
+
+	return bImpact;
+}
\ No newline at end of file
@@ -0,0 +1,11 @@
+#pragma once
+
+#include "PBD.h"
+
+// Whether the bodies moved relative to each other by more than motionRatio times the smaller bounding radius during the substep
+bool IsPBDPairMovingFast(const PBDBodyStore& bodies, size_t s1, size_t s2, float motionRatio);
+
+// Conservative advancement of the two bodies from their poses at the start of the substep to their current poses.
+// When they touch on the way, the contact at the time of impact is returned as a constraint anchored in the local frames
+// of the bodies, so that the solver pushes them back from wherever they ended up.
+bool GetPBDTimeOfImpactConstraint(PBDBodyStore& bodies, size_t s1, size_t s2, Constraint* constraint);
\ No newline at end of file
@@ -0,0 +1,69 @@
+#include "PBDFrameArena.h"
+#include <atomic>
+
+static thread_local PBDFrameArena* s_threadFrameArena = nullptr;
+static std::atomic<size_t> s_numUnboundArenaAllocations{ 0 };
+
+void* AllocatePBDFrameArena(PBDFrameArena& arena, size_t size, size_t alignment)
+{
+	assert(0 != alignment && 0 == (alignment & (alignment - 1)));
+
+	if (0 == size)
+	{
+		size = 1;
+	}
+
+	// Look for room in the current block, then in the blocks kept from the previous steps
+	while (arena.currentBlock < arena.blocks.size())
+	{
+		uintptr_t base = reinterpret_cast<uintptr_t>(arena.blocks[arena.currentBlock].get());
+		uintptr_t aligned = (base + arena.offset + alignment - 1) & ~(static_cast<uintptr_t>(alignment) - 1);
+		if (aligned + size <= base + arena.blockSizes[arena.currentBlock])
+		{
+			arena.offset = aligned + size - base;
+			arena.numBytesAllocated += size;
+			return reinterpret_cast<void*>(aligned);
+		}
+
+		++arena.currentBlock;
+		arena.offset = 0;
+	}
+
+	// Out of blocks, requests larger than a block get a block of their own
+	size_t blockSize = size + alignment < PBD_FRAME_ARENA_BLOCK_SIZE ? PBD_FRAME_ARENA_BLOCK_SIZE : size + alignment;
+	arena.blocks.push_back(std::make_unique<uint8_t[]>(blockSize));
+	arena.blockSizes.push_back(blockSize);
+	arena.currentBlock = arena.blocks.size() - 1;
+	arena.offset = 0;
+	++arena.numHeapAllocations;
+
+	return AllocatePBDFrameArena(arena, size, alignment);
+}
+
+void ResetPBDFrameArena(PBDFrameArena& arena)
+{
+	arena.currentBlock = 0;
+	arena.offset = 0;
+	arena.numHeapAllocations = 0;
+	arena.numBytesAllocated = 0;
+}
+
+PBDFrameArena* GetPBDThreadFrameArena(void)
+{
+	return s_threadFrameArena;
+}
+
+void SetPBDThreadFrameArena(PBDFrameArena* arena)
+{
+	s_threadFrameArena = arena;
+}
+
+size_t GetPBDUnboundArenaAllocationCount(void)
+{
+	return s_numUnboundArenaAllocations.load(std::memory_order_relaxed);
+}
+
+void CountPBDUnboundArenaAllocation(void)
+{
+	s_numUnboundArenaAllocations.fetch_add(1, std::memory_order_relaxed);
+}
\ No newline at end of file
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "Common.h"
+#include <memory>
+
+// Linear allocator for the scratch memory of one simulation step.
+// Memory is handed out by bumping an offset inside large blocks and is only released all at once by ResetPBDFrameArena.
+// Blocks are kept across resets, so once the arena has grown to what a step needs, steps stop allocating from the heap.
+struct PBDFrameArena
+{
+	std::vector<std::unique_ptr<uint8_t[]>> blocks;
+	std::vector<size_t> blockSizes;
+	size_t currentBlock = 0;
+	size_t offset = 0;
+
+	// Since the last reset
+	size_t numHeapAllocations = 0;
+	size_t numBytesAllocated = 0;
+};
+
+constexpr size_t PBD_FRAME_ARENA_BLOCK_SIZE = 1 << 20;
+
+void* AllocatePBDFrameArena(PBDFrameArena& arena, size_t size, size_t alignment);
+void ResetPBDFrameArena(PBDFrameArena& arena);
+
+// Arena of the calling thread, used by every PBDArenaVector created on it (nullptr outside of a simulation step)
+PBDFrameArena* GetPBDThreadFrameArena(void);
+void SetPBDThreadFrameArena(PBDFrameArena* arena);
+
+// Heap allocations made by PBDArenaVectors created while their thread had no arena
+size_t GetPBDUnboundArenaAllocationCount(void);
+void CountPBDUnboundArenaAllocation(void);
+
+// Standard allocator drawing from the arena of the thread that created it, or from the heap when there is none.
+// Memory given by an arena is never freed individually, so a vector using it must not outlive the step.
+template<typename T>
+struct PBDArenaAllocator
+{
+	typedef T value_type;
+
+	PBDFrameArena* arena;
+
+	PBDArenaAllocator(void) : arena(GetPBDThreadFrameArena()) {}
+	explicit PBDArenaAllocator(PBDFrameArena* frameArena) : arena(frameArena) {}
+	template<typename U> PBDArenaAllocator(const PBDArenaAllocator<U>& other) : arena(other.arena) {}
+
+	T* allocate(size_t n)
+	{
+		if (nullptr == arena)
+		{
+			CountPBDUnboundArenaAllocation();
+			return static_cast<T*>(::operator new(n * sizeof(T)));
+		}
+
+		return static_cast<T*>(AllocatePBDFrameArena(*arena, n * sizeof(T), alignof(T)));
+	}
+
+	void deallocate(T* p, size_t n)
+	{
+		UNREFERENCED_PARAMETER(n);
+
+		if (nullptr == arena)
+		{
+			::operator delete(p);
+		}
+	}
+
+	template<typename U> bool operator==(const PBDArenaAllocator<U>& other) const { return arena == other.arena; }
+	template<typename U> bool operator!=(const PBDArenaAllocator<U>& other) const { return arena != other.arena; }
+};
+
+template<typename T>
+using PBDArenaVector = std::vector<T, PBDArenaAllocator<T>>;
\ No newline at end of file
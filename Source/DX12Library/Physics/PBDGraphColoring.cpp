@@ -0,0 +1,119 @@
+#include "PBDGraphColoring.h"
+#include <algorithm>
+#include <bit>
+
+static constexpr uint8_t SEQUENTIAL_COLOR = UINT8_MAX;
+
+void ColorPBDConstraints(const PBDBodyStore& bodies, const PBDArenaVector<PBDConstraintBodyPair>& constraintBodies, PBDConstraintColoring* coloring)
+{
+	size_t numConstraints = constraintBodies.size();
+
+	coloring->bodyColorMasks.assign(GetPBDBodyCount(bodies), 0);
+	coloring->constraintColors.resize(numConstraints);
+
+	size_t colorCounts[PBD_MAX_CONSTRAINT_COLORS] = {};
+	size_t numSequential = 0;
+	size_t numColors = 0;
+
+	// Greedily give every constraint the lowest color that none of its non-fixed bodies uses yet
+	// Fixed bodies are never written by the solver, so they can be shared by any number of constraints of a color
+	for (size_t i = 0; i < numConstraints; ++i)
+	{
+		size_t s1 = constraintBodies[i].s1;
+		size_t s2 = constraintBodies[i].s2;
+		bool bIsS1Fixed = 0 != bodies.bFixed[s1];
+		bool bIsS2Fixed = 0 != bodies.bFixed[s2];
+
+		uint64_t usedColors = 0;
+		if (false == bIsS1Fixed)
+		{
+			usedColors |= coloring->bodyColorMasks[s1];
+		}
+		if (false == bIsS2Fixed)
+		{
+			usedColors |= coloring->bodyColorMasks[s2];
+		}
+
+		if (UINT64_MAX == usedColors)
+		{
+			coloring->constraintColors[i] = SEQUENTIAL_COLOR;
+			++numSequential;
+			continue;
+		}
+
+		size_t color = static_cast<size_t>(std::countr_one(usedColors));
+		uint64_t colorBit = static_cast<uint64_t>(1) << color;
+		if (false == bIsS1Fixed)
+		{
+			coloring->bodyColorMasks[s1] |= colorBit;
+		}
+		if (false == bIsS2Fixed)
+		{
+			coloring->bodyColorMasks[s2] |= colorBit;
+		}
+
+		coloring->constraintColors[i] = static_cast<uint8_t>(color);
+		++colorCounts[color];
+		if (numColors <= color)
+		{
+			numColors = color + 1;
+		}
+	}
+
+	// Counting sort of the constraints by color, keeping the original order inside of each color
+	coloring->colorOffsets.resize(numColors + 1);
+	coloring->colorOffsets[0] = 0;
+	for (size_t c = 0; c < numColors; ++c)
+	{
+		coloring->colorOffsets[c + 1] = coloring->colorOffsets[c] + colorCounts[c];
+	}
+	coloring->sequentialOffset = coloring->colorOffsets[numColors];
+
+	size_t cursors[PBD_MAX_CONSTRAINT_COLORS];
+	for (size_t c = 0; c < numColors; ++c)
+	{
+		cursors[c] = coloring->colorOffsets[c];
+	}
+	size_t sequentialCursor = coloring->sequentialOffset;
+
+	coloring->constraintIndices.resize(numConstraints);
+	for (size_t i = 0; i < numConstraints; ++i)
+	{
+		uint8_t color = coloring->constraintColors[i];
+		if (SEQUENTIAL_COLOR == color)
+		{
+			coloring->constraintIndices[sequentialCursor++] = i;
+		}
+		else
+		{
+			coloring->constraintIndices[cursors[color]++] = i;
+		}
+	}
+
+	assert(sequentialCursor == numConstraints);
+	assert(coloring->sequentialOffset + numSequential == numConstraints);
+}
+
+size_t GetPBDConstraintColorCount(const PBDConstraintColoring* coloring)
+{
+	return coloring->colorOffsets.empty() ? 0 : coloring->colorOffsets.size() - 1;
+}
+
+// Orders the constraints by the handles of their bodies, so that the solve order doesn't depend on the order in which they were generated
+void SortPBDConstraintsByBodies(PBDArenaVector<Constraint>& constraints)
+{
+	std::stable_sort(constraints.begin(), constraints.end(), [](const Constraint& c1, const Constraint& c2)
+		{
+			size_t c1Min = c1.s1_id < c1.s2_id ? c1.s1_id : c1.s2_id;
+			size_t c1Max = c1.s1_id < c1.s2_id ? c1.s2_id : c1.s1_id;
+			size_t c2Min = c2.s1_id < c2.s2_id ? c2.s1_id : c2.s2_id;
+			size_t c2Max = c2.s1_id < c2.s2_id ? c2.s2_id : c2.s1_id;
+
+			if (c1Min != c2Min)
+			{
+				return c1Min < c2Min;
+			}
+
+			return c1Max < c2Max;
+		});
+}
\ No newline at end of file
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "PBDConstraintBatches.h"
+
+// Partition of a constraint array into colors.
+// No two constraints of the same color share a non-fixed body, so all the constraints of a color can be solved concurrently.
+struct PBDConstraintColoring
+{
+	// Constraint indices grouped by color. Color c spans [colorOffsets[c], colorOffsets[c + 1])
+	PBDArenaVector<size_t> constraintIndices;
+	PBDArenaVector<size_t> colorOffsets;
+
+	// Constraints that didn't fit in any color start at this offset and must be solved sequentially
+	size_t sequentialOffset;
+
+	// Scratch
+	PBDArenaVector<uint64_t> bodyColorMasks;
+	PBDArenaVector<uint8_t> constraintColors;
+};
+
+// Maximum number of colors, one bit of the per-body color mask each
+constexpr size_t PBD_MAX_CONSTRAINT_COLORS = 64;
+
+// Colors the constraints of a batch, given the bodies of each of them
+void ColorPBDConstraints(const PBDBodyStore& bodies, const PBDArenaVector<PBDConstraintBodyPair>& constraintBodies, PBDConstraintColoring* coloring);
+size_t GetPBDConstraintColorCount(const PBDConstraintColoring* coloring);
+void SortPBDConstraintsByBodies(PBDArenaVector<Constraint>& constraints);
\ No newline at end of file
@@ -0,0 +1,167 @@
+#include "PBDIslands.h"
+
+static uint32_t findRoot(PBDArenaVector<uint32_t>& parents, uint32_t s)
+{
+	// Path halving
+	while (parents[s] != s)
+	{
+		parents[s] = parents[parents[s]];
+		s = parents[s];
+	}
+
+	return s;
+}
+
+static void unite(const PBDBodyStore& bodies, PBDArenaVector<uint32_t>& parents, size_t s1, size_t s2)
+{
+	if (0 != bodies.bFixed[s1] || 0 != bodies.bFixed[s2])
+	{
+		return;
+	}
+
+	uint32_t root1 = findRoot(parents, static_cast<uint32_t>(s1));
+	uint32_t root2 = findRoot(parents, static_cast<uint32_t>(s2));
+
+	// The lowest slot stays the root, which keeps the numbering of the islands independent of the union order
+	if (root1 < root2)
+	{
+		parents[root2] = root1;
+	}
+	else if (root2 < root1)
+	{
+		parents[root1] = root2;
+	}
+}
+
+// Island of an element connecting two bodies, given by whichever body isn't fixed
+static uint32_t getConnectionIsland(const PBDIslands* islands, size_t s1, size_t s2)
+{
+	return PBD_NO_ISLAND != islands->bodyIslands[s1] ? islands->bodyIslands[s1] : islands->bodyIslands[s2];
+}
+
+// Counting sort of the elements by island
+static void groupByIsland(const PBDArenaVector<uint32_t>& elementIslands, size_t numIslands, PBDArenaVector<uint32_t>& grouped, PBDArenaVector<size_t>& offsets)
+{
+	offsets.assign(numIslands + 1, 0);
+	for (size_t i = 0; i < elementIslands.size(); ++i)
+	{
+		if (PBD_NO_ISLAND != elementIslands[i])
+		{
+			++offsets[elementIslands[i] + 1];
+		}
+	}
+
+	for (size_t i = 0; i < numIslands; ++i)
+	{
+		offsets[i + 1] += offsets[i];
+	}
+
+	grouped.resize(offsets[numIslands]);
+	PBDArenaVector<size_t> cursors(offsets.begin(), offsets.end() - 1);
+	for (size_t i = 0; i < elementIslands.size(); ++i)
+	{
+		if (PBD_NO_ISLAND != elementIslands[i])
+		{
+			grouped[cursors[elementIslands[i]]++] = static_cast<uint32_t>(i);
+		}
+	}
+}
+
+void BuildPBDIslands(const PBDBodyStore& bodies, const PBDArenaVector<BroadCollisionPair>& pairs, const std::vector<Constraint>* constraints,
+	const PBDJointStore& joints, PBDIslands* islands)
+{
+	size_t numBodies = GetPBDBodyCount(bodies);
+
+	PBDArenaVector<uint32_t>& parents = islands->parents;
+	parents.resize(numBodies);
+	for (size_t s = 0; s < numBodies; ++s)
+	{
+		parents[s] = static_cast<uint32_t>(s);
+	}
+
+	for (size_t i = 0; i < pairs.size(); ++i)
+	{
+		unite(bodies, parents, GetPBDBodySlot(bodies, pairs[i].s1_id), GetPBDBodySlot(bodies, pairs[i].s2_id));
+	}
+
+	size_t numConstraints = nullptr == constraints ? 0 : constraints->size();
+	for (size_t i = 0; i < numConstraints; ++i)
+	{
+		const Constraint* constraint = &constraints->at(i);
+		unite(bodies, parents, GetPBDBodySlot(bodies, constraint->s1_id), GetPBDBodySlot(bodies, constraint->s2_id));
+	}
+
+	size_t numJoints = GetPBDJointCount(joints);
+	for (size_t i = 0; i < numJoints; ++i)
+	{
+		const PBDJoint* joint = &joints.joints[i];
+		unite(bodies, parents, GetPBDBodySlot(bodies, joint->s1_id), GetPBDBodySlot(bodies, joint->s2_id));
+	}
+
+	// Number the islands in the order of their lowest slot
+	size_t numIslands = 0;
+	islands->bodyIslands.resize(numBodies);
+	for (size_t s = 0; s < numBodies; ++s)
+	{
+		if (0 != bodies.bFixed[s])
+		{
+			islands->bodyIslands[s] = PBD_NO_ISLAND;
+			continue;
+		}
+
+		uint32_t root = findRoot(parents, static_cast<uint32_t>(s));
+		if (root == s)
+		{
+			islands->bodyIslands[s] = static_cast<uint32_t>(numIslands++);
+		}
+		else
+		{
+			islands->bodyIslands[s] = islands->bodyIslands[root];
+		}
+	}
+
+	PBDArenaVector<uint32_t> elementIslands(pairs.size());
+	for (size_t i = 0; i < pairs.size(); ++i)
+	{
+		elementIslands[i] = getConnectionIsland(islands, GetPBDBodySlot(bodies, pairs[i].s1_id), GetPBDBodySlot(bodies, pairs[i].s2_id));
+	}
+	groupByIsland(elementIslands, numIslands, islands->islandPairs, islands->pairOffsets);
+
+	elementIslands.resize(numConstraints);
+	for (size_t i = 0; i < numConstraints; ++i)
+	{
+		const Constraint* constraint = &constraints->at(i);
+		elementIslands[i] = getConnectionIsland(islands, GetPBDBodySlot(bodies, constraint->s1_id), GetPBDBodySlot(bodies, constraint->s2_id));
+	}
+	groupByIsland(elementIslands, numIslands, islands->islandConstraints, islands->constraintOffsets);
+
+	elementIslands.resize(numJoints);
+	for (size_t i = 0; i < numJoints; ++i)
+	{
+		const PBDJoint* joint = &joints.joints[i];
+		elementIslands[i] = getConnectionIsland(islands, GetPBDBodySlot(bodies, joint->s1_id), GetPBDBodySlot(bodies, joint->s2_id));
+	}
+	groupByIsland(elementIslands, numIslands, islands->islandJoints, islands->jointOffsets);
+
+	groupByIsland(islands->bodyIslands, numIslands, islands->islandBodies, islands->bodyOffsets);
+}
+
+size_t GetPBDIslandCount(const PBDIslands* islands)
+{
+	return islands->bodyOffsets.empty() ? 0 : islands->bodyOffsets.size() - 1;
+}
+
+PBDIslandRange GetPBDIsland(const PBDIslands* islands, size_t island)
+{
+	PBDIslandRange range;
+	range.bodies = islands->islandBodies.data() + islands->bodyOffsets[island];
+	range.numBodies = islands->bodyOffsets[island + 1] - islands->bodyOffsets[island];
+	range.pairs = islands->islandPairs.data() + islands->pairOffsets[island];
+	range.numPairs = islands->pairOffsets[island + 1] - islands->pairOffsets[island];
+	range.constraints = islands->islandConstraints.data() + islands->constraintOffsets[island];
+	range.numConstraints = islands->constraintOffsets[island + 1] - islands->constraintOffsets[island];
+	range.joints = islands->islandJoints.data() + islands->jointOffsets[island];
+	range.numJoints = islands->jointOffsets[island + 1] - islands->jointOffsets[island];
+
+	return range;
+}
\ No newline at end of file
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "PBD.h"
+
+constexpr uint32_t PBD_NO_ISLAND = UINT32_MAX;
+
+// Bodies, broadphase pairs, external constraints and joints of one island, as indices into the arrays given to BuildPBDIslands
+struct PBDIslandRange
+{
+	const uint32_t* bodies;
+	size_t numBodies;
+	const uint32_t* pairs;
+	size_t numPairs;
+	const uint32_t* constraints;
+	size_t numConstraints;
+	const uint32_t* joints;
+	size_t numJoints;
+};
+
+// Partition of the bodies into islands, groups of bodies connected through broadphase pairs, external constraints or joints.
+// Fixed bodies don't propagate the connection, so that everything resting on the same ground doesn't end up in one island.
+// Pairs, constraints and joints between two fixed bodies don't belong to any island.
+struct PBDIslands
+{
+	// Island of every body slot (PBD_NO_ISLAND for fixed bodies)
+	PBDArenaVector<uint32_t> bodyIslands;
+
+	// Island i spans [bodyOffsets[i], bodyOffsets[i + 1]) in islandBodies, and likewise for the pairs, constraints and joints
+	PBDArenaVector<uint32_t> islandBodies;
+	PBDArenaVector<size_t> bodyOffsets;
+	PBDArenaVector<uint32_t> islandPairs;
+	PBDArenaVector<size_t> pairOffsets;
+	PBDArenaVector<uint32_t> islandConstraints;
+	PBDArenaVector<size_t> constraintOffsets;
+	PBDArenaVector<uint32_t> islandJoints;
+	PBDArenaVector<size_t> jointOffsets;
+
+	// Scratch
+	PBDArenaVector<uint32_t> parents;
+};
+
+void BuildPBDIslands(const PBDBodyStore& bodies, const PBDArenaVector<BroadCollisionPair>& pairs, const std::vector<Constraint>* constraints,
+	const PBDJointStore& joints, PBDIslands* islands);
+size_t GetPBDIslandCount(const PBDIslands* islands);
+PBDIslandRange GetPBDIsland(const PBDIslands* islands, size_t island);
\ No newline at end of file
@@ -0,0 +1,130 @@
+#include "PBDJobSystem.h"
+
+PBDJobSystem::PBDJobSystem(size_t numThreads)
+	: m_workers()
+	, m_mutex()
+	, m_wakeCondition()
+	, m_doneCondition()
+	, m_generation(0)
+	, m_numBusyWorkers(0)
+	, m_bShutdown(false)
+	, m_pJob(nullptr)
+	, m_count(0)
+	, m_batchSize(1)
+	, m_nextIndex(0)
+{
+	assert(0 < numThreads);
+
+	// The calling thread is thread 0
+	for (size_t i = 1; i < numThreads; ++i)
+	{
+		m_workers.emplace_back(&PBDJobSystem::workerMain, this, i);
+	}
+}
+
+PBDJobSystem::~PBDJobSystem()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_bShutdown = true;
+	}
+	m_wakeCondition.notify_all();
+
+	for (size_t i = 0; i < m_workers.size(); ++i)
+	{
+		m_workers[i].join();
+	}
+}
+
+size_t PBDJobSystem::GetNumThreads(void) const
+{
+	return m_workers.size() + 1;
+}
+
+size_t PBDJobSystem::GetDefaultNumThreads(void)
+{
+	unsigned int numHardwareThreads = std::thread::hardware_concurrency();
+
+	return 0 == numHardwareThreads ? 1 : static_cast<size_t>(numHardwareThreads);
+}
+
+void PBDJobSystem::ParallelFor(size_t count, size_t batchSize, const RangeJob& job)
+{
+	if (0 == count)
+	{
+		return;
+	}
+
+	if (0 == batchSize)
+	{
+		batchSize = 1;
+	}
+
+	// Not worth waking up the workers
+	if (true == m_workers.empty() || count <= batchSize)
+	{
+		job(0, count, 0);
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_pJob = &job;
+		m_count = count;
+		m_batchSize = batchSize;
+		m_nextIndex.store(0, std::memory_order_relaxed);
+		m_numBusyWorkers = m_workers.size();
+		++m_generation;
+	}
+	m_wakeCondition.notify_all();
+
+	executeBatches(0);
+
+	// Wait for the workers, so that the job can't outlive this call
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_doneCondition.wait(lock, [this] { return 0 == m_numBusyWorkers; });
+	m_pJob = nullptr;
+}
+
+void PBDJobSystem::workerMain(size_t threadIndex)
+{
+	uint64_t lastGeneration = 0;
+
+	for (;;)
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_wakeCondition.wait(lock, [this, lastGeneration] { return true == m_bShutdown || lastGeneration != m_generation; });
+
+			if (true == m_bShutdown)
+			{
+				return;
+			}
+
+			lastGeneration = m_generation;
+		}
+
+		executeBatches(threadIndex);
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			--m_numBusyWorkers;
+		}
+		m_doneCondition.notify_one();
+	}
+}
+
+void PBDJobSystem::executeBatches(size_t threadIndex)
+{
+	for (;;)
+	{
+		size_t begin = m_nextIndex.fetch_add(m_batchSize, std::memory_order_relaxed);
+		if (m_count <= begin)
+		{
+			return;
+		}
+
+		size_t end = begin + m_batchSize < m_count ? begin + m_batchSize : m_count;
+		(*m_pJob)(begin, end, threadIndex);
+	}
+}
\ No newline at end of file
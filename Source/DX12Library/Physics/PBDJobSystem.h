@@ -0,0 +1,49 @@
+#pragma once
+
+#include "Common.h"
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+// Fixed pool of worker threads used by the parallel phases of the PBD simulation.
+// The calling thread always takes part in the work, so a pool created with a single thread runs every job inline.
+class PBDJobSystem
+{
+public:
+	// Called with a half-open range [begin, end) and the index of the thread executing it (0 is the calling thread)
+	typedef std::function<void(size_t begin, size_t end, size_t threadIndex)> RangeJob;
+
+	PBDJobSystem(void) = delete;
+	explicit PBDJobSystem(size_t numThreads);
+	PBDJobSystem(const PBDJobSystem& other) = delete;
+	PBDJobSystem& operator=(const PBDJobSystem& other) = delete;
+	~PBDJobSystem();
+
+	size_t GetNumThreads(void) const;
+
+	// Splits [0, count) into batches of batchSize elements and blocks until all of them have been executed
+	void ParallelFor(size_t count, size_t batchSize, const RangeJob& job);
+
+	static size_t GetDefaultNumThreads(void);
+
+private:
+	void workerMain(size_t threadIndex);
+	void executeBatches(size_t threadIndex);
+
+	std::vector<std::thread> m_workers;
+
+	std::mutex m_mutex;
+	std::condition_variable m_wakeCondition;
+	std::condition_variable m_doneCondition;
+	uint64_t m_generation;
+	size_t m_numBusyWorkers;
+	bool m_bShutdown;
+
+	// Current job
+	const RangeJob* m_pJob;
+	size_t m_count;
+	size_t m_batchSize;
+	std::atomic<size_t> m_nextIndex;
+};
\ No newline at end of file
@@ -0,0 +1,242 @@
+#include "PBDJoints.h"
+#include "PBDBaseConstraint.h"
+#include "PBDSleeping.h"
+
+template<typename T>
+static void moveLastIndexInto(std::vector<T>& values, size_t index)
+{
+	values[index] = values.back();
+	values.pop_back();
+}
+
+// Joint with its anchors set from world space, the type specific fields are left to the caller
+static PBDJoint makeJoint(const PBDBodyStore& bodies, PBDJointType type, size_t body1, size_t body2, FXMVECTOR anchor1, FXMVECTOR anchor2,
+	float compliance, float angularCompliance)
+{
+	assert(body1 != body2);
+
+	size_t s1 = GetPBDBodySlot(bodies, body1);
+	size_t s2 = GetPBDBodySlot(bodies, body2);
+
+	PBDJoint joint = {};
+	joint.type = type;
+	joint.s1_id = body1;
+	joint.s2_id = body2;
+	XMStoreFloat3(&joint.r1_local, XMVector3InverseRotate(anchor1 - bodies.positions[s1], bodies.rotations[s1]));
+	XMStoreFloat3(&joint.r2_local, XMVector3InverseRotate(anchor2 - bodies.positions[s2], bodies.rotations[s2]));
+	XMStoreFloat4(&joint.restRotation, XMQuaternionMultiply(bodies.rotations[s2], XMQuaternionConjugate(bodies.rotations[s1])));
+	joint.compliance = compliance;
+	joint.angularCompliance = angularCompliance;
+
+	return joint;
+}
+
+static void setJointAxis(const PBDBodyStore& bodies, FXMVECTOR axis, PBDJoint* joint)
+{
+	XMVECTOR n = XMVector3Normalize(axis);
+	XMStoreFloat3(&joint->axis1_local, XMVector3InverseRotate(n, bodies.rotations[GetPBDBodySlot(bodies, joint->s1_id)]));
+	XMStoreFloat3(&joint->axis2_local, XMVector3InverseRotate(n, bodies.rotations[GetPBDBodySlot(bodies, joint->s2_id)]));
+}
+
+static size_t addJoint(PBDJointStore& joints, PBDBodyStore& bodies, const PBDJoint& joint)
+{
+	size_t index = joints.joints.size();
+
+	// Reuse the handle of a removed joint when possible, so that the handle table stays compact
+	size_t handle;
+	if (false == joints.freeHandles.empty())
+	{
+		handle = joints.freeHandles.back();
+		joints.freeHandles.pop_back();
+		joints.handleToIndex[handle] = index;
+	}
+	else
+	{
+		handle = joints.handleToIndex.size();
+		joints.handleToIndex.push_back(index);
+	}
+
+	joints.joints.push_back(joint);
+	joints.positionalLambdas.push_back(0.0f);
+	joints.angularLambdas.push_back(0.0f);
+	joints.indexToHandle.push_back(handle);
+
+	// The bodies may be asleep in different islands, which the joint now connects
+	WakePBDBody(bodies, joint.s1_id);
+	WakePBDBody(bodies, joint.s2_id);
+
+	return handle;
+}
+
+size_t AddPBDDistanceJoint(PBDJointStore& joints, PBDBodyStore& bodies, size_t body1, size_t body2, FXMVECTOR anchor1, FXMVECTOR anchor2, float compliance)
+{
+	PBDJoint joint = makeJoint(bodies, PBDJointType::DISTANCE, body1, body2, anchor1, anchor2, compliance, 0.0f);
+	joint.restDistance = XMVectorGetX(XMVector3Length(anchor1 - anchor2));
+
+	return addJoint(joints, bodies, joint);
+}
+
+size_t AddPBDBallJoint(PBDJointStore& joints, PBDBodyStore& bodies, size_t body1, size_t body2, FXMVECTOR anchor, float compliance)
+{
+	PBDJoint joint = makeJoint(bodies, PBDJointType::BALL, body1, body2, anchor, anchor, compliance, 0.0f);
+
+	return addJoint(joints, bodies, joint);
+}
+
+size_t AddPBDHingeJoint(PBDJointStore& joints, PBDBodyStore& bodies, size_t body1, size_t body2, FXMVECTOR anchor, FXMVECTOR axis,
+	float compliance, float angularCompliance)
+{
+	PBDJoint joint = makeJoint(bodies, PBDJointType::HINGE, body1, body2, anchor, anchor, compliance, angularCompliance);
+	setJointAxis(bodies, axis, &joint);
+
+	return addJoint(joints, bodies, joint);
+}
+
+size_t AddPBDSliderJoint(PBDJointStore& joints, PBDBodyStore& bodies, size_t body1, size_t body2, FXMVECTOR anchor, FXMVECTOR axis,
+	float compliance, float angularCompliance)
+{
+	PBDJoint joint = makeJoint(bodies, PBDJointType::SLIDER, body1, body2, anchor, anchor, compliance, angularCompliance);
+	setJointAxis(bodies, axis, &joint);
+
+	return addJoint(joints, bodies, joint);
+}
+
+size_t AddPBDFixedJoint(PBDJointStore& joints, PBDBodyStore& bodies, size_t body1, size_t body2, FXMVECTOR anchor,
+	float compliance, float angularCompliance)
+{
+	PBDJoint joint = makeJoint(bodies, PBDJointType::FIXED, body1, body2, anchor, anchor, compliance, angularCompliance);
+
+	return addJoint(joints, bodies, joint);
+}
+
+void RemovePBDJoint(PBDJointStore& joints, PBDBodyStore& bodies, size_t handle)
+{
+	size_t index = GetPBDJointIndex(joints, handle);
+	size_t lastIndex = joints.joints.size() - 1;
+
+	// The bodies lose their connection, they may have to move apart
+	WakePBDBody(bodies, joints.joints[index].s1_id);
+	WakePBDBody(bodies, joints.joints[index].s2_id);
+
+	// The last joint takes over the freed index
+	size_t movedHandle = joints.indexToHandle[lastIndex];
+	joints.handleToIndex[movedHandle] = index;
+	joints.handleToIndex[handle] = SIZE_MAX;
+	joints.freeHandles.push_back(handle);
+
+	moveLastIndexInto(joints.joints, index);
+	moveLastIndexInto(joints.positionalLambdas, index);
+	moveLastIndexInto(joints.angularLambdas, index);
+	moveLastIndexInto(joints.indexToHandle, index);
+}
+
+void RemovePBDBodyJoints(PBDJointStore& joints, PBDBodyStore& bodies, size_t body)
+{
+	// Removing a joint moves the last one into its index, so the index is checked again
+	size_t i = 0;
+	while (i < joints.joints.size())
+	{
+		if (body == joints.joints[i].s1_id || body == joints.joints[i].s2_id)
+		{
+			RemovePBDJoint(joints, bodies, joints.indexToHandle[i]);
+		}
+		else
+		{
+			++i;
+		}
+	}
+}
+
+void ReservePBDJoints(PBDJointStore& joints, size_t count)
+{
+	joints.joints.reserve(count);
+	joints.positionalLambdas.reserve(count);
+	joints.angularLambdas.reserve(count);
+	joints.indexToHandle.reserve(count);
+	joints.handleToIndex.reserve(count);
+	joints.freeHandles.reserve(count);
+}
+
+size_t GetPBDJointCount(const PBDJointStore& joints)
+{
+	return joints.joints.size();
+}
+
+size_t GetPBDJointIndex(const PBDJointStore& joints, size_t handle)
+{
+	assert(handle < joints.handleToIndex.size());
+	assert(SIZE_MAX != joints.handleToIndex[handle]);
+
+	return joints.handleToIndex[handle];
+}
+
+// Rotation vector of the first body relative to the second one, away from their relative rotation at rest
+static XMVECTOR getRelativeRotationError(const PBDBodyStore& bodies, size_t s1, size_t s2, FXMVECTOR restRotation)
+{
+	// q1 * restRotation * conj(q2) is the identity at rest
+	XMVECTOR q = XMQuaternionMultiply(XMQuaternionConjugate(bodies.rotations[s2]), XMQuaternionMultiply(restRotation, bodies.rotations[s1]));
+
+	// Take the shortest arc
+	float scale = 0.0f <= XMVectorGetW(q) ? 2.0f : -2.0f;
+
+	return scale * XMVectorSelect(XMVectorZero(), q, g_XMSelect1110);
+}
+
+void SolvePBDJoint(PBDBodyStore& bodies, PBDJointStore& joints, size_t index, size_t s1, size_t s2, float h)
+{
+	const PBDJoint& joint = joints.joints[index];
+
+	// Angular part
+	XMVECTOR delta_q = XMVectorZero();
+	switch (joint.type)
+	{
+	case PBDJointType::HINGE:
+	{
+		// Align the axes, a2 x a1 turns the axis of the second body onto the one of the first body
+		XMVECTOR a1 = XMVector3Rotate(XMLoadFloat3(&joint.axis1_local), bodies.rotations[s1]);
+		XMVECTOR a2 = XMVector3Rotate(XMLoadFloat3(&joint.axis2_local), bodies.rotations[s2]);
+		delta_q = XMVector3Cross(a2, a1);
+		break;
+	}
+	case PBDJointType::SLIDER:
+	case PBDJointType::FIXED:
+		delta_q = getRelativeRotationError(bodies, s1, s2, XMLoadFloat4(&joint.restRotation));
+		break;
+	default:
+		break;
+	}
+
+	if (PBDJointType::HINGE == joint.type || PBDJointType::SLIDER == joint.type || PBDJointType::FIXED == joint.type)
+	{
+		float delta_lambda = GetAngularConstraintDeltaLambda(bodies, s1, s2, h, joint.angularCompliance, joints.angularLambdas[index], delta_q);
+		ApplyAngularConstraint(bodies, s1, s2, delta_lambda, delta_q);
+		joints.angularLambdas[index] += delta_lambda;
+	}
+
+	// Positional part, with the anchors of the corrected rotations
+	PositionalConstraintPreprocessedData pcpd;
+	CalculatePositionalConstraintPreprocessedData(bodies, s1, s2, XMLoadFloat3(&joint.r1_local), XMLoadFloat3(&joint.r2_local), &pcpd);
+	XMVECTOR d = (bodies.positions[s1] + pcpd.r1_world) - (bodies.positions[s2] + pcpd.r2_world);
+
+	XMVECTOR delta_x = d;
+	if (PBDJointType::DISTANCE == joint.type)
+	{
+		float length = XMVectorGetX(XMVector3Length(d));
+		if (length <= FLT_EPSILON)
+		{
+			return;
+		}
+
+		delta_x = ((length - joint.restDistance) / length) * d;
+	}
+	else if (PBDJointType::SLIDER == joint.type)
+	{
+		// Only the offset across the axis is corrected
+		XMVECTOR a1 = XMVector3Rotate(XMLoadFloat3(&joint.axis1_local), bodies.rotations[s1]);
+		delta_x = d - XMVectorGetX(XMVector3Dot(d, a1)) * a1;
+	}
+
+	float delta_lambda = GetPositionalConstraintDeltaLambda(bodies, &pcpd, h, joint.compliance, joints.positionalLambdas[index], delta_x);
+	ApplyPositionalConstraint(bodies, &pcpd, delta_lambda, delta_x);
+	joints.positionalLambdas[index] += delta_lambda;
+}
\ No newline at end of file
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "PBDBodyStore.h"
+
+enum class PBDJointType
+{
+	// Keeps the anchors at their distance at creation
+	DISTANCE,
+	// Keeps the anchors together, the bodies rotate freely around them
+	BALL,
+	// Ball joint that also keeps the axes of both bodies aligned, the bodies only rotate around the axis
+	HINGE,
+	// Keeps the relative rotation of the bodies, the anchors only move apart along the axis
+	SLIDER,
+	// Keeps the anchors together and the relative rotation of the bodies
+	FIXED
+};
+
+// Joint between two bodies, referenced by their handles.
+// Anchors and axes are stored in the space of each body.
+struct PBDJoint
+{
+	PBDJointType type;
+	size_t s1_id;
+	size_t s2_id;
+	XMFLOAT3 r1_local;
+	XMFLOAT3 r2_local;
+
+	// Hinge or slider axis (unit length)
+	XMFLOAT3 axis1_local;
+	XMFLOAT3 axis2_local;
+
+	// conj(q1) * q2 at creation, kept by the slider and fixed joints
+	XMFLOAT4 restRotation;
+
+	float restDistance;
+
+	// Compliances (inverse stiffnesses) of the positional and angular parts, zero for a rigid joint
+	float compliance;
+	float angularCompliance;
+};
+
+// Joints of a world, kept across steps.
+// The joints live in packed arrays indexed like the bodies: a stable handle maps onto the current index,
+// and removing a joint moves the last one into the freed index.
+struct PBDJointStore
+{
+	std::vector<PBDJoint> joints;
+
+	// Lagrange multipliers of the positional and angular parts, reset at the start of every substep
+	std::vector<float> positionalLambdas;
+	std::vector<float> angularLambdas;
+
+	// Index <-> handle mapping
+	std::vector<size_t> indexToHandle;
+	std::vector<size_t> handleToIndex;
+	std::vector<size_t> freeHandles;
+};
+
+// Anchors and axes are given in world space, with the bodies in their current poses.
+// Adding or removing a joint wakes both of its bodies up.
+size_t AddPBDDistanceJoint(PBDJointStore& joints, PBDBodyStore& bodies, size_t body1, size_t body2, FXMVECTOR anchor1, FXMVECTOR anchor2, float compliance);
+size_t AddPBDBallJoint(PBDJointStore& joints, PBDBodyStore& bodies, size_t body1, size_t body2, FXMVECTOR anchor, float compliance);
+size_t AddPBDHingeJoint(PBDJointStore& joints, PBDBodyStore& bodies, size_t body1, size_t body2, FXMVECTOR anchor, FXMVECTOR axis,
+	float compliance, float angularCompliance);
+size_t AddPBDSliderJoint(PBDJointStore& joints, PBDBodyStore& bodies, size_t body1, size_t body2, FXMVECTOR anchor, FXMVECTOR axis,
+	float compliance, float angularCompliance);
+size_t AddPBDFixedJoint(PBDJointStore& joints, PBDBodyStore& bodies, size_t body1, size_t body2, FXMVECTOR anchor,
+	float compliance, float angularCompliance);
+void RemovePBDJoint(PBDJointStore& joints, PBDBodyStore& bodies, size_t handle);
+
+// Must be called before removing a body that has joints
+void RemovePBDBodyJoints(PBDJointStore& joints, PBDBodyStore& bodies, size_t body);
+
+// Preallocates the storage of count joints, so that adding them doesn't allocate
+void ReservePBDJoints(PBDJointStore& joints, size_t count);
+size_t GetPBDJointCount(const PBDJointStore& joints);
+size_t GetPBDJointIndex(const PBDJointStore& joints, size_t handle);
+
+// One XPBD iteration of a joint whose bodies are in slots s1 and s2: the angular part, then the positional part
+void SolvePBDJoint(PBDBodyStore& bodies, PBDJointStore& joints, size_t index, size_t s1, size_t s2, float h);
\ No newline at end of file
@@ -0,0 +1,345 @@
+#include "PBDSelfChecks.h"
+#include "BoxBox.h"
+#include "EPA.h"
+#include "PBDContactSolver.h"
+#include "PBDJoints.h"
+#include "Shapes/RigidBodyCube.h"
+#include <memory>
+
+constexpr float SELF_CHECK_TOLERANCE = 1e-3f;
+
+static bool isNear(float a, float b)
+{
+	return fabsf(a - b) <= SELF_CHECK_TOLERANCE;
+}
+
+static bool isNear(FXMVECTOR a, FXMVECTOR b)
+{
+	return XMVectorGetX(XMVector3Length(a - b)) <= SELF_CHECK_TOLERANCE;
+}
+
+static size_t check(bool bPassed, const wchar_t* name)
+{
+	if (true == bPassed)
+	{
+		return 0;
+	}
+
+	OutputDebugString(L"PBD self check failed: ");
+	OutputDebugString(name);
+	OutputDebugString(L"\n");
+	return 1;
+}
+
+// Unit box (half extents of 1) at the origin against a unit box posed by the caller
+struct BoxPair
+{
+	std::vector<Collider> colliders1;
+	std::vector<Collider> colliders2;
+};
+
+static void createBoxPair(FXMVECTOR position2, FXMVECTOR rotation2, BoxPair* pair)
+{
+	pair->colliders1.push_back(CreateColliderBox(XMFLOAT3(1.0f, 1.0f, 1.0f)));
+	pair->colliders2.push_back(CreateColliderBox(XMFLOAT3(1.0f, 1.0f, 1.0f)));
+	UpdateColliders(pair->colliders1, XMVectorZero(), XMQuaternionIdentity());
+	UpdateColliders(pair->colliders2, position2, rotation2);
+}
+
+static void destroyBoxPair(BoxPair* pair)
+{
+	DestroyColliders(pair->colliders1);
+	DestroyColliders(pair->colliders2);
+}
+
+static size_t checkBoxPenetration(const wchar_t* name, FXMVECTOR position2, FXMVECTOR rotation2, FXMVECTOR expectedNormal, float expectedPenetration)
+{
+	BoxPair pair;
+	createBoxPair(position2, rotation2, &pair);
+
+	GJKSimplex simplex;
+	XMVECTOR normal = XMVectorZero();
+	float penetration = 0.0f;
+	bool bPassed = true == GJKCollides(&pair.colliders1[0], &pair.colliders2[0], &simplex, nullptr) &&
+		true == EPA(&pair.colliders1[0], &pair.colliders2[0], &simplex, &normal, &penetration) &&
+		true == isNear(normal, expectedNormal) && true == isNear(penetration, expectedPenetration);
+
+	destroyBoxPair(&pair);
+	return check(bPassed, name);
+}
+
+static size_t checkBoxDistance(const wchar_t* name, FXMVECTOR position2, FXMVECTOR expectedNormal, float expectedDistance)
+{
+	BoxPair pair;
+	createBoxPair(position2, XMQuaternionIdentity(), &pair);
+
+	GJKSimplex simplex;
+	GJKDistanceResult result;
+	bool bPassed = false == GJKCollides(&pair.colliders1[0], &pair.colliders2[0], &simplex, nullptr) &&
+		true == GJKDistance(&pair.colliders1[0], &pair.colliders2[0], &result) &&
+		true == isNear(result.normal, expectedNormal) && true == isNear(result.distance, expectedDistance) &&
+		true == isNear(XMVectorGetX(XMVector3Dot(result.point2 - result.point1, expectedNormal)), expectedDistance);
+
+	destroyBoxPair(&pair);
+	return check(bPassed, name);
+}
+
+// GJK and EPA, with the second box off the axis of the pair so that a wrong sign in the Minkowski support shows up
+static size_t checkGJKEPA(void)
+{
+	const XMVECTOR xAxis = XMVectorSet(1.0f, 0.0f, 0.0f, 0.0f);
+	const XMVECTOR yAxis = XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f);
+	size_t numFailures = 0;
+
+	numFailures += checkBoxPenetration(L"EPA of overlapping boxes", XMVectorSet(1.75f, 0.5f, 0.0f, 0.0f), XMQuaternionIdentity(), xAxis, 0.25f);
+
+	// A vertical edge of the second box points into the face of the first one: 1 - (2 - sqrt(2))
+	numFailures += checkBoxPenetration(L"EPA of a box edge into a face", XMVectorSet(2.0f, 0.0f, 0.0f, 0.0f),
+		XMQuaternionRotationAxis(yAxis, XM_PIDIV4), xAxis, sqrtf(2.0f) - 1.0f);
+
+	numFailures += checkBoxDistance(L"GJK distance of separated boxes", XMVectorSet(3.0f, 0.5f, 0.0f, 0.0f), xAxis, 1.0f);
+
+	return numFailures;
+}
+
+static bool isInsideBox(const Collider* box, FXMVECTOR point)
+{
+	XMVECTOR localPoint = GetColliderLocalDirection(box, point - box->position);
+
+	return true == XMVector3LessOrEqual(XMVectorAbs(localPoint), box->box.halfExtents + XMVectorReplicate(SELF_CHECK_TOLERANCE));
+}
+
+// Every contact has the expected normal and depth, and its points lie in their boxes
+static size_t checkBoxFaceContacts(const wchar_t* name, FXMVECTOR position2, FXMVECTOR rotation2, size_t expectedNumContacts,
+	FXMVECTOR expectedNormal, float expectedDepth)
+{
+	BoxPair pair;
+	createBoxPair(position2, rotation2, &pair);
+
+	PBDArenaVector<ColliderContact> contacts;
+	GetBoxBoxContacts(&pair.colliders1[0], &pair.colliders2[0], nullptr, 0.0f, contacts);
+
+	bool bPassed = expectedNumContacts == contacts.size();
+	for (size_t i = 0; i < contacts.size() && true == bPassed; ++i)
+	{
+		const ColliderContact& contact = contacts[i];
+		float depth = XMVectorGetX(XMVector3Dot(contact.collision_point1 - contact.collision_point2, contact.collision_normal));
+		bPassed = true == isNear(contact.collision_normal, expectedNormal) && true == isNear(depth, expectedDepth) &&
+			true == isInsideBox(&pair.colliders1[0], contact.collision_point1) && true == isInsideBox(&pair.colliders2[0], contact.collision_point2);
+	}
+
+	destroyBoxPair(&pair);
+	return check(bPassed, name);
+}
+
+// The top edge of the first box, turned by 45 degrees around z, crosses the bottom edge of the second one, turned by 45 degrees around x,
+// 0.1 above it. The closest points are above the center of the first box wherever the second box is moved along its edge.
+static size_t checkBoxEdgeContact(const wchar_t* name, float offset)
+{
+	const float edgeHeight = sqrtf(2.0f);
+
+	BoxPair pair;
+	createBoxPair(XMVectorSet(offset, 2.0f * edgeHeight - 0.1f, 0.0f, 0.0f), XMQuaternionRotationAxis(XMVectorSet(1.0f, 0.0f, 0.0f, 0.0f), XM_PIDIV4), &pair);
+	UpdateColliders(pair.colliders1, XMVectorZero(), XMQuaternionRotationAxis(XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f), XM_PIDIV4));
+
+	PBDArenaVector<ColliderContact> contacts;
+	GetBoxBoxContacts(&pair.colliders1[0], &pair.colliders2[0], nullptr, 0.0f, contacts);
+
+	bool bPassed = 1 == contacts.size() && true == isNear(contacts[0].collision_normal, XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f)) &&
+		true == isNear(contacts[0].collision_point1, XMVectorSet(0.0f, edgeHeight, 0.0f, 0.0f)) &&
+		true == isNear(contacts[0].collision_point2, XMVectorSet(0.0f, edgeHeight - 0.1f, 0.0f, 0.0f));
+
+	destroyBoxPair(&pair);
+	return check(bPassed, name);
+}
+
+// Face and edge manifolds of the box-box test
+static size_t checkBoxBox(void)
+{
+	size_t numFailures = 0;
+
+	// The clipped polygon has more points than the manifold keeps
+	numFailures += checkBoxFaceContacts(L"Box-box face contacts", XMVectorSet(0.5f, 1.9f, 0.0f, 0.0f),
+		XMQuaternionRotationAxis(XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f), XM_PIDIV4), COLLIDER_MAX_MANIFOLD_CONTACTS, XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f), 0.1f);
+
+	numFailures += checkBoxEdgeContact(L"Box-box edge contact", 0.0f);
+	numFailures += checkBoxEdgeContact(L"Box-box edge contact off the center of the second edge", 0.5f);
+
+	return numFailures;
+}
+
+// Unit boxes simulated by a body store, destroyed with it
+struct BoxBodies
+{
+	PBDBodyStore bodies;
+	std::vector<std::unique_ptr<DX12Library::RigidBodyCube>> shapes;
+};
+
+static size_t addBoxBody(BoxBodies* boxes, FXMVECTOR position, FXMVECTOR rotation, bool bIsFixed)
+{
+	std::vector<Collider> colliders = { CreateColliderBox(XMFLOAT3(1.0f, 1.0f, 1.0f)) };
+	boxes->shapes.push_back(std::make_unique<DX12Library::RigidBodyCube>(position, rotation, XMVectorReplicate(1.0f), 1.0f, colliders,
+		0.5f, 0.3f, 0.0f, bIsFixed));
+
+	return GetPBDBodySlot(boxes->bodies, AddPBDBody(boxes->bodies, boxes->shapes.back().get()));
+}
+
+static void destroyBoxBodies(BoxBodies* boxes)
+{
+	for (size_t i = 0; i < boxes->shapes.size(); ++i)
+	{
+		DestroyColliders(boxes->shapes[i]->colliders);
+	}
+}
+
+static float getContactDepth(const PBDBodyStore& bodies, const PBDConstraintBodyPair& pair, const PBDCollisionConstraintData& constraint)
+{
+	XMVECTOR p1 = bodies.positions[pair.s1] + XMVector3Rotate(XMLoadFloat3(&constraint.r1_local), bodies.rotations[pair.s1]);
+	XMVECTOR p2 = bodies.positions[pair.s2] + XMVector3Rotate(XMLoadFloat3(&constraint.r2_local), bodies.rotations[pair.s2]);
+
+	return XMVectorGetX(XMVector3Dot(p1 - p2, XMLoadFloat3(&constraint.normal)));
+}
+
+// Turned boxes sunk into a fixed ground by different depths, each with one contact, solved by both the wide kernel and the
+// scalar solve. The boxes moved sideways since their previous pose, so that the friction lanes are taken too.
+// There are more contacts than lanes, so that a full group and a partial one are solved.
+static size_t checkWideContacts(void)
+{
+	constexpr size_t NUM_BOXES = 11;
+	const float h = 1.0f / 240.0f;
+	const XMVECTOR down = XMVectorSet(0.0f, -1.0f, 0.0f, 0.0f);
+
+	BoxBodies boxes;
+	size_t ground = addBoxBody(&boxes, XMVectorSet(0.0f, -1.0f, 0.0f, 0.0f), XMQuaternionIdentity(), true);
+
+	PBDCollisionConstraintBatch batch;
+	std::vector<size_t> indices;
+	std::vector<float> initialDepths;
+	for (size_t i = 0; i < NUM_BOXES; ++i)
+	{
+		float depth = 0.02f + 0.01f * static_cast<float>(i);
+		XMVECTOR rotation = XMQuaternionRotationAxis(XMVector3Normalize(XMVectorSet(1.0f, 1.0f, 0.0f, 0.0f)), 0.3f * static_cast<float>(i));
+		size_t slot = addBoxBody(&boxes, XMVectorSet(3.0f * static_cast<float>(i), 1.0f - depth, 0.0f, 0.0f), rotation, false);
+		boxes.bodies.positions[slot] += XMVectorSet(0.01f, 0.0f, 0.005f * static_cast<float>(i), 0.0f);
+
+		// The contact is off the center of the box, so that the solves also turn it
+		XMVECTOR point1 = boxes.bodies.positions[slot] + XMVectorSet(0.3f, -1.0f, 0.2f, 0.0f);
+		XMVECTOR point2 = XMVectorSetY(point1, 0.0f);
+
+		PBDCollisionConstraintData constraint = {};
+		XMStoreFloat3(&constraint.r1_local, XMVector3InverseRotate(point1 - boxes.bodies.positions[slot], boxes.bodies.rotations[slot]));
+		XMStoreFloat3(&constraint.r2_local, XMVector3InverseRotate(point2 - boxes.bodies.positions[ground], boxes.bodies.rotations[ground]));
+		XMStoreFloat3(&constraint.normal, down);
+		constraint.lambda_n_warm = -0.001f * static_cast<float>(i);
+		constraint.cached_contact = nullptr;
+
+		indices.push_back(batch.constraints.size());
+		batch.bodies.push_back(PBDConstraintBodyPair{ static_cast<uint32_t>(slot), static_cast<uint32_t>(ground) });
+		batch.constraints.push_back(constraint);
+		initialDepths.push_back(getContactDepth(boxes.bodies, batch.bodies.back(), constraint));
+	}
+
+	// The second iteration starts from the lambdas of the first one
+	const PBDSettings settings;
+	size_t numFailures = 0;
+	for (size_t j = 0; j < 2; ++j)
+	{
+		numFailures += check(0 == VerifyPBDContactConstraintsWide(boxes.bodies, batch, indices.data(), indices.size(), h, settings.wideContactVerifyTolerance),
+			L"Wide contact kernel against the scalar contact solve");
+	}
+
+	bool bReduced = true;
+	for (size_t i = 0; i < NUM_BOXES; ++i)
+	{
+		bReduced = true == bReduced && getContactDepth(boxes.bodies, batch.bodies[i], batch.constraints[i]) < initialDepths[i];
+	}
+	numFailures += check(bReduced, L"Penetration of the wide contact kernel");
+
+	destroyBoxBodies(&boxes);
+	return numFailures;
+}
+
+// Distance between the anchors of a joint and angle between the relative rotation of its bodies and the one at rest
+static void getFixedJointError(const PBDBodyStore& bodies, const PBDJoint& joint, size_t s1, size_t s2, float* distance, float* angle)
+{
+	XMVECTOR anchor1 = bodies.positions[s1] + XMVector3Rotate(XMLoadFloat3(&joint.r1_local), bodies.rotations[s1]);
+	XMVECTOR anchor2 = bodies.positions[s2] + XMVector3Rotate(XMLoadFloat3(&joint.r2_local), bodies.rotations[s2]);
+	*distance = XMVectorGetX(XMVector3Length(anchor1 - anchor2));
+
+	// Taken from the sine of the half angle, which keeps its precision for small angles unlike the cosine
+	XMVECTOR rotation = XMQuaternionMultiply(bodies.rotations[s2], XMQuaternionConjugate(bodies.rotations[s1]));
+	XMVECTOR error = XMQuaternionMultiply(XMQuaternionConjugate(XMLoadFloat4(&joint.restRotation)), rotation);
+	*angle = 2.0f * asinf(fminf(XMVectorGetX(XMVector3Length(error)), 1.0f));
+}
+
+// Fixed joint between two dynamic boxes turned by rotation1 and rotation2. The second box is then moved by the perturbation,
+// and the joint is solved for a number of iterations.
+static size_t checkFixedJoint(const wchar_t* name, FXMVECTOR rotation1, FXMVECTOR rotation2, FXMVECTOR perturbationRotation, GXMVECTOR perturbationOffset,
+	size_t numIterations)
+{
+	const float h = 1.0f / 240.0f;
+
+	BoxBodies boxes;
+	size_t s1 = addBoxBody(&boxes, XMVectorZero(), rotation1, false);
+	size_t s2 = addBoxBody(&boxes, XMVectorSet(2.5f, 0.0f, 0.0f, 0.0f), rotation2, false);
+
+	PBDJointStore joints;
+	size_t handle = AddPBDFixedJoint(joints, boxes.bodies, boxes.bodies.slotToHandle[s1], boxes.bodies.slotToHandle[s2],
+		XMVectorSet(1.25f, 0.0f, 0.0f, 0.0f), 0.0f, 0.0f);
+	size_t index = GetPBDJointIndex(joints, handle);
+
+	XMVECTOR positions[2] = { boxes.bodies.positions[s1], boxes.bodies.positions[s2] + perturbationOffset };
+	XMVECTOR rotations[2] = { boxes.bodies.rotations[s1], XMQuaternionMultiply(boxes.bodies.rotations[s2], perturbationRotation) };
+	boxes.bodies.positions[s2] = positions[1];
+	boxes.bodies.rotations[s2] = rotations[1];
+
+	for (size_t i = 0; i < numIterations; ++i)
+	{
+		SolvePBDJoint(boxes.bodies, joints, index, s1, s2, h);
+	}
+
+	float distance;
+	float angle;
+	getFixedJointError(boxes.bodies, joints.joints[index], s1, s2, &distance, &angle);
+	bool bPassed = true == isNear(distance, 0.0f) && true == isNear(angle, 0.0f);
+
+	// A joint at rest must not move its bodies
+	if (0.0f == XMVectorGetX(XMVector3LengthSq(perturbationOffset)) && true == XMQuaternionIsIdentity(perturbationRotation))
+	{
+		bPassed = true == bPassed && true == isNear(boxes.bodies.positions[s1], positions[0]) && true == isNear(boxes.bodies.positions[s2], positions[1]) &&
+			true == isNear(boxes.bodies.rotations[s1], rotations[0]) && true == isNear(boxes.bodies.rotations[s2], rotations[1]);
+	}
+
+	destroyBoxBodies(&boxes);
+	return check(bPassed, name);
+}
+
+static size_t checkJoints(void)
+{
+	const XMVECTOR perturbationRotation = XMQuaternionRotationAxis(XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f), 0.1f);
+	const XMVECTOR perturbationOffset = XMVectorSet(0.0f, 0.05f, 0.0f, 0.0f);
+	const XMVECTOR turn = XMQuaternionRotationAxis(XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f), XM_PIDIV2);
+	size_t numFailures = 0;
+
+	numFailures += checkFixedJoint(L"Fixed joint at rest between bodies turned by 90 degrees", XMQuaternionIdentity(), turn,
+		XMQuaternionIdentity(), XMVectorZero(), 10);
+	numFailures += checkFixedJoint(L"Fixed joint pulled back together", XMQuaternionIdentity(), XMQuaternionIdentity(),
+		perturbationRotation, perturbationOffset, 20);
+
+	// With turned bodies, a correction applied about the wrong axis (body space instead of world space) leaves about 0.1 rad
+	numFailures += checkFixedJoint(L"Fixed joint between turned bodies pulled back together", turn, turn, perturbationRotation, perturbationOffset, 20);
+
+	return numFailures;
+}
+
+size_t RunPBDSelfChecks(void)
+{
+	size_t numFailures = 0;
+
+	numFailures += checkGJKEPA();
+	numFailures += checkBoxBox();
+	numFailures += checkWideContacts();
+	numFailures += checkJoints();
+
+	return numFailures;
+}
\ No newline at end of file
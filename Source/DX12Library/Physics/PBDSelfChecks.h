@@ -0,0 +1,7 @@
+#pragma once
+
+#include "Common.h"
+
+// Small scenes run against the narrow phase and the solver, whose expected results are known in closed form.
+// Each failed check is written to the debug output. Returns the number of failed checks.
+size_t RunPBDSelfChecks(void);
\ No newline at end of file
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <immintrin.h>
+
+// Lane operations of the SIMD kernels, so that the same code runs 4 wide with SSE and 8 wide with AVX.
+// SelectLess(a, b, x, y) picks x in the lanes where a < b, y elsewhere.
+struct SSELanes
+{
+	typedef __m128 Type;
+	static constexpr size_t WIDTH = 4;
+
+	static Type Load(const float* p) { return _mm_loadu_ps(p); }
+	static void Store(float* p, Type v) { _mm_storeu_ps(p, v); }
+	static Type Set1(float f) { return _mm_set1_ps(f); }
+	static Type Add(Type a, Type b) { return _mm_add_ps(a, b); }
+	static Type Sub(Type a, Type b) { return _mm_sub_ps(a, b); }
+	static Type Mul(Type a, Type b) { return _mm_mul_ps(a, b); }
+	static Type Div(Type a, Type b) { return _mm_div_ps(a, b); }
+	static Type Sqrt(Type a) { return _mm_sqrt_ps(a); }
+	static Type Min(Type a, Type b) { return _mm_min_ps(a, b); }
+	static Type Max(Type a, Type b) { return _mm_max_ps(a, b); }
+	static int CompareLess(Type a, Type b) { return _mm_movemask_ps(_mm_cmplt_ps(a, b)); }
+	static Type SelectLess(Type a, Type b, Type x, Type y) { Type mask = _mm_cmplt_ps(a, b); return _mm_or_ps(_mm_and_ps(mask, x), _mm_andnot_ps(mask, y)); }
+};
+
+#if defined(__AVX__)
+struct AVXLanes
+{
+	typedef __m256 Type;
+	static constexpr size_t WIDTH = 8;
+
+	static Type Load(const float* p) { return _mm256_loadu_ps(p); }
+	static void Store(float* p, Type v) { _mm256_storeu_ps(p, v); }
+	static Type Set1(float f) { return _mm256_set1_ps(f); }
+	static Type Add(Type a, Type b) { return _mm256_add_ps(a, b); }
+	static Type Sub(Type a, Type b) { return _mm256_sub_ps(a, b); }
+	static Type Mul(Type a, Type b) { return _mm256_mul_ps(a, b); }
+	static Type Div(Type a, Type b) { return _mm256_div_ps(a, b); }
+	static Type Sqrt(Type a) { return _mm256_sqrt_ps(a); }
+	static Type Min(Type a, Type b) { return _mm256_min_ps(a, b); }
+	static Type Max(Type a, Type b) { return _mm256_max_ps(a, b); }
+	static int CompareLess(Type a, Type b) { return _mm256_movemask_ps(_mm256_cmp_ps(a, b, _CMP_LT_OQ)); }
+	static Type SelectLess(Type a, Type b, Type x, Type y) { return _mm256_blendv_ps(y, x, _mm256_cmp_ps(a, b, _CMP_LT_OQ)); }
+};
+typedef AVXLanes PBDWideLanes;
+#else
+typedef SSELanes PBDWideLanes;
+#endif
+
+constexpr size_t PBD_WIDE_LANES_MAX_WIDTH = 8;
\ No newline at end of file
@@ -0,0 +1,93 @@
+#include "PBDSleeping.h"
+
+static void wakeBody(PBDBodyStore& bodies, size_t slot)
+{
+	if (0 == bodies.bActive[slot])
+	{
+		bodies.bActive[slot] = 1;
+		bodies.deactivationTimes[slot] = 0.0f;
+	}
+}
+
+void WakePBDBody(PBDBodyStore& bodies, size_t handle)
+{
+	wakeBody(bodies, GetPBDBodySlot(bodies, handle));
+}
+
+void WakePBDIslands(PBDBodyStore& bodies, const PBDIslands* islands)
+{
+	size_t numIslands = GetPBDIslandCount(islands);
+	for (size_t i = 0; i < numIslands; ++i)
+	{
+		PBDIslandRange island = GetPBDIsland(islands, i);
+
+		bool bAwake = false;
+		for (size_t b = 0; b < island.numBodies; ++b)
+		{
+			if (0 != bodies.bActive[island.bodies[b]])
+			{
+				bAwake = true;
+				break;
+			}
+		}
+
+		if (false == bAwake)
+		{
+			continue;
+		}
+
+		for (size_t b = 0; b < island.numBodies; ++b)
+		{
+			wakeBody(bodies, island.bodies[b]);
+		}
+	}
+}
+
+void UpdatePBDIslandsSleep(PBDBodyStore& bodies, const PBDIslands* islands, const PBDSettings& settings, float dt)
+{
+	const float linearThresholdSq = settings.sleepLinearVelocityThreshold * settings.sleepLinearVelocityThreshold;
+	const float angularThresholdSq = settings.sleepAngularVelocityThreshold * settings.sleepAngularVelocityThreshold;
+
+	size_t numIslands = GetPBDIslandCount(islands);
+	for (size_t i = 0; i < numIslands; ++i)
+	{
+		PBDIslandRange island = GetPBDIsland(islands, i);
+
+		float minDeactivationTime = FLT_MAX;
+		for (size_t b = 0; b < island.numBodies; ++b)
+		{
+			size_t s = island.bodies[b];
+			if (0 == bodies.bActive[s])
+			{
+				continue;
+			}
+
+			float linearVelocitySq = XMVectorGetX(XMVector3LengthSq(bodies.linearVelocities[s]));
+			float angularVelocitySq = XMVectorGetX(XMVector3LengthSq(bodies.angularVelocities[s]));
+			if (linearVelocitySq < linearThresholdSq && angularVelocitySq < angularThresholdSq)
+			{
+				bodies.deactivationTimes[s] += dt;
+			}
+			else
+			{
+				bodies.deactivationTimes[s] = 0.0f;
+			}
+
+			minDeactivationTime = fminf(minDeactivationTime, bodies.deactivationTimes[s]);
+		}
+
+		// Already asleep, or not quiet long enough
+		if (FLT_MAX == minDeactivationTime || minDeactivationTime < settings.timeToSleep)
+		{
+			continue;
+		}
+
+		for (size_t b = 0; b < island.numBodies; ++b)
+		{
+			size_t s = island.bodies[b];
+			bodies.bActive[s] = 0;
+			bodies.linearVelocities[s] = XMVectorZero();
+			bodies.angularVelocities[s] = XMVectorZero();
+		}
+	}
+}
\ No newline at end of file
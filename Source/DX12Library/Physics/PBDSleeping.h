@@ -0,0 +1,14 @@
+#pragma once
+
+#include "PBDIslands.h"
+
+// Wakes a body up, for instance after moving it by hand.
+// Its whole island follows on the next step.
+void WakePBDBody(PBDBodyStore& bodies, size_t handle);
+
+// An island with a single awake body is woken up entirely, which is how a body hitting a sleeping pile wakes it up
+void WakePBDIslands(PBDBodyStore& bodies, const PBDIslands* islands);
+
+// Advances the deactivation time of the bodies that stayed under the velocity thresholds, and puts to sleep the islands
+// whose bodies all did for at least the time to sleep
+void UpdatePBDIslandsSleep(PBDBodyStore& bodies, const PBDIslands* islands, const PBDSettings& settings, float dt);
\ No newline at end of file
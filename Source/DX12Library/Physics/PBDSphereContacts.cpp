@@ -0,0 +1,122 @@
+#include "PBDSphereContacts.h"
+#include "PBDSimdLanes.h"
+
+constexpr size_t SPHERE_CONTACT_MAX_WIDTH = PBD_WIDE_LANES_MAX_WIDTH;
+
+// Structure of arrays of one batch of pairs
+struct SphereContactBatch
+{
+	float x1[SPHERE_CONTACT_MAX_WIDTH];
+	float y1[SPHERE_CONTACT_MAX_WIDTH];
+	float z1[SPHERE_CONTACT_MAX_WIDTH];
+	float r1[SPHERE_CONTACT_MAX_WIDTH];
+	float x2[SPHERE_CONTACT_MAX_WIDTH];
+	float y2[SPHERE_CONTACT_MAX_WIDTH];
+	float z2[SPHERE_CONTACT_MAX_WIDTH];
+	float r2[SPHERE_CONTACT_MAX_WIDTH];
+
+	// Outputs
+	float nx[SPHERE_CONTACT_MAX_WIDTH];
+	float ny[SPHERE_CONTACT_MAX_WIDTH];
+	float nz[SPHERE_CONTACT_MAX_WIDTH];
+};
+
+template<typename Lanes>
+static void generateBatch(const PBDBodyStore& bodies, const uint32_t* slots1, const uint32_t* slots2, size_t count,
+	float speculativeDistance, SphereContactBatch* batch, PBDArenaVector<Constraint>* constraints)
+{
+	typedef typename Lanes::Type Type;
+
+	// Gather the centers and radii, padding the last batch with pairs that can't collide
+	for (size_t l = 0; l < Lanes::WIDTH; ++l)
+	{
+		if (l < count)
+		{
+			XMFLOAT3 p1;
+			XMFLOAT3 p2;
+			XMStoreFloat3(&p1, bodies.positions[slots1[l]]);
+			XMStoreFloat3(&p2, bodies.positions[slots2[l]]);
+			batch->x1[l] = p1.x;
+			batch->y1[l] = p1.y;
+			batch->z1[l] = p1.z;
+			batch->r1[l] = bodies.boundingSphereRadii[slots1[l]];
+			batch->x2[l] = p2.x;
+			batch->y2[l] = p2.y;
+			batch->z2[l] = p2.z;
+			batch->r2[l] = bodies.boundingSphereRadii[slots2[l]];
+		}
+		else
+		{
+			batch->x1[l] = batch->y1[l] = batch->z1[l] = 0.0f;
+			batch->x2[l] = batch->y2[l] = batch->z2[l] = FLT_MAX;
+			batch->r1[l] = batch->r2[l] = 0.0f;
+		}
+	}
+
+	Type dx = Lanes::Sub(Lanes::Load(batch->x2), Lanes::Load(batch->x1));
+	Type dy = Lanes::Sub(Lanes::Load(batch->y2), Lanes::Load(batch->y1));
+	Type dz = Lanes::Sub(Lanes::Load(batch->z2), Lanes::Load(batch->z1));
+	Type distanceSquared = Lanes::Add(Lanes::Add(Lanes::Mul(dx, dx), Lanes::Mul(dy, dy)), Lanes::Mul(dz, dz));
+	Type minDistance = Lanes::Add(Lanes::Add(Lanes::Load(batch->r1), Lanes::Load(batch->r2)), Lanes::Set1(speculativeDistance));
+
+	int mask = Lanes::CompareLess(distanceSquared, Lanes::Mul(minDistance, minDistance));
+	if (0 == mask)
+	{
+		return;
+	}
+
+	// The distance is clamped away from zero, coincident centers are handled below
+	Type distance = Lanes::Max(Lanes::Sqrt(distanceSquared), Lanes::Set1(FLT_MIN));
+	Lanes::Store(batch->nx, Lanes::Div(dx, distance));
+	Lanes::Store(batch->ny, Lanes::Div(dy, distance));
+	Lanes::Store(batch->nz, Lanes::Div(dz, distance));
+
+	for (size_t l = 0; l < Lanes::WIDTH; ++l)
+	{
+		if (0 == (mask & (1 << l)))
+		{
+			continue;
+		}
+
+		float nx = batch->nx[l];
+		float ny = batch->ny[l];
+		float nz = batch->nz[l];
+		if (nx * nx + ny * ny + nz * nz < 0.5f)
+		{
+			nx = 0.0f;
+			ny = 1.0f;
+			nz = 0.0f;
+		}
+
+		uint32_t s1 = slots1[l];
+		uint32_t s2 = slots2[l];
+		float radius1 = batch->r1[l];
+		float radius2 = batch->r2[l];
+
+		// The contact points are the deepest points of each sphere along the normal
+		Constraint constraint;
+		constraint.type = ConstraintType::COLLISION_CONSTRAINT;
+		constraint.s1_id = bodies.slotToHandle[s1];
+		constraint.s2_id = bodies.slotToHandle[s2];
+		constraint.collision_constraint.normal = XMVectorSet(nx, ny, nz, 0.0f);
+		constraint.collision_constraint.r1_local = XMVector3InverseRotate(XMVectorSet(radius1 * nx, radius1 * ny, radius1 * nz, 0.0f), bodies.rotations[s1]);
+		constraint.collision_constraint.r2_local = XMVector3InverseRotate(XMVectorSet(-radius2 * nx, -radius2 * ny, -radius2 * nz, 0.0f), bodies.rotations[s2]);
+		constraint.collision_constraint.lambda_t = 0.0f;
+		constraint.collision_constraint.lambda_n = 0.0f;
+		constraint.collision_constraint.lambda_n_warm = 0.0f;
+		constraint.collision_constraint.cached_contact = nullptr;
+		constraints->push_back(constraint);
+	}
+}
+
+void GenerateSphereContactConstraints(const PBDBodyStore& bodies, const uint32_t* slots1, const uint32_t* slots2, size_t count,
+	float speculativeDistance, PBDArenaVector<Constraint>* constraints)
+{
+	SphereContactBatch batch;
+
+	for (size_t i = 0; i < count; i += PBDWideLanes::WIDTH)
+	{
+		size_t batchCount = count - i < PBDWideLanes::WIDTH ? count - i : PBDWideLanes::WIDTH;
+		generateBatch<PBDWideLanes>(bodies, slots1 + i, slots2 + i, batchCount, speculativeDistance, &batch, constraints);
+	}
+}
\ No newline at end of file
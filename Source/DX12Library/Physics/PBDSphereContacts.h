@@ -0,0 +1,9 @@
+#pragma once
+
+#include "PBD.h"
+
+// Contact constraints of sphere pairs, tested 4 pairs at a time with SSE (8 with AVX).
+// slots1 and slots2 hold the slots of the pairs, whose bodies must both have a single sphere collider centered on the body.
+// A constraint is appended for every pair in contact or closer than speculativeDistance, in the order of the pairs.
+void GenerateSphereContactConstraints(const PBDBodyStore& bodies, const uint32_t* slots1, const uint32_t* slots2, size_t count,
+	float speculativeDistance, PBDArenaVector<Constraint>* constraints);
\ No newline at end of file
@@ -0,0 +1,212 @@
+#include "SpatialHashGrid.h"
+
+constexpr size_t SPATIAL_HASH_BATCH_SIZE = 256;
+
+static uint32_t getCellBucket(int32_t x, int32_t y, int32_t z, uint32_t bucketMask)
+{
+	uint32_t hash = (static_cast<uint32_t>(x) * 73856093u) ^ (static_cast<uint32_t>(y) * 19349663u) ^ (static_cast<uint32_t>(z) * 83492791u);
+
+	return hash & bucketMask;
+}
+
+static bool isSphereOverlapping(const XMVECTOR* positions, const float* radii, uint32_t i, uint32_t j, float margin)
+{
+	float distanceSq = XMVectorGetX(XMVector3LengthSq(positions[i] - positions[j]));
+	float maxDistance = radii[i] + radii[j] + margin;
+
+	return distanceSq <= maxDistance * maxDistance;
+}
+
+static void runRange(PBDJobSystem* jobSystem, size_t count, const PBDJobSystem::RangeJob& job)
+{
+	if (nullptr == jobSystem)
+	{
+		job(0, count, 0);
+		return;
+	}
+
+	jobSystem->ParallelFor(count, SPATIAL_HASH_BATCH_SIZE, job);
+}
+
+void BuildSpatialHashGrid(SpatialHashGrid& grid, const XMVECTOR* positions, const float* radii, size_t count,
+	float margin, float oversizedRadiusRatio, PBDJobSystem* jobSystem)
+{
+	grid.bodyCells.resize(count);
+	grid.bodyBuckets.resize(count);
+	grid.oversizedBodies.clear();
+
+	if (0 == count)
+	{
+		grid.bucketStarts.assign(2, 0);
+		grid.entries.clear();
+		return;
+	}
+
+	// The cell fits the largest body that isn't oversized
+	float averageRadius = 0.0f;
+	for (size_t i = 0; i < count; ++i)
+	{
+		averageRadius += radii[i];
+	}
+	averageRadius /= static_cast<float>(count);
+
+	const float oversizedRadius = oversizedRadiusRatio * averageRadius;
+	float maxRadius = 0.0f;
+	for (size_t i = 0; i < count; ++i)
+	{
+		if (radii[i] <= oversizedRadius)
+		{
+			maxRadius = fmaxf(maxRadius, radii[i]);
+		}
+		else
+		{
+			grid.oversizedBodies.push_back(static_cast<uint32_t>(i));
+		}
+	}
+	grid.cellSize = fmaxf(2.0f * maxRadius + margin, FLT_EPSILON);
+
+	// Twice as many buckets as bodies, rounded to a power of two
+	uint32_t numBuckets = 1;
+	while (numBuckets < 2 * count)
+	{
+		numBuckets <<= 1;
+	}
+	const uint32_t bucketMask = numBuckets - 1;
+
+	const float inverseCellSize = 1.0f / grid.cellSize;
+	runRange(jobSystem, count, [&](size_t begin, size_t end, size_t threadIndex)
+	{
+		for (size_t i = begin; i < end; ++i)
+		{
+			XMINT3 cell;
+			cell.x = static_cast<int32_t>(floorf(XMVectorGetX(positions[i]) * inverseCellSize));
+			cell.y = static_cast<int32_t>(floorf(XMVectorGetY(positions[i]) * inverseCellSize));
+			cell.z = static_cast<int32_t>(floorf(XMVectorGetZ(positions[i]) * inverseCellSize));
+			grid.bodyCells[i] = cell;
+
+			grid.bodyBuckets[i] = radii[i] <= oversizedRadius ? getCellBucket(cell.x, cell.y, cell.z, bucketMask) : UINT32_MAX;
+		}
+	});
+
+	// Counting sort of the bodies by bucket
+	grid.bucketStarts.assign(numBuckets + 1, 0);
+	for (size_t i = 0; i < count; ++i)
+	{
+		if (UINT32_MAX != grid.bodyBuckets[i])
+		{
+			++grid.bucketStarts[grid.bodyBuckets[i] + 1];
+		}
+	}
+
+	for (uint32_t b = 0; b < numBuckets; ++b)
+	{
+		grid.bucketStarts[b + 1] += grid.bucketStarts[b];
+	}
+
+	grid.entries.resize(grid.bucketStarts[numBuckets]);
+	PBDArenaVector<uint32_t> cursors(grid.bucketStarts.begin(), grid.bucketStarts.end() - 1);
+	for (size_t i = 0; i < count; ++i)
+	{
+		if (UINT32_MAX != grid.bodyBuckets[i])
+		{
+			grid.entries[cursors[grid.bodyBuckets[i]]++] = static_cast<uint32_t>(i);
+		}
+	}
+}
+
+void GetSpatialHashGridPairs(SpatialHashGrid& grid, const XMVECTOR* positions, const float* radii, size_t count,
+	float margin, PBDJobSystem* jobSystem, PBDArenaVector<std::pair<uint32_t, uint32_t>>& out)
+{
+	if (0 == count)
+	{
+		return;
+	}
+
+	const uint32_t bucketMask = static_cast<uint32_t>(grid.bucketStarts.size() - 2);
+
+	size_t numBatches = (count + SPATIAL_HASH_BATCH_SIZE - 1) / SPATIAL_HASH_BATCH_SIZE;
+	grid.batchPairs.resize(numBatches);
+	for (size_t b = 0; b < numBatches; ++b)
+	{
+		grid.batchPairs[b].clear();
+	}
+
+	// Each body looks for the partners with a higher index in the 27 cells around it
+	runRange(jobSystem, count, [&](size_t begin, size_t end, size_t threadIndex)
+	{
+		for (size_t first = begin; first < end; first += SPATIAL_HASH_BATCH_SIZE)
+		{
+			size_t last = first + SPATIAL_HASH_BATCH_SIZE < end ? first + SPATIAL_HASH_BATCH_SIZE : end;
+			std::vector<std::pair<uint32_t, uint32_t>>& pairs = grid.batchPairs[first / SPATIAL_HASH_BATCH_SIZE];
+
+			for (size_t index = first; index < last; ++index)
+			{
+				uint32_t i = static_cast<uint32_t>(index);
+				if (UINT32_MAX == grid.bodyBuckets[i])
+				{
+					continue;
+				}
+
+				const XMINT3 cell = grid.bodyCells[i];
+				for (int32_t dz = -1; dz <= 1; ++dz)
+				{
+					for (int32_t dy = -1; dy <= 1; ++dy)
+					{
+						for (int32_t dx = -1; dx <= 1; ++dx)
+						{
+							int32_t x = cell.x + dx;
+							int32_t y = cell.y + dy;
+							int32_t z = cell.z + dz;
+
+							uint32_t bucket = getCellBucket(x, y, z, bucketMask);
+							for (uint32_t k = grid.bucketStarts[bucket]; k < grid.bucketStarts[bucket + 1]; ++k)
+							{
+								uint32_t j = grid.entries[k];
+								if (j <= i)
+								{
+									continue;
+								}
+
+								// Other cells may share the bucket
+								const XMINT3& otherCell = grid.bodyCells[j];
+								if (otherCell.x != x || otherCell.y != y || otherCell.z != z)
+								{
+									continue;
+								}
+
+								if (true == isSphereOverlapping(positions, radii, i, j, margin))
+								{
+									pairs.push_back(std::make_pair(i, j));
+								}
+							}
+						}
+					}
+				}
+			}
+		}
+	});
+
+	for (size_t b = 0; b < numBatches; ++b)
+	{
+		out.insert(out.end(), grid.batchPairs[b].begin(), grid.batchPairs[b].end());
+	}
+
+	// The oversized bodies are tested against everything else
+	for (size_t o = 0; o < grid.oversizedBodies.size(); ++o)
+	{
+		uint32_t i = grid.oversizedBodies[o];
+		for (uint32_t j = 0; j < static_cast<uint32_t>(count); ++j)
+		{
+			// Pairs of oversized bodies are reported once
+			if (j == i || (UINT32_MAX == grid.bodyBuckets[j] && j < i))
+			{
+				continue;
+			}
+
+			if (true == isSphereOverlapping(positions, radii, i, j, margin))
+			{
+				out.push_back(i < j ? std::make_pair(i, j) : std::make_pair(j, i));
+			}
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "PBDJobSystem.h"
+#include "PBDFrameArena.h"
+
+// Uniform grid stored in a hash table, for bodies of nearly the same size.
+// Every body is put in the single cell containing its center, with a cell size of the largest diameter (plus the margin),
+// so that its partners can only be in the 27 surrounding cells. Bodies much larger than the average are kept aside
+// in the oversized list and tested against every other body.
+struct SpatialHashGrid
+{
+	float cellSize = 1.0f;
+
+	// Bodies sorted by bucket with a counting sort. Bucket b spans [bucketStarts[b], bucketStarts[b + 1])
+	std::vector<uint32_t> bucketStarts;
+	std::vector<uint32_t> entries;
+
+	// Cell and bucket of every body (UINT32_MAX bucket for the oversized bodies)
+	std::vector<XMINT3> bodyCells;
+	std::vector<uint32_t> bodyBuckets;
+	std::vector<uint32_t> oversizedBodies;
+
+	// Pairs found by every batch of the query, concatenated in batch order so that the result doesn't depend on the threads
+	std::vector<std::vector<std::pair<uint32_t, uint32_t>>> batchPairs;
+};
+
+// A body whose radius exceeds oversizedRadiusRatio times the average radius goes to the oversized list
+void BuildSpatialHashGrid(SpatialHashGrid& grid, const XMVECTOR* positions, const float* radii, size_t count,
+	float margin, float oversizedRadiusRatio, PBDJobSystem* jobSystem);
+
+// Every pair of bodies whose bounding spheres are closer than the margin, as (lower index, higher index).
+// jobSystem may be nullptr to run on the calling thread.
+void GetSpatialHashGridPairs(SpatialHashGrid& grid, const XMVECTOR* positions, const float* radii, size_t count,
+	float margin, PBDJobSystem* jobSystem, PBDArenaVector<std::pair<uint32_t, uint32_t>>& out);
\ No newline at end of file
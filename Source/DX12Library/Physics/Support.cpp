@@ -1,12 +1,59 @@
 #include "Support.h"
 
-size_t GetSupportPointIndex(ColliderConvexHull* convexHull, XMVECTOR direction)
+// Direction-dependent dot product shared by both searches, so that they agree on ties
+static float supportDot(FXMVECTOR vertex, FXMVECTOR dx, FXMVECTOR dy, GXMVECTOR dz)
 {
+	return XMVectorGetX(XMVectorMultiplyAdd(XMVectorSplatZ(vertex), dz, XMVectorMultiplyAdd(XMVectorSplatY(vertex), dy, XMVectorMultiply(XMVectorSplatX(vertex), dx))));
+}
+
+// Four vertices per iteration, keeping the best dot product and its index in each lane
+static size_t getSupportPointIndexLinear(const XMVECTOR* vertices, size_t numVertices, FXMVECTOR dx, FXMVECTOR dy, FXMVECTOR dz)
+{
+	XMVECTOR maxDots = XMVectorReplicate(-FLT_MAX);
+	XMVECTOR maxIndices = XMVectorZero();
+	XMVECTOR indices = XMVectorSet(0.0f, 1.0f, 2.0f, 3.0f);
+	const XMVECTOR four = XMVectorReplicate(4.0f);
+
+	size_t i = 0;
+	for (; i + 4 <= numVertices; i += 4)
+	{
+		XMMATRIX m;
+		m.r[0] = vertices[i];
+		m.r[1] = vertices[i + 1];
+		m.r[2] = vertices[i + 2];
+		m.r[3] = vertices[i + 3];
+		m = XMMatrixTranspose(m);
+
+		XMVECTOR dots = XMVectorMultiplyAdd(m.r[2], dz, XMVectorMultiplyAdd(m.r[1], dy, XMVectorMultiply(m.r[0], dx)));
+		XMVECTOR greater = XMVectorGreater(dots, maxDots);
+		maxDots = XMVectorSelect(maxDots, dots, greater);
+		maxIndices = XMVectorSelect(maxIndices, indices, greater);
+		indices += four;
+	}
+
+	XMFLOAT4 laneDots;
+	XMFLOAT4 laneIndices;
+	XMStoreFloat4(&laneDots, maxDots);
+	XMStoreFloat4(&laneIndices, maxIndices);
+
+	// Lowest index among the equal maxima, like the scalar scan
+	const float dots[4] = { laneDots.x, laneDots.y, laneDots.z, laneDots.w };
+	const float lanes[4] = { laneIndices.x, laneIndices.y, laneIndices.z, laneIndices.w };
 	size_t selectedIndex = SIZE_MAX;
 	float maxDot = -FLT_MAX;
-	for (size_t i = 0; i < convexHull->transformedVertices->size(); ++i)
+	for (size_t l = 0; l < 4 && l < numVertices; ++l)
+	{
+		size_t index = static_cast<size_t>(lanes[l]);
+		if (maxDot < dots[l] || (maxDot == dots[l] && index < selectedIndex))
+		{
+			selectedIndex = index;
+			maxDot = dots[l];
+		}
+	}
+
+	for (; i < numVertices; ++i)
 	{
-		float dot = XMVectorGetX(XMVector3Dot(convexHull->transformedVertices->at(i), direction));
+		float dot = supportDot(vertices[i], dx, dy, dz);
 		if (maxDot < dot)
 		{
 			selectedIndex = i;
@@ -17,6 +64,63 @@ size_t GetSupportPointIndex(ColliderConvexHull* convexHull, XMVECTOR direction)
 	return selectedIndex;
 }
 
+// Walks the edges of the hull towards the direction. On a convex hull the vertex where no neighbor is further
+// along the direction is the support point, and starting from the previous answer it is usually a few steps away.
+static size_t getSupportPointIndexHillClimbing(const ColliderConvexHull* convexHull, size_t startIndex, FXMVECTOR dx, FXMVECTOR dy, FXMVECTOR dz)
+{
+	const std::vector<XMVECTOR>& vertices = *convexHull->vertices;
+
+	size_t currentIndex = startIndex;
+	float currentDot = supportDot(vertices[currentIndex], dx, dy, dz);
+	while (true)
+	{
+		size_t nextIndex = currentIndex;
+		float nextDot = currentDot;
+
+		const std::vector<WORD>& neighbors = convexHull->vertexToNeighbors[currentIndex];
+		for (size_t i = 0; i < neighbors.size(); ++i)
+		{
+			float dot = supportDot(vertices[neighbors[i]], dx, dy, dz);
+			if (nextDot < dot)
+			{
+				nextIndex = neighbors[i];
+				nextDot = dot;
+			}
+		}
+
+		if (nextIndex == currentIndex)
+		{
+			return currentIndex;
+		}
+
+		currentIndex = nextIndex;
+		currentDot = nextDot;
+	}
+}
+
+size_t GetSupportPointIndex(const ColliderConvexHull* convexHull, XMVECTOR direction)
+{
+	XMVECTOR dx = XMVectorSplatX(direction);
+	XMVECTOR dy = XMVectorSplatY(direction);
+	XMVECTOR dz = XMVectorSplatZ(direction);
+
+	size_t numVertices = convexHull->vertices->size();
+	if (numVertices < SUPPORT_HILL_CLIMBING_MIN_VERTICES)
+	{
+		return getSupportPointIndexLinear(convexHull->vertices->data(), numVertices, dx, dy, dz);
+	}
+
+	// One hint per octant of the direction, as queries in nearby directions end up on nearby vertices.
+	// The hints are shared by the threads querying the same (fixed) hull, any value of them gives the right answer.
+	size_t octant = (XMVectorGetX(direction) < 0.0f ? 1 : 0) | (XMVectorGetY(direction) < 0.0f ? 2 : 0) | (XMVectorGetZ(direction) < 0.0f ? 4 : 0);
+	size_t startIndex = convexHull->supportHints[octant].load(std::memory_order_relaxed);
+
+	size_t selectedIndex = getSupportPointIndexHillClimbing(convexHull, startIndex, dx, dy, dz);
+	convexHull->supportHints[octant].store(static_cast<WORD>(selectedIndex), std::memory_order_relaxed);
+
+	return selectedIndex;
+}
+
 XMVECTOR SupportPoint(Collider* collider, XMVECTOR direction)
 {
 	switch (collider->type)
@@ -24,9 +128,57 @@ XMVECTOR SupportPoint(Collider* collider, XMVECTOR direction)
 	case ColliderType::SPHERE:
 		return (collider->sphere.center + collider->sphere.radius * direction);
 		break;
+	case ColliderType::CAPSULE:
+	{
+		// End of the segment on the side of the direction, pushed out by the radius
+		float halfHeight = XMVectorGetY(GetColliderLocalDirection(collider, direction)) < 0.0f ? -collider->capsule.halfHeight : collider->capsule.halfHeight;
+		return GetColliderWorldPoint(collider, XMVectorSet(0.0f, halfHeight, 0.0f, 0.0f)) + collider->capsule.radius * XMVector3Normalize(direction);
+	}
+	case ColliderType::CYLINDER:
+	{
+		// Rim of the cap on the side of the direction
+		XMVECTOR localDirection = GetColliderLocalDirection(collider, direction);
+		float halfHeight = XMVectorGetY(localDirection) < 0.0f ? -collider->cylinder.halfHeight : collider->cylinder.halfHeight;
+		XMVECTOR radial = XMVectorSetY(localDirection, 0.0f);
+		float radialLength = XMVectorGetX(XMVector3Length(radial));
+		XMVECTOR rim = FLT_EPSILON < radialLength ? (collider->cylinder.radius / radialLength) * radial : XMVectorZero();
+		return GetColliderWorldPoint(collider, XMVectorSetY(rim, halfHeight));
+	}
+	case ColliderType::BOX:
+	{
+		// Corner of the box on the side of the direction
+		XMVECTOR localDirection = GetColliderLocalDirection(collider, direction);
+		XMVECTOR halfExtents = collider->box.halfExtents;
+		return GetColliderWorldPoint(collider, XMVectorSelect(-halfExtents, halfExtents, XMVectorGreaterOrEqual(localDirection, XMVectorZero())));
+	}
+	case ColliderType::TRIANGLE:
+	{
+		XMVECTOR localDirection = GetColliderLocalDirection(collider, direction);
+		XMVECTOR dx = XMVectorSplatX(localDirection);
+		XMVECTOR dy = XMVectorSplatY(localDirection);
+		XMVECTOR dz = XMVectorSplatZ(localDirection);
+
+		size_t selectedIndex = 0;
+		float maxDot = supportDot(collider->triangle.vertices[0], dx, dy, dz);
+		for (size_t i = 1; i < 3; ++i)
+		{
+			float dot = supportDot(collider->triangle.vertices[i], dx, dy, dz);
+			if (maxDot < dot)
+			{
+				selectedIndex = i;
+				maxDot = dot;
+			}
+		}
+		return GetColliderWorldPoint(collider, collider->triangle.vertices[selectedIndex]);
+	}
+	case ColliderType::TRIANGLE_MESH:
+	case ColliderType::HEIGHTFIELD:
+		// Not convex, their queries go through their triangles
+		break;
 	case ColliderType::CONVEX_HULL:
-		size_t selectedIndex = GetSupportPointIndex(&collider->convexHull, direction);
-		return collider->convexHull.transformedVertices->at(selectedIndex);
+		// Only the selected vertex is brought into world space
+		size_t selectedIndex = GetSupportPointIndex(&collider->convexHull, GetColliderLocalDirection(collider, direction));
+		return GetColliderWorldPoint(collider, collider->convexHull.vertices->at(selectedIndex));
 		break;
 	}
 
@@ -37,7 +189,25 @@ XMVECTOR SupportPoint(Collider* collider, XMVECTOR direction)
 XMVECTOR SupportPointOfMinkowskiDifference(Collider* collider1, Collider* collider2, XMVECTOR direction)
 {
 	XMVECTOR support1 = SupportPoint(collider1, direction);
-	XMVECTOR support2 = SupportPoint(collider2, direction);
+	XMVECTOR support2 = SupportPoint(collider2, -direction);
 
 	return support1 - support2;
+}
+
+void GetSupportBox(Collider* collider, const Collider* space, float margin, XMVECTOR* localMin, XMVECTOR* localMax)
+{
+	XMMATRIX axes = XMMatrixRotationQuaternion(space->rotation);
+
+	float minimum[3];
+	float maximum[3];
+	for (size_t i = 0; i < 3; ++i)
+	{
+		XMVECTOR axis = axes.r[i];
+		float offset = XMVectorGetX(XMVector3Dot(space->position, axis));
+		maximum[i] = XMVectorGetX(XMVector3Dot(SupportPoint(collider, axis), axis)) - offset + margin;
+		minimum[i] = XMVectorGetX(XMVector3Dot(SupportPoint(collider, -axis), axis)) - offset - margin;
+	}
+
+	*localMin = XMVectorSet(minimum[0], minimum[1], minimum[2], 0.0f);
+	*localMax = XMVectorSet(maximum[0], maximum[1], maximum[2], 0.0f);
 }
\ No newline at end of file
@@ -2,6 +2,13 @@
 
 #include "Collider.h"
 
-size_t GetSupportPointIndex(ColliderConvexHull* convexHull, XMVECTOR direction);
+// Hulls with fewer vertices are scanned linearly, larger ones are searched by walking their edges
+constexpr size_t SUPPORT_HILL_CLIMBING_MIN_VERTICES = 32;
+
+// Direction in the space of the hull
+size_t GetSupportPointIndex(const ColliderConvexHull* convexHull, XMVECTOR direction);
 XMVECTOR SupportPoint(Collider* collider, XMVECTOR direction);
-XMVECTOR SupportPointOfMinkowskiDifference(Collider* collider1, Collider* collider2, XMVECTOR direction);
\ No newline at end of file
+XMVECTOR SupportPointOfMinkowskiDifference(Collider* collider1, Collider* collider2, XMVECTOR direction);
+
+// Box of the collider in the space of another one, from the support points of the collider along the axes of that space, grown by margin
+void GetSupportBox(Collider* collider, const Collider* space, float margin, XMVECTOR* localMin, XMVECTOR* localMax);
\ No newline at end of file
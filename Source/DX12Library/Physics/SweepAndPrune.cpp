@@ -0,0 +1,203 @@
+#include "SweepAndPrune.h"
+
+static uint64_t getPairKey(uint32_t proxyA, uint32_t proxyB)
+{
+	return (static_cast<uint64_t>(proxyA) << 32) | static_cast<uint64_t>(proxyB);
+}
+
+static float getAABBBound(const AABB& aabb, size_t axis, bool bUpper)
+{
+	const XMFLOAT3& bound = true == bUpper ? aabb.upperBound : aabb.lowerBound;
+
+	return 0 == axis ? bound.x : (1 == axis ? bound.y : bound.z);
+}
+
+static void addPair(SweepAndPrune& sap, uint32_t proxyA, uint32_t proxyB)
+{
+	if (proxyB < proxyA)
+	{
+		uint32_t temp = proxyA;
+		proxyA = proxyB;
+		proxyB = temp;
+	}
+
+	uint64_t key = getPairKey(proxyA, proxyB);
+	if (sap.pairIndices.end() != sap.pairIndices.find(key))
+	{
+		return;
+	}
+
+	sap.pairIndices.emplace(key, sap.pairs.size());
+	sap.pairs.push_back(SweepAndPrunePair{ proxyA, proxyB });
+}
+
+static void removePairAt(SweepAndPrune& sap, size_t index)
+{
+	const SweepAndPrunePair& pair = sap.pairs[index];
+	sap.pairIndices.erase(getPairKey(pair.proxyA, pair.proxyB));
+
+	// The last pair takes over the freed index
+	if (index + 1 != sap.pairs.size())
+	{
+		sap.pairs[index] = sap.pairs.back();
+		sap.pairIndices[getPairKey(sap.pairs[index].proxyA, sap.pairs[index].proxyB)] = index;
+	}
+	sap.pairs.pop_back();
+}
+
+static void removePair(SweepAndPrune& sap, uint32_t proxyA, uint32_t proxyB)
+{
+	if (proxyB < proxyA)
+	{
+		uint32_t temp = proxyA;
+		proxyA = proxyB;
+		proxyB = temp;
+	}
+
+	std::unordered_map<uint64_t, size_t>::iterator it = sap.pairIndices.find(getPairKey(proxyA, proxyB));
+	if (sap.pairIndices.end() != it)
+	{
+		removePairAt(sap, it->second);
+	}
+}
+
+uint32_t CreateSweepAndPruneProxy(SweepAndPrune& sap, const AABB& aabb, size_t userData)
+{
+	uint32_t proxyId;
+	if (false == sap.freeProxies.empty())
+	{
+		proxyId = sap.freeProxies.back();
+		sap.freeProxies.pop_back();
+	}
+	else
+	{
+		proxyId = static_cast<uint32_t>(sap.proxies.size());
+		sap.proxies.push_back(SweepAndPruneProxy());
+	}
+
+	SweepAndPruneProxy* proxy = &sap.proxies[proxyId];
+	proxy->aabb = aabb;
+	proxy->userData = userData;
+	proxy->bUsed = true;
+
+	// The endpoints are moved into place by the next update, which also reports the pairs of the new proxy
+	for (size_t axis = 0; axis < 3; ++axis)
+	{
+		sap.endpoints[axis].push_back(SweepAndPruneEndpoint{ getAABBBound(aabb, axis, false), proxyId << 1 });
+		sap.endpoints[axis].push_back(SweepAndPruneEndpoint{ getAABBBound(aabb, axis, true), (proxyId << 1) | 1 });
+	}
+
+	return proxyId;
+}
+
+void DestroySweepAndPruneProxy(SweepAndPrune& sap, uint32_t proxyId)
+{
+	assert(proxyId < sap.proxies.size() && true == sap.proxies[proxyId].bUsed);
+
+	for (size_t axis = 0; axis < 3; ++axis)
+	{
+		std::vector<SweepAndPruneEndpoint>& endpoints = sap.endpoints[axis];
+
+		size_t count = 0;
+		for (size_t i = 0; i < endpoints.size(); ++i)
+		{
+			if ((endpoints[i].data >> 1) != proxyId)
+			{
+				endpoints[count++] = endpoints[i];
+			}
+		}
+		endpoints.resize(count);
+	}
+
+	for (size_t i = 0; i < sap.pairs.size();)
+	{
+		if (sap.pairs[i].proxyA == proxyId || sap.pairs[i].proxyB == proxyId)
+		{
+			removePairAt(sap, i);
+		}
+		else
+		{
+			++i;
+		}
+	}
+
+	sap.proxies[proxyId].bUsed = false;
+	sap.freeProxies.push_back(proxyId);
+}
+
+void SetSweepAndPruneProxyAABB(SweepAndPrune& sap, uint32_t proxyId, const AABB& aabb)
+{
+	assert(proxyId < sap.proxies.size() && true == sap.proxies[proxyId].bUsed);
+
+	sap.proxies[proxyId].aabb = aabb;
+}
+
+size_t GetSweepAndPruneUserData(const SweepAndPrune& sap, uint32_t proxyId)
+{
+	assert(proxyId < sap.proxies.size());
+
+	return sap.proxies[proxyId].userData;
+}
+
+static void sortAxis(SweepAndPrune& sap, size_t axis)
+{
+	std::vector<SweepAndPruneEndpoint>& endpoints = sap.endpoints[axis];
+
+	// Refresh the values first, so that the overlap tests below see the final boxes
+	for (size_t i = 0; i < endpoints.size(); ++i)
+	{
+		const SweepAndPruneProxy* proxy = &sap.proxies[endpoints[i].data >> 1];
+		endpoints[i].value = getAABBBound(proxy->aabb, axis, 0 != (endpoints[i].data & 1));
+	}
+
+	// Insertion sort, nearly linear when the bodies barely moved.
+	// Each swap between a lower and an upper bound of two proxies is the start or the end of their overlap on this axis.
+	for (size_t i = 1; i < endpoints.size(); ++i)
+	{
+		SweepAndPruneEndpoint endpoint = endpoints[i];
+		uint32_t proxyId = endpoint.data >> 1;
+		bool bUpper = 0 != (endpoint.data & 1);
+
+		size_t j = i;
+		while (0 < j && endpoint.value < endpoints[j - 1].value)
+		{
+			const SweepAndPruneEndpoint& other = endpoints[j - 1];
+			uint32_t otherProxyId = other.data >> 1;
+			bool bOtherUpper = 0 != (other.data & 1);
+
+			if (otherProxyId != proxyId)
+			{
+				if (false == bUpper && true == bOtherUpper)
+				{
+					// The lower bound passed the upper bound of the other proxy, they may overlap now
+					if (true == IsAABBOverlapping(sap.proxies[proxyId].aabb, sap.proxies[otherProxyId].aabb))
+					{
+						addPair(sap, proxyId, otherProxyId);
+					}
+				}
+				else if (true == bUpper && false == bOtherUpper)
+				{
+					// The upper bound passed the lower bound of the other proxy, they're separated on this axis
+					removePair(sap, proxyId, otherProxyId);
+				}
+			}
+
+			endpoints[j] = endpoints[j - 1];
+			--j;
+		}
+		endpoints[j] = endpoint;
+	}
+}
+
+void UpdateSweepAndPrune(SweepAndPrune& sap)
+{
+	for (size_t axis = 0; axis < 3; ++axis)
+	{
+		sortAxis(sap, axis);
+	}
+}
+
+const std::vector<SweepAndPrunePair>& GetSweepAndPrunePairs(const SweepAndPrune& sap)
+{
+	return sap.pairs;
+}
\ No newline at end of file
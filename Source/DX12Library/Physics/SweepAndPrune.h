@@ -0,0 +1,51 @@
+#pragma once
+
+#include "DynamicAABBTree.h"
+#include <unordered_map>
+
+constexpr uint32_t SWEEP_AND_PRUNE_NULL_PROXY = UINT32_MAX;
+
+struct SweepAndPruneProxy
+{
+	AABB aabb;
+	size_t userData;
+	bool bUsed;
+};
+
+// Bound of a proxy on one axis. data holds the proxy id shifted left by one, with the low bit set for upper bounds
+struct SweepAndPruneEndpoint
+{
+	float value;
+	uint32_t data;
+};
+
+struct SweepAndPrunePair
+{
+	uint32_t proxyA;
+	uint32_t proxyB;
+};
+
+// Sweep and prune over the three axes.
+// The endpoint lists stay sorted from one update to the next, so that the insertion sort only has to fix up the bodies
+// that moved. The swaps found by the sort add and remove the overlapping pairs, which are kept between updates.
+struct SweepAndPrune
+{
+	std::vector<SweepAndPruneProxy> proxies;
+	std::vector<uint32_t> freeProxies;
+	std::vector<SweepAndPruneEndpoint> endpoints[3];
+
+	// Overlapping pairs, with proxyA < proxyB
+	std::vector<SweepAndPrunePair> pairs;
+	std::unordered_map<uint64_t, size_t> pairIndices;
+};
+
+uint32_t CreateSweepAndPruneProxy(SweepAndPrune& sap, const AABB& aabb, size_t userData);
+void DestroySweepAndPruneProxy(SweepAndPrune& sap, uint32_t proxyId);
+
+// The new box is taken into account by the next update
+void SetSweepAndPruneProxyAABB(SweepAndPrune& sap, uint32_t proxyId, const AABB& aabb);
+size_t GetSweepAndPruneUserData(const SweepAndPrune& sap, uint32_t proxyId);
+
+// Sorts the endpoints again and updates the pairs accordingly
+void UpdateSweepAndPrune(SweepAndPrune& sap);
+const std::vector<SweepAndPrunePair>& GetSweepAndPrunePairs(const SweepAndPrune& sap);
\ No newline at end of file
@@ -0,0 +1,680 @@
+#include "TriangleMesh.h"
+#include "EPA.h"
+#include "Support.h"
+#include <algorithm>
+#include <unordered_map>
+
+// Quantized coordinates of the rounded down minima, the rounded up maxima go one further
+constexpr float TRIANGLE_MESH_QUANTIZATION_RANGE = 65534.0f;
+
+// Neighbor triangles closer to coplanar than about 2 degrees share an inactive edge
+constexpr float TRIANGLE_MESH_COPLANAR_COSINE = 0.9995f;
+
+// The triangle is the reference face of the contacts when the contact normal is within about 10 degrees of its normal
+constexpr float TRIANGLE_MESH_FACE_MIN_COSINE = 0.985f;
+
+// A capsule lies on a triangle when its segment is within about 5 degrees of it
+constexpr float TRIANGLE_MESH_CAPSULE_MAX_SINE = 0.09f;
+
+// Barycentric weight under which a point is taken to be on the opposite edge of a triangle
+constexpr float TRIANGLE_MESH_EDGE_TOLERANCE = 0.001f;
+
+struct TriangleMeshBuildEntry
+{
+	XMVECTOR boxMin;
+	XMVECTOR boxMax;
+	XMVECTOR centroid;
+	uint32_t triangle;
+};
+
+static XMVECTOR getTriangleNormal(FXMVECTOR a, FXMVECTOR b, FXMVECTOR c)
+{
+	return XMVector3Normalize(XMVector3Cross(b - a, c - a));
+}
+
+void ComputeTriangleMeshActiveEdges(const std::vector<XMVECTOR>& vertices, const std::vector<uint32_t>& indices, std::vector<uint8_t>* activeEdges)
+{
+	size_t numTriangles = indices.size() / 3;
+
+	// Edges of the triangles (3 * triangle + edge) on each edge of the mesh, keyed by the indices of its vertices
+	std::unordered_map<uint64_t, std::vector<uint32_t>> meshEdgeToTriangleEdges;
+	for (uint32_t i = 0; i < static_cast<uint32_t>(indices.size()); ++i)
+	{
+		uint32_t i1 = indices[i];
+		uint32_t i2 = indices[i - i % 3 + (i + 1) % 3];
+		uint64_t key = (static_cast<uint64_t>(i1 < i2 ? i1 : i2) << 32) | (i1 < i2 ? i2 : i1);
+		meshEdgeToTriangleEdges[key].push_back(i);
+	}
+
+	activeEdges->assign(numTriangles, 0);
+	for (const auto& meshEdge : meshEdgeToTriangleEdges)
+	{
+		const std::vector<uint32_t>& triangleEdges = meshEdge.second;
+		bool bActive = true;
+
+		if (2 == triangleEdges.size())
+		{
+			uint32_t triangle1 = triangleEdges[0] / 3;
+			uint32_t triangle2 = triangleEdges[1] / 3;
+			XMVECTOR normal1 = getTriangleNormal(vertices[indices[3 * triangle1]], vertices[indices[3 * triangle1 + 1]], vertices[indices[3 * triangle1 + 2]]);
+			XMVECTOR normal2 = getTriangleNormal(vertices[indices[3 * triangle2]], vertices[indices[3 * triangle2 + 1]], vertices[indices[3 * triangle2 + 2]]);
+
+			// The vertex of the second triangle off the edge is above the plane of the first one on a concave crease
+			XMVECTOR edgeVertex = vertices[indices[triangleEdges[0]]];
+			XMVECTOR oppositeVertex = vertices[indices[3 * triangle2 + (triangleEdges[1] + 2) % 3]];
+
+			bool bCoplanar = TRIANGLE_MESH_COPLANAR_COSINE < XMVectorGetX(XMVector3Dot(normal1, normal2));
+			bool bConcave = 0.0f < XMVectorGetX(XMVector3Dot(normal1, oppositeVertex - edgeVertex));
+			bActive = false == bCoplanar && false == bConcave;
+		}
+
+		if (true == bActive)
+		{
+			for (size_t i = 0; i < triangleEdges.size(); ++i)
+			{
+				(*activeEdges)[triangleEdges[i] / 3] |= static_cast<uint8_t>(1 << (triangleEdges[i] % 3));
+			}
+		}
+	}
+}
+
+static void quantizeBox(const ColliderTriangleMesh* triangleMesh, FXMVECTOR boxMin, FXMVECTOR boxMax, uint16_t* quantizedMin, uint16_t* quantizedMax)
+{
+	const XMVECTOR zero = XMVectorZero();
+	const XMVECTOR range = XMVectorReplicate(TRIANGLE_MESH_QUANTIZATION_RANGE + 1.0f);
+
+	XMFLOAT3 minimum;
+	XMFLOAT3 maximum;
+	XMStoreFloat3(&minimum, XMVectorClamp(XMVectorFloor((boxMin - triangleMesh->boundsMin) * triangleMesh->quantizationScale), zero, range));
+	XMStoreFloat3(&maximum, XMVectorClamp(XMVectorFloor((boxMax - triangleMesh->boundsMin) * triangleMesh->quantizationScale) + XMVectorSplatOne(), zero, range));
+
+	quantizedMin[0] = static_cast<uint16_t>(minimum.x);
+	quantizedMin[1] = static_cast<uint16_t>(minimum.y);
+	quantizedMin[2] = static_cast<uint16_t>(minimum.z);
+	quantizedMax[0] = static_cast<uint16_t>(maximum.x);
+	quantizedMax[1] = static_cast<uint16_t>(maximum.y);
+	quantizedMax[2] = static_cast<uint16_t>(maximum.z);
+}
+
+// Top-down build over the entries [begin, end), splitting them at the median of their centroids along the axis they spread the most on
+static void buildNode(ColliderTriangleMesh* triangleMesh, std::vector<TriangleMeshBuildEntry>& entries, size_t begin, size_t end)
+{
+	size_t nodeIndex = triangleMesh->nodes->size();
+	triangleMesh->nodes->push_back(ColliderTriangleMeshNode());
+
+	XMVECTOR boxMin = entries[begin].boxMin;
+	XMVECTOR boxMax = entries[begin].boxMax;
+	XMVECTOR centroidMin = entries[begin].centroid;
+	XMVECTOR centroidMax = entries[begin].centroid;
+	for (size_t i = begin + 1; i < end; ++i)
+	{
+		boxMin = XMVectorMin(boxMin, entries[i].boxMin);
+		boxMax = XMVectorMax(boxMax, entries[i].boxMax);
+		centroidMin = XMVectorMin(centroidMin, entries[i].centroid);
+		centroidMax = XMVectorMax(centroidMax, entries[i].centroid);
+	}
+
+	ColliderTriangleMeshNode node;
+	quantizeBox(triangleMesh, boxMin, boxMax, node.quantizedMin, node.quantizedMax);
+
+	if (1 == end - begin)
+	{
+		// The triangles are reordered like the entries once the hierarchy is built
+		node.escapeIndexOrTriangle = static_cast<int32_t>(begin);
+		(*triangleMesh->nodes)[nodeIndex] = node;
+		return;
+	}
+
+	XMFLOAT3 spread;
+	XMStoreFloat3(&spread, centroidMax - centroidMin);
+	size_t axis = 0;
+	if (spread.x < spread.y && spread.z <= spread.y)
+	{
+		axis = 1;
+	}
+	else if (spread.x < spread.z && spread.y < spread.z)
+	{
+		axis = 2;
+	}
+
+	size_t middle = begin + (end - begin) / 2;
+	std::nth_element(entries.begin() + begin, entries.begin() + middle, entries.begin() + end,
+		[axis](const TriangleMeshBuildEntry& entry1, const TriangleMeshBuildEntry& entry2)
+		{
+			return XMVectorGetByIndex(entry1.centroid, axis) < XMVectorGetByIndex(entry2.centroid, axis);
+		});
+
+	buildNode(triangleMesh, entries, begin, middle);
+	buildNode(triangleMesh, entries, middle, end);
+
+	node.escapeIndexOrTriangle = -static_cast<int32_t>(triangleMesh->nodes->size() - nodeIndex);
+	(*triangleMesh->nodes)[nodeIndex] = node;
+}
+
+void BuildColliderTriangleMesh(ColliderTriangleMesh* triangleMesh, const std::vector<XMVECTOR>& vertices, const std::vector<uint32_t>& indices)
+{
+	size_t numTriangles = indices.size() / 3;
+	assert(0 < numTriangles);
+
+	std::vector<uint8_t> activeEdges;
+	ComputeTriangleMeshActiveEdges(vertices, indices, &activeEdges);
+
+	std::vector<TriangleMeshBuildEntry> entries(numTriangles);
+	XMVECTOR boundsMin = XMVectorReplicate(FLT_MAX);
+	XMVECTOR boundsMax = XMVectorReplicate(-FLT_MAX);
+	for (size_t i = 0; i < numTriangles; ++i)
+	{
+		XMVECTOR a = vertices[indices[3 * i]];
+		XMVECTOR b = vertices[indices[3 * i + 1]];
+		XMVECTOR c = vertices[indices[3 * i + 2]];
+
+		TriangleMeshBuildEntry* entry = &entries[i];
+		entry->boxMin = XMVectorMin(XMVectorMin(a, b), c);
+		entry->boxMax = XMVectorMax(XMVectorMax(a, b), c);
+		entry->centroid = (a + b + c) / 3.0f;
+		entry->triangle = static_cast<uint32_t>(i);
+
+		boundsMin = XMVectorMin(boundsMin, entry->boxMin);
+		boundsMax = XMVectorMax(boundsMax, entry->boxMax);
+	}
+
+	triangleMesh->vertices = new std::vector<XMVECTOR>(vertices);
+	triangleMesh->boundsMin = boundsMin;
+	triangleMesh->boundsMax = boundsMax;
+
+	// Flat meshes have no extent along their normal
+	XMVECTOR extent = XMVectorMax(boundsMax - boundsMin, XMVectorReplicate(FLT_EPSILON));
+	triangleMesh->quantizationScale = XMVectorReplicate(TRIANGLE_MESH_QUANTIZATION_RANGE) / extent;
+
+	triangleMesh->nodes = new std::vector<ColliderTriangleMeshNode>;
+	triangleMesh->nodes->reserve(2 * numTriangles - 1);
+	buildNode(triangleMesh, entries, 0, numTriangles);
+
+	// Triangles in the order of the leaves
+	triangleMesh->indices = new std::vector<uint32_t>;
+	triangleMesh->activeEdges = new std::vector<uint8_t>;
+	triangleMesh->indices->reserve(indices.size());
+	triangleMesh->activeEdges->reserve(numTriangles);
+	for (size_t i = 0; i < numTriangles; ++i)
+	{
+		uint32_t triangle = entries[i].triangle;
+		triangleMesh->indices->push_back(indices[3 * triangle]);
+		triangleMesh->indices->push_back(indices[3 * triangle + 1]);
+		triangleMesh->indices->push_back(indices[3 * triangle + 2]);
+		triangleMesh->activeEdges->push_back(activeEdges[triangle]);
+	}
+}
+
+void DestroyColliderTriangleMesh(ColliderTriangleMesh* triangleMesh)
+{
+	delete triangleMesh->vertices;
+	delete triangleMesh->indices;
+	delete triangleMesh->activeEdges;
+	delete triangleMesh->nodes;
+}
+
+void QueryColliderTriangleMesh(const ColliderTriangleMesh* triangleMesh, FXMVECTOR localMin, FXMVECTOR localMax, PBDArenaVector<uint32_t>& triangles)
+{
+	// Quantization clamps to the bounds of the mesh, so boxes beyond them have to be rejected beforehand
+	if (false == XMVector3GreaterOrEqual(triangleMesh->boundsMax, localMin) || false == XMVector3GreaterOrEqual(localMax, triangleMesh->boundsMin))
+	{
+		return;
+	}
+
+	uint16_t queryMin[3];
+	uint16_t queryMax[3];
+	quantizeBox(triangleMesh, localMin, localMax, queryMin, queryMax);
+
+	// Stackless depth-first traversal, a subtree whose box misses the query is skipped as a whole
+	const std::vector<ColliderTriangleMeshNode>& nodes = *triangleMesh->nodes;
+	size_t i = 0;
+	while (i < nodes.size())
+	{
+		const ColliderTriangleMeshNode& node = nodes[i];
+		bool bOverlap = node.quantizedMin[0] <= queryMax[0] && queryMin[0] <= node.quantizedMax[0] &&
+			node.quantizedMin[1] <= queryMax[1] && queryMin[1] <= node.quantizedMax[1] &&
+			node.quantizedMin[2] <= queryMax[2] && queryMin[2] <= node.quantizedMax[2];
+		bool bLeaf = 0 <= node.escapeIndexOrTriangle;
+
+		if (true == bLeaf && true == bOverlap)
+		{
+			triangles.push_back(static_cast<uint32_t>(node.escapeIndexOrTriangle));
+		}
+
+		if (true == bOverlap || true == bLeaf)
+		{
+			++i;
+		}
+		else
+		{
+			i += static_cast<size_t>(-node.escapeIndexOrTriangle);
+		}
+	}
+}
+
+static void getMeshTriangle(const Collider* mesh, uint32_t triangleIndex, Collider* triangle, uint8_t* activeEdges)
+{
+	const ColliderTriangleMesh* triangleMesh = &mesh->triangleMesh;
+
+	triangle->type = ColliderType::TRIANGLE;
+	for (size_t i = 0; i < 3; ++i)
+	{
+		triangle->triangle.vertices[i] = triangleMesh->vertices->at(triangleMesh->indices->at(3 * triangleIndex + i));
+	}
+	triangle->position = mesh->position;
+	triangle->rotation = mesh->rotation;
+
+	*activeEdges = triangleMesh->activeEdges->at(triangleIndex);
+}
+
+// Edges of the triangle abc that a point of its plane lies beyond, or closer to than tolerance in barycentric weight.
+// Bit i is for the edge from vertex i to vertex i + 1, like ColliderTriangleMesh::activeEdges.
+static uint32_t getTriangleEdgeMask(FXMVECTOR point, FXMVECTOR a, FXMVECTOR b, GXMVECTOR c, float tolerance)
+{
+	XMVECTOR normal = XMVector3Cross(b - a, c - a);
+	float areaSquared = XMVectorGetX(XMVector3Dot(normal, normal));
+	if (areaSquared < FLT_EPSILON * FLT_EPSILON)
+	{
+		return 0x7;
+	}
+
+	float weightA = XMVectorGetX(XMVector3Dot(XMVector3Cross(c - b, point - b), normal)) / areaSquared;
+	float weightB = XMVectorGetX(XMVector3Dot(XMVector3Cross(a - c, point - c), normal)) / areaSquared;
+	float weightC = 1.0f - weightA - weightB;
+
+	uint32_t edges = 0;
+	if (weightC <= tolerance)
+	{
+		edges |= 0x1;
+	}
+	if (weightA <= tolerance)
+	{
+		edges |= 0x2;
+	}
+	if (weightB <= tolerance)
+	{
+		edges |= 0x4;
+	}
+
+	return edges;
+}
+
+// Closest point of the triangle abc to the point (Ericson, Real-Time Collision Detection 5.1.5)
+static XMVECTOR getClosestPointOnTriangle(FXMVECTOR point, FXMVECTOR a, FXMVECTOR b, GXMVECTOR c)
+{
+	XMVECTOR ab = b - a;
+	XMVECTOR ac = c - a;
+
+	XMVECTOR ap = point - a;
+	float d1 = XMVectorGetX(XMVector3Dot(ab, ap));
+	float d2 = XMVectorGetX(XMVector3Dot(ac, ap));
+	if (d1 <= 0.0f && d2 <= 0.0f)
+	{
+		return a;
+	}
+
+	XMVECTOR bp = point - b;
+	float d3 = XMVectorGetX(XMVector3Dot(ab, bp));
+	float d4 = XMVectorGetX(XMVector3Dot(ac, bp));
+	if (0.0f <= d3 && d4 <= d3)
+	{
+		return b;
+	}
+
+	float vc = d1 * d4 - d3 * d2;
+	if (vc <= 0.0f && 0.0f <= d1 && d3 <= 0.0f)
+	{
+		return a + (d1 / (d1 - d3)) * ab;
+	}
+
+	XMVECTOR cp = point - c;
+	float d5 = XMVectorGetX(XMVector3Dot(ab, cp));
+	float d6 = XMVectorGetX(XMVector3Dot(ac, cp));
+	if (0.0f <= d6 && d5 <= d6)
+	{
+		return c;
+	}
+
+	float vb = d5 * d2 - d1 * d6;
+	if (vb <= 0.0f && 0.0f <= d2 && d6 <= 0.0f)
+	{
+		return a + (d2 / (d2 - d6)) * ac;
+	}
+
+	float va = d3 * d6 - d5 * d4;
+	if (va <= 0.0f && 0.0f <= (d4 - d3) && 0.0f <= (d5 - d6))
+	{
+		return b + ((d4 - d3) / ((d4 - d3) + (d5 - d6))) * (c - b);
+	}
+
+	float denominator = 1.0f / (va + vb + vc);
+	return a + (vb * denominator) * ab + (vc * denominator) * ac;
+}
+
+static void getSphereTriangleContacts(Collider* sphere, Collider* triangle, uint8_t activeEdges, float speculativeDistance,
+	PBDArenaVector<ColliderContact>& contacts)
+{
+	XMVECTOR a = GetColliderWorldPoint(triangle, triangle->triangle.vertices[0]);
+	XMVECTOR b = GetColliderWorldPoint(triangle, triangle->triangle.vertices[1]);
+	XMVECTOR c = GetColliderWorldPoint(triangle, triangle->triangle.vertices[2]);
+	XMVECTOR center = sphere->sphere.center;
+
+	// A center beyond inner edges only is over a neighbor triangle, which gives the contact with its own normal
+	uint32_t edges = getTriangleEdgeMask(center, a, b, c, -TRIANGLE_MESH_EDGE_TOLERANCE);
+	if (0 != edges && 0 == (edges & activeEdges))
+	{
+		return;
+	}
+
+	XMVECTOR closestPoint = getClosestPointOnTriangle(center, a, b, c);
+	XMVECTOR difference = closestPoint - center;
+	float distanceSquared = XMVectorGetX(XMVector3LengthSq(difference));
+	float maxDistance = sphere->sphere.radius + speculativeDistance;
+	if (maxDistance * maxDistance <= distanceSquared)
+	{
+		return;
+	}
+
+	float distance = sqrtf(distanceSquared);
+	XMVECTOR normal = FLT_EPSILON < distance ? difference / distance : -getTriangleNormal(a, b, c);
+
+	ColliderContact contact;
+	contact.collision_point1 = center + sphere->sphere.radius * normal;
+	contact.collision_point2 = closestPoint;
+	contact.collision_normal = normal;
+	contact.feature_id = MakeColliderContactFeatureId(ColliderContactFeatureType::VERTEX, 0, 0, 0);
+
+	contacts.push_back(contact);
+}
+
+// Sutherland-Hodgman step keeping the part of the polygon on the side of the plane its normal points to
+static void clipPolygon(const PBDArenaVector<XMVECTOR>& polygon, FXMVECTOR planePoint, FXMVECTOR planeNormal, PBDArenaVector<XMVECTOR>& clipped)
+{
+	clipped.clear();
+
+	size_t numPoints = polygon.size();
+	if (2 == numPoints)
+	{
+		// A segment, whose closing edge would be the segment itself again
+		float distance1 = XMVectorGetX(XMVector3Dot(polygon[0] - planePoint, planeNormal));
+		float distance2 = XMVectorGetX(XMVector3Dot(polygon[1] - planePoint, planeNormal));
+		if (distance1 < 0.0f && distance2 < 0.0f)
+		{
+			return;
+		}
+
+		XMVECTOR intersection = polygon[0] + (distance1 / (distance1 - distance2)) * (polygon[1] - polygon[0]);
+		clipped.push_back(0.0f <= distance1 ? polygon[0] : intersection);
+		clipped.push_back(0.0f <= distance2 ? polygon[1] : intersection);
+		return;
+	}
+
+	for (size_t i = 0; i < numPoints; ++i)
+	{
+		XMVECTOR current = polygon[i];
+		XMVECTOR previous = polygon[(i + numPoints - 1) % numPoints];
+		float currentDistance = XMVectorGetX(XMVector3Dot(current - planePoint, planeNormal));
+		float previousDistance = XMVectorGetX(XMVector3Dot(previous - planePoint, planeNormal));
+
+		if ((currentDistance < 0.0f) != (previousDistance < 0.0f))
+		{
+			clipped.push_back(previous + (previousDistance / (previousDistance - currentDistance)) * (current - previous));
+		}
+
+		if (0.0f <= currentDistance)
+		{
+			clipped.push_back(current);
+		}
+	}
+}
+
+// Incident feature of the collider clipped by the planes through the edges of the triangle, the triangle being the reference face.
+// faceNormal is the normal of the triangle on the side of the collider. Returns false when nothing is left after clipping.
+static bool getTriangleFaceContacts(Collider* convex, const XMVECTOR* vertices, FXMVECTOR faceNormal, float speculativeDistance,
+	PBDArenaVector<ColliderContact>& contacts)
+{
+	PBDArenaVector<XMVECTOR> polygon;
+	uint32_t incidentFeature = 0;
+
+	const ColliderConvexHull* convexHull = GetColliderConvexHull(convex);
+	if (nullptr != convexHull)
+	{
+		// Face of the hull towards the triangle
+		XMVECTOR localNormal = GetColliderLocalDirection(convex, -faceNormal);
+		size_t faceIndex = 0;
+		float maxDot = -FLT_MAX;
+		for (size_t i = 0; i < convexHull->faces->size(); ++i)
+		{
+			float dot = XMVectorGetX(XMVector3Dot(convexHull->faces->at(i).normal, localNormal));
+			if (maxDot < dot)
+			{
+				faceIndex = i;
+				maxDot = dot;
+			}
+		}
+
+		const ColliderConvexHullFace* face = &convexHull->faces->at(faceIndex);
+		for (size_t i = 0; i < face->elements.size(); ++i)
+		{
+			polygon.push_back(GetColliderWorldPoint(convex, convexHull->vertices->at(face->elements[i])));
+		}
+		incidentFeature = static_cast<uint32_t>(faceIndex);
+	}
+	else if (convex->type == ColliderType::CAPSULE)
+	{
+		XMVECTOR start = GetColliderWorldPoint(convex, XMVectorSet(0.0f, -convex->capsule.halfHeight, 0.0f, 0.0f));
+		XMVECTOR end = GetColliderWorldPoint(convex, XMVectorSet(0.0f, convex->capsule.halfHeight, 0.0f, 0.0f));
+		XMVECTOR axis = GetColliderWorldDirection(convex, XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+		if (fabsf(XMVectorGetX(XMVector3Dot(axis, faceNormal))) < TRIANGLE_MESH_CAPSULE_MAX_SINE)
+		{
+			// Segment lying on the triangle, brought down to the surface of the capsule
+			polygon.push_back(start - convex->capsule.radius * faceNormal);
+			polygon.push_back(end - convex->capsule.radius * faceNormal);
+		}
+	}
+
+	if (true == polygon.empty())
+	{
+		polygon.push_back(SupportPoint(convex, -faceNormal));
+	}
+
+	PBDArenaVector<XMVECTOR> clipped;
+	for (size_t i = 0; i < 3 && false == polygon.empty(); ++i)
+	{
+		XMVECTOR edgeStart = vertices[i];
+		XMVECTOR inwardNormal = XMVector3Cross(faceNormal, vertices[(i + 1) % 3] - edgeStart);
+		if (XMVectorGetX(XMVector3Dot(vertices[(i + 2) % 3] - edgeStart, inwardNormal)) < 0.0f)
+		{
+			inwardNormal = -inwardNormal;
+		}
+
+		clipPolygon(polygon, edgeStart, inwardNormal, clipped);
+		polygon.swap(clipped);
+	}
+
+	bool bClipped = false == polygon.empty();
+	size_t firstContact = contacts.size();
+	for (size_t i = 0; i < polygon.size(); ++i)
+	{
+		float separation = XMVectorGetX(XMVector3Dot(polygon[i] - vertices[0], faceNormal));
+		if (speculativeDistance <= separation)
+		{
+			continue;
+		}
+
+		ColliderContact contact;
+		contact.collision_point1 = polygon[i];
+		contact.collision_point2 = polygon[i] - separation * faceNormal;
+		contact.collision_normal = -faceNormal;
+		contact.feature_id = MakeColliderContactFeatureId(ColliderContactFeatureType::FACE2_REFERENCE, 0, incidentFeature, static_cast<uint32_t>(i));
+
+		contacts.push_back(contact);
+	}
+
+	ReduceColliderContacts(contacts, firstContact);
+
+	return bClipped;
+}
+
+static void getConvexTriangleContacts(Collider* convex, Collider* triangle, uint8_t activeEdges, float speculativeDistance,
+	PBDArenaVector<ColliderContact>& contacts)
+{
+	XMVECTOR normal;
+	float penetration;
+
+	GJKSimplex simplex;
+	if (true == GJKCollides(convex, triangle, &simplex, nullptr))
+	{
+		if (false == EPA(convex, triangle, &simplex, &normal, &penetration))
+		{
+			return;
+		}
+	}
+	else
+	{
+		GJKDistanceResult distance;
+		if (speculativeDistance <= 0.0f || false == GJKDistance(convex, triangle, &distance) || speculativeDistance <= distance.distance)
+		{
+			return;
+		}
+
+		normal = distance.normal;
+		penetration = -distance.distance;
+	}
+
+	const XMVECTOR vertices[3] =
+	{
+		GetColliderWorldPoint(triangle, triangle->triangle.vertices[0]),
+		GetColliderWorldPoint(triangle, triangle->triangle.vertices[1]),
+		GetColliderWorldPoint(triangle, triangle->triangle.vertices[2])
+	};
+	XMVECTOR triangleNormal = getTriangleNormal(vertices[0], vertices[1], vertices[2]);
+
+	// Normal of the triangle on the side of the collider, the contact normal going from the collider to the triangle
+	XMVECTOR faceNormal = XMVectorGetX(XMVector3Dot(normal, triangleNormal)) < 0.0f ? triangleNormal : -triangleNormal;
+	XMVECTOR deepestPoint = SupportPoint(convex, normal);
+
+	bool bFace = TRIANGLE_MESH_FACE_MIN_COSINE <= -XMVectorGetX(XMVector3Dot(normal, faceNormal));
+	bool bInnerEdge = false;
+	if (false == bFace)
+	{
+		// Pushing a body out through an inner edge would catch it on the seam, the normal of the triangle is used instead
+		uint32_t edges = getTriangleEdgeMask(deepestPoint - penetration * normal, vertices[0], vertices[1], vertices[2], TRIANGLE_MESH_EDGE_TOLERANCE);
+		bInnerEdge = 0 == (edges & activeEdges);
+	}
+
+	if ((true == bFace || true == bInnerEdge) && true == getTriangleFaceContacts(convex, vertices, faceNormal, speculativeDistance, contacts))
+	{
+		return;
+	}
+
+	if (true == bInnerEdge)
+	{
+		// Nothing of the collider is over the triangle, the neighbor it is over takes care of it
+		return;
+	}
+
+	ColliderContact contact;
+	contact.collision_point1 = deepestPoint;
+	contact.collision_point2 = deepestPoint - penetration * normal;
+	contact.collision_normal = normal;
+	contact.feature_id = MakeColliderContactFeatureId(ColliderContactFeatureType::VERTEX, 0, 0, 0);
+
+	contacts.push_back(contact);
+}
+
+void GetConvexTriangleContacts(Collider* convex, Collider* triangle, uint8_t activeEdges, float speculativeDistance,
+	PBDArenaVector<ColliderContact>& contacts)
+{
+	if (convex->type == ColliderType::SPHERE)
+	{
+		getSphereTriangleContacts(convex, triangle, activeEdges, speculativeDistance, contacts);
+	}
+	else
+	{
+		getConvexTriangleContacts(convex, triangle, activeEdges, speculativeDistance, contacts);
+	}
+}
+
+void GetConvexTrianglesContacts(Collider* convex, const PBDArenaVector<uint32_t>& triangles, const ColliderTriangleCallback& getTriangle,
+	float speculativeDistance, PBDArenaVector<ColliderContact>& contacts)
+{
+	for (size_t i = 0; i < triangles.size(); ++i)
+	{
+		Collider triangle;
+		uint8_t activeEdges;
+		getTriangle(triangles[i], &triangle, &activeEdges);
+
+		size_t firstContact = contacts.size();
+		GetConvexTriangleContacts(convex, &triangle, activeEdges, speculativeDistance, contacts);
+
+		// Distinguish the contacts of different triangles
+		for (size_t j = firstContact; j < contacts.size(); ++j)
+		{
+			contacts[j].feature_id ^= triangles[i] * 0xC2B2AE3Du;
+		}
+	}
+}
+
+bool GetConvexTrianglesDistance(Collider* convex, const PBDArenaVector<uint32_t>& triangles, const ColliderTriangleCallback& getTriangle,
+	float maxDistance, GJKDistanceResult* result)
+{
+	result->distance = FLT_MAX;
+
+	for (size_t i = 0; i < triangles.size(); ++i)
+	{
+		Collider triangle;
+		uint8_t activeEdges;
+		getTriangle(triangles[i], &triangle, &activeEdges);
+
+		GJKDistanceResult distance;
+		if (false == GJKDistance(convex, &triangle, &distance))
+		{
+			return false;
+		}
+
+		if (distance.distance <= maxDistance && distance.distance < result->distance)
+		{
+			*result = distance;
+		}
+	}
+
+	return true;
+}
+
+void GetConvexTriangleMeshContacts(Collider* convex, Collider* mesh, float speculativeDistance, PBDArenaVector<ColliderContact>& contacts)
+{
+	assert(mesh->type == ColliderType::TRIANGLE_MESH);
+	assert(convex->type != ColliderType::TRIANGLE_MESH);
+
+	XMVECTOR localMin;
+	XMVECTOR localMax;
+	GetSupportBox(convex, mesh, fmaxf(speculativeDistance, 0.0f), &localMin, &localMax);
+
+	PBDArenaVector<uint32_t> triangles;
+	QueryColliderTriangleMesh(&mesh->triangleMesh, localMin, localMax, triangles);
+
+	GetConvexTrianglesContacts(convex, triangles,
+		[mesh](uint32_t triangleIndex, Collider* triangle, uint8_t* activeEdges)
+		{
+			getMeshTriangle(mesh, triangleIndex, triangle, activeEdges);
+		}, speculativeDistance, contacts);
+}
+
+bool GetConvexTriangleMeshDistance(Collider* convex, Collider* mesh, float maxDistance, GJKDistanceResult* result)
+{
+	assert(mesh->type == ColliderType::TRIANGLE_MESH);
+
+	XMVECTOR localMin;
+	XMVECTOR localMax;
+	GetSupportBox(convex, mesh, maxDistance, &localMin, &localMax);
+
+	PBDArenaVector<uint32_t> triangles;
+	QueryColliderTriangleMesh(&mesh->triangleMesh, localMin, localMax, triangles);
+
+	return GetConvexTrianglesDistance(convex, triangles,
+		[mesh](uint32_t triangleIndex, Collider* triangle, uint8_t* activeEdges)
+		{
+			getMeshTriangle(mesh, triangleIndex, triangle, activeEdges);
+		}, maxDistance, result);
+}
\ No newline at end of file
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "Collider.h"
+#include "GJK.h"
+#include <functional>
+
+// Builds the triangle of the given index of a mesh or a heightfield, with its active edges
+typedef std::function<void(uint32_t triangleIndex, Collider* triangle, uint8_t* activeEdges)> ColliderTriangleCallback;
+
+// Marks the edges on the border of the mesh and the convex creases, see ColliderTriangleMesh::activeEdges
+void ComputeTriangleMeshActiveEdges(const std::vector<XMVECTOR>& vertices, const std::vector<uint32_t>& indices, std::vector<uint8_t>* activeEdges);
+
+void BuildColliderTriangleMesh(ColliderTriangleMesh* triangleMesh, const std::vector<XMVECTOR>& vertices, const std::vector<uint32_t>& indices);
+void DestroyColliderTriangleMesh(ColliderTriangleMesh* triangleMesh);
+
+// Triangles whose box overlaps the box given in the space of the mesh, visiting only the nodes of the hierarchy that overlap it
+void QueryColliderTriangleMesh(const ColliderTriangleMesh* triangleMesh, FXMVECTOR localMin, FXMVECTOR localMax, PBDArenaVector<uint32_t>& triangles);
+
+// Contacts of a collider with a single triangle of a mesh or a heightfield, the triangle being the second collider of the contacts
+void GetConvexTriangleContacts(Collider* convex, Collider* triangle, uint8_t activeEdges, float speculativeDistance, PBDArenaVector<ColliderContact>& contacts);
+
+// Contacts and closest points of a collider with the triangles found by a query of a mesh or a heightfield, built by getTriangle.
+// Same results as GetConvexTriangleMeshContacts and GetConvexTriangleMeshDistance for the given triangles.
+void GetConvexTrianglesContacts(Collider* convex, const PBDArenaVector<uint32_t>& triangles, const ColliderTriangleCallback& getTriangle,
+	float speculativeDistance, PBDArenaVector<ColliderContact>& contacts);
+bool GetConvexTrianglesDistance(Collider* convex, const PBDArenaVector<uint32_t>& triangles, const ColliderTriangleCallback& getTriangle,
+	float maxDistance, GJKDistanceResult* result);
+
+// Contacts of a collider with the triangles of a TRIANGLE_MESH collider around it, the mesh being the second collider of the contacts
+void GetConvexTriangleMeshContacts(Collider* convex, Collider* mesh, float speculativeDistance, PBDArenaVector<ColliderContact>& contacts);
+
+// Closest points of a collider and the triangles of a mesh within maxDistance of it, result->distance is FLT_MAX when there are none.
+// Returns false when the collider overlaps the mesh.
+bool GetConvexTriangleMeshDistance(Collider* convex, Collider* mesh, float maxDistance, GJKDistanceResult* result);
\ No newline at end of file
@@ -1,5 +1,6 @@
 #include "Game/RigidBodyGame.h"
 #include "Physics/PBD.h"
+#include "Physics/PBDSelfChecks.h"
 #include "Shapes/RigidBodySphere.h"
 #include <random>
 
@@ -8,6 +9,18 @@ RigidBodyGame::RigidBodyGame(_In_ PCWSTR pszRigidBodyGameName)
 	, m_fenceEvent()
 	, m_fenceValue()
 {
+	m_world.settings.solverMode = PBDSolverMode::GRAPH_COLORED_PARALLEL;
+	m_world.settings.bEnableContactCache = true;
+	m_world.settings.bEnableIslands = true;
+	m_world.settings.bEnableSleeping = true;
+	m_world.settings.bEnableContinuousCollision = true;
+	XMStoreFloat3(&m_world.settings.gravity, GRAVITY);
+	m_world.broadphase.type = PBDBroadphaseType::DYNAMIC_AABB_TREE;
+
+#if defined(_DEBUG)
+	// Known results of the narrow phase and the solver, checked once before any scene is built
+	assert(0 == RunPBDSelfChecks());
+#endif
 }
 
 RigidBodyGame::~RigidBodyGame()
@@ -431,21 +444,13 @@ void RigidBodyGame::Update(_In_ FLOAT deltaTime)
 		if (SIZE_MAX != eraseShapeID)
 		{
 			std::shared_ptr<DX12Library::RigidBodyShape> eraseShape = m_shapes[eraseShapeID];
+			RemovePBDBodyJoints(m_world.joints, m_world.bodies, eraseShapeID);
+			RemovePBDBody(m_world.bodies, eraseShapeID);
 			m_shapes.erase(eraseShapeID);
 			eraseShape.reset();
 		}
 	}
 
-	// Add force
-	{
-		std::unordered_map<size_t, std::shared_ptr<DX12Library::RigidBodyShape>>::iterator shape;
-		for (shape = m_shapes.begin(); shape != m_shapes.end(); ++shape)
-		{
-			static XMVECTOR gravityPosition = XMVectorZero();
-			shape->second->AddForce(gravityPosition, GRAVITY / shape->second->inverseMass, false);
-		}
-	}
-
 	// PBD simulation
 	{
 		LARGE_INTEGER startSimTime;
@@ -453,7 +458,7 @@ void RigidBodyGame::Update(_In_ FLOAT deltaTime)
 		LARGE_INTEGER frequency;
 		QueryPerformanceCounter(&startSimTime);
 
-		SimulatePBD(TIMESTEP, m_shapes, SUBSTEPS, SOLVER_ITERATION, true);
+		SimulatePBD(TIMESTEP, m_world, SUBSTEPS, SOLVER_ITERATION, true);
 
 		QueryPerformanceCounter(&endSimTime);
 		QueryPerformanceFrequency(&frequency);
@@ -559,9 +564,8 @@ void RigidBodyGame::Render(void)
 
 size_t RigidBodyGame::AddShape(std::shared_ptr<DX12Library::RigidBodyShape> shape)
 {
-	static size_t id = 0;
-	shape->id = id;
+	size_t id = AddPBDBody(m_world.bodies, shape.get());
 	m_shapes.emplace(id, shape);
 
-	return id++;
+	return id;
 }
\ No newline at end of file
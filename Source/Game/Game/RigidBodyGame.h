@@ -3,6 +3,7 @@
 #include "Game/GameSample.h"
 #include <unordered_map>
 #include "Shapes/RigidBodyShape.h"
+#include "Physics/PBD.h"
 
 class RigidBodyGame final : public DX12Library::GameSample
 {
@@ -36,6 +37,7 @@ private:
 	ComPtr<ID3D12Resource> m_depthBuffer;
 	ConstantBuffer m_constantBuffer;
 	std::unordered_map<size_t, std::shared_ptr<DX12Library::RigidBodyShape>> m_shapes;
+	PBDWorld m_world;
 
 	// Synchronization objects.
 	UINT m_frameIndex = 0;
@@ -46,17 +46,7 @@ INT WINAPI wWinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance,
 		bool bIsFixed = false;
 		
 		std::vector<Collider> colliders;
-		std::vector<Vertex> vertices;
-		std::vector<WORD> indices;
-		for (size_t i = 0; i < DX12Library::RigidBodyCube::GetNumVertices(); ++i)
-		{
-			vertices.push_back(DX12Library::RigidBodyCube::GetVertices()[i]);
-		}
-		for (size_t i = 0; i < DX12Library::RigidBodyCube::GetNumIndices(); ++i)
-		{
-			indices.push_back(DX12Library::RigidBodyCube::GetIndices()[i]);
-		}
-		Collider colliderCube = CreateColliderConvexHull(vertices, indices);
+		Collider colliderCube = CreateColliderBox(XMFLOAT3(1.0f, 1.0f, 1.0f));
 		colliders.push_back(colliderCube);
 
 		std::shared_ptr<DX12Library::RigidBodyCube> cube = std::make_shared<DX12Library::RigidBodyCube>(position, rotation, scale, 1.0f,